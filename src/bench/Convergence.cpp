@@ -0,0 +1,216 @@
+#include "../run_ga/stdafx.hpp"
+
+#include "../run_ga/GeneticAlgo.hpp"
+
+namespace po = boost::program_options;
+
+//______________________________________________________________________________________________________________
+// Runs GeneticAlgo::Evolve against the synthetic objectives for a number of seeds and collects every run's
+// convergence file into one CSV, so changes to selection, crossover and mutation can be compared on how quickly they
+// reach good solutions, both in evaluations and in wall time.
+
+namespace
+{
+    struct RunSummary
+    {
+        std::string mFunction;
+        std::size_t mNumRuns;
+        double mSumBestObjective;
+        double mSumEvaluations;
+        double mSumSeconds;
+    };
+
+    //______________________________________________________________________________________________________________
+    // Trap mixes integer and categorical parameters, the others only use integers
+    void WriteConfig(const std::string& fileName, const std::string& function, std::size_t numParameters, std::size_t resolution,
+        std::size_t populationSize, std::size_t numGenerations, std::size_t seed, const std::vector<std::string>& settings)
+    {
+        std::ofstream outFile(fileName.c_str());
+        outFile <<
+            "<config>\n"
+            "  <genetic-algo>\n"
+            "    <execution-type>synthetic</execution-type>\n"
+            "    <population-size>" << populationSize << "</population-size>\n"
+            "    <num-generations>" << numGenerations << "</num-generations>\n"
+            "    <random-seed>" << seed << "</random-seed>\n";
+
+        BOOST_FOREACH(const std::string& setting, settings)
+        {
+            std::size_t equals = setting.find('=');
+            if (equals != std::string::npos)
+            {
+                std::string name(setting.substr(0, equals));
+                outFile << "    <" << name << ">" << CommonLib::EscapeXML(setting.substr(equals + 1)) << "</" << name << ">\n";
+            }
+        }
+
+        for (std::size_t i = 0; i < numParameters; ++i)
+        {
+            if (boost::iequals(function, "trap") && (i % 2) == 1)
+            {
+                outFile << "    <parameter id=\"x" << i << "\" type=\"categorical\" values=\"a,b,c,d\" />\n";
+            }
+            else if (boost::iequals(function, "trap"))
+            {
+                outFile << "    <parameter id=\"x" << i << "\" type=\"integer\" low=\"0\" high=\"9\" step=\"1\" />\n";
+            }
+            else
+            {
+                outFile << "    <parameter id=\"x" << i << "\" type=\"integer\" low=\"0\" high=\"" << resolution << "\" step=\"1\" />\n";
+            }
+        }
+
+        outFile <<
+            "  </genetic-algo>\n"
+            "  <synthetic>\n"
+            "    <function>" << function << "</function>\n"
+            "    <convergence-file>convergence.csv</convergence-file>\n"
+            "  </synthetic>\n"
+            "</config>\n";
+    }
+
+    //______________________________________________________________________________________________________________
+    // Copies the run's convergence file to the output with the function and seed in front of every row, and returns
+    // the last row
+    std::vector<std::string> AppendConvergence(const std::string& fileName, const std::string& function, std::size_t seed, std::ostream& out)
+    {
+        std::ifstream inFile(fileName.c_str());
+        std::string line;
+        std::string lastLine;
+        // header
+        std::getline(inFile, line);
+        while (std::getline(inFile, line))
+        {
+            if (!line.empty())
+            {
+                out << function << "," << seed << "," << line << "\n";
+                lastLine = line;
+            }
+        }
+
+        std::vector<std::string> fields;
+        boost::split(fields, lastLine, boost::is_any_of(","));
+        return fields;
+    }
+}
+
+//______________________________________________________________________________________________________________
+
+int main(int argc, char* argv[])
+{
+    po::options_description desc("gridga_convergence options");
+    desc.add_options()
+        ("help", "Show this message")
+        ("functions", po::value<std::vector<std::string> >()->multitoken(), "rastrigin, rosenbrock, ackley and/or trap (default all of them)")
+        ("seeds", po::value<std::size_t>()->default_value(5), "Number of runs of each function")
+        ("first-seed", po::value<std::size_t>()->default_value(1), "Random seed of the first run, incremented for each run after it")
+        ("parameters", po::value<std::size_t>()->default_value(10), "Number of parameters")
+        ("resolution", po::value<std::size_t>()->default_value(1000), "Number of steps across each integer parameter's range")
+        ("population-size", po::value<std::size_t>()->default_value(50), "Population size")
+        ("generations", po::value<std::size_t>()->default_value(50), "Number of generations")
+        ("set", po::value<std::vector<std::string> >()->multitoken(), "Any other genetic-algo setting, e.g. --set mutation-probability=10")
+        ("output", po::value<std::string>()->default_value("convergence.csv"), "CSV of best-so-far against evaluations and wall time")
+        ("work-dir", po::value<std::string>()->default_value("gridga_convergence.tmp"), "Where each run's files are written");
+
+    po::variables_map variablesMap;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, desc), variablesMap);
+        po::notify(variablesMap);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl << desc << std::endl;
+        return 1;
+    }
+
+    if (variablesMap.count("help"))
+    {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+
+    std::vector<std::string> functions;
+    if (variablesMap.count("functions"))
+    {
+        functions = variablesMap["functions"].as<std::vector<std::string> >();
+    }
+    else
+    {
+        functions.push_back("rastrigin");
+        functions.push_back("rosenbrock");
+        functions.push_back("ackley");
+        functions.push_back("trap");
+    }
+    std::vector<std::string> settings;
+    if (variablesMap.count("set"))
+    {
+        settings = variablesMap["set"].as<std::vector<std::string> >();
+    }
+
+    std::string workDir(variablesMap["work-dir"].as<std::string>());
+    boost::filesystem::remove_all(workDir);
+    boost::filesystem::create_directories(workDir);
+    Logger::Initialise(workDir + "/convergence.log");
+    // the runs share this log, and logging every genome at spam would swamp the timings
+    Logger::SetLevel("warning");
+    Logger::StartAsync();
+
+    std::ofstream outFile(variablesMap["output"].as<std::string>().c_str());
+    outFile << "function,seed,evaluation,generation,genome_id,objective,best_objective,elapsed_seconds\n";
+
+    std::size_t numSeeds = variablesMap["seeds"].as<std::size_t>();
+    std::size_t firstSeed = variablesMap["first-seed"].as<std::size_t>();
+    // the GA needs at least 2 parameters to cross them
+    std::size_t numParameters = std::max<std::size_t>(variablesMap["parameters"].as<std::size_t>(), 2);
+
+    zmq::context_t zmqContext(1);
+    std::vector<RunSummary> summaries;
+    BOOST_FOREACH(const std::string& function, functions)
+    {
+        if (GridGALib::SyntheticObjective::FromString(function) == GridGALib::SYNTHETIC_UNKNOWN)
+        {
+            std::cerr << "Unknown function " << function << std::endl;
+            return 1;
+        }
+
+        RunSummary summary = { function, 0, 0.0, 0.0, 0.0 };
+        for (std::size_t seed = firstSeed; seed < firstSeed + numSeeds; ++seed)
+        {
+            std::string runDir(workDir + "/" + function + "-" + CommonLib::SomethingToString(seed));
+            boost::filesystem::create_directories(runDir);
+            WriteConfig(runDir + "/config.xml", function, numParameters, variablesMap["resolution"].as<std::size_t>(),
+                variablesMap["population-size"].as<std::size_t>(), variablesMap["generations"].as<std::size_t>(), seed, settings);
+
+            {
+                GridGALib::GeneticAlgo geneticAlgo(runDir, zmqContext);
+                if (!geneticAlgo.ReadConfig())
+                {
+                    std::cerr << "Cannot read the config in " << runDir << std::endl;
+                    return 1;
+                }
+                geneticAlgo.Evolve();
+            }
+
+            std::vector<std::string> last(AppendConvergence(runDir + "/convergence.csv", function, seed, outFile));
+            if (last.size() == 6)
+            {
+                ++summary.mNumRuns;
+                summary.mSumEvaluations += CommonLib::StringToDouble(last[0]);
+                summary.mSumBestObjective += CommonLib::StringToDouble(last[4]);
+                summary.mSumSeconds += CommonLib::StringToDouble(last[5]);
+            }
+        }
+        summaries.push_back(summary);
+    }
+    outFile.close();
+
+    std::cerr << "function,runs,mean_best_objective,mean_evaluations,mean_seconds" << std::endl;
+    BOOST_FOREACH(const RunSummary& summary, summaries)
+    {
+        double numRuns = static_cast<double>(std::max<std::size_t>(summary.mNumRuns, 1));
+        std::cerr << summary.mFunction << "," << summary.mNumRuns << "," << summary.mSumBestObjective / numRuns << "," <<
+            summary.mSumEvaluations / numRuns << "," << summary.mSumSeconds / numRuns << std::endl;
+    }
+    return 0;
+}
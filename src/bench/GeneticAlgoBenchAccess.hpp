@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../run_ga/GeneticAlgo.hpp"
+
+namespace GridGALib
+{
+    // The GA's private operations that gridga_bench times, outside of Evolve and on a cache the bench fills itself.
+    // GeneticAlgo befriends this class and nothing else, so the bench reaches no further than what's listed here.
+    class GeneticAlgoBenchAccess
+    {
+    public:
+        // the same settings as the example config, without reading a config or creating an executor
+        static void SetUp(GeneticAlgo& geneticAlgo, GAParameterMapPtr parameters)
+        {
+            geneticAlgo.mPopulationSize = 100;
+            geneticAlgo.mMutationProbability = 20;
+            geneticAlgo.mNumBreedersPercent = 0.5;
+            geneticAlgo.mMinNumBreeders = 50;
+            geneticAlgo.mNumNewRandomGenomes = 2;
+            geneticAlgo.mNumGenerations = 5;
+            geneticAlgo.mGenerationNumber = 1;
+            geneticAlgo.mCacheFile = geneticAlgo.mFilesLocation + "/genetic-algo-cache.xml";
+            geneticAlgo.mCross = boost::bind(&GeneticAlgo::CrossBySlicing, &geneticAlgo, _1, _2, _3, _4);
+            geneticAlgo.mParameterMap = parameters;
+        }
+
+        static GenomeList GetGenomeCache(GeneticAlgo& geneticAlgo)
+        {
+            return geneticAlgo.mGenomeCache;
+        }
+
+        static GenomePtr CreateRandomGenome(GeneticAlgo& geneticAlgo)
+        {
+            return geneticAlgo.CreateRandomGenome();
+        }
+
+        static void Cross(GeneticAlgo& geneticAlgo, bool bySlicing, const GenomePtr parent1, const GenomePtr parent2,
+            GenomePtr child1, GenomePtr child2)
+        {
+            if (bySlicing)
+            {
+                geneticAlgo.CrossBySlicing(parent1, parent2, child1, child2);
+            }
+            else
+            {
+                geneticAlgo.CrossBySwap(parent1, parent2, child1, child2);
+            }
+        }
+
+        static bool AddGenomeToPopulation(GeneticAlgo& geneticAlgo, GenomeList genomesToTest, GenomePtr genome)
+        {
+            return geneticAlgo.AddGenomeToPopulation(genomesToTest, genome);
+        }
+
+        static void NextGeneration(GeneticAlgo& geneticAlgo)
+        {
+            geneticAlgo.NextGeneration();
+        }
+
+        static void SortPopulation(GeneticAlgo& geneticAlgo)
+        {
+            geneticAlgo.SortPopulation();
+        }
+
+        static void StoreState(GeneticAlgo& geneticAlgo)
+        {
+            geneticAlgo.StoreState();
+        }
+
+        static void RestoreState(GeneticAlgo& geneticAlgo)
+        {
+            geneticAlgo.RestoreState();
+            geneticAlgo.mGenerationNumber = 1;
+        }
+    };
+}
@@ -0,0 +1,356 @@
+#include "../run_ga/stdafx.hpp"
+
+#include "../run_ga/ResultsReceiver.hpp"
+#include "../run_ga/ResultTransmit.hpp"
+
+#include <boost/random/exponential_distribution.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/thread/barrier.hpp>
+
+namespace po = boost::program_options;
+
+//______________________________________________________________________________________________________________
+// Plays the part of thousands of htcondor_job_wrapper processes sending their results to run_ga at once, using the
+// wrapper's own TransmitToGAServer, so the results receiver can be loaded up to and past the point where wrappers
+// start timing out and resending. Each client is a thread with its own REQ socket per attempt, as each wrapper is a
+// process.
+//
+// Arrival patterns:
+//   sync     every client sends one result at the same moment, and the next round starts once they have all been
+//            acknowledged, as at the end of a generation where every job finishes together
+//   burst    --burst-size results every --burst-interval-ms, whether or not the previous burst has been acknowledged
+//   poisson  results arrive independently at --rate a second
+
+namespace
+{
+    enum ArrivalPattern
+    {
+        ARRIVAL_SYNC,
+        ARRIVAL_BURST,
+        ARRIVAL_POISSON
+    };
+
+    struct Send
+    {
+        boost::uint64_t mGenomeID;
+        // milliseconds from the start of the run
+        double mScheduledMs;
+        double mSentMs;
+        double mAckedMs;
+        std::size_t mNumAttempts;
+        bool mSentOk;
+    };
+
+    struct LoadSettings
+    {
+        std::string mServer;
+        ArrivalPattern mPattern;
+        bool mBinary;
+        std::size_t mMaxAttempts;
+        long mTimeoutMilliseconds;
+        std::size_t mNumClients;
+    };
+
+    boost::posix_time::ptime startTime;
+
+    //______________________________________________________________________________________________________________
+
+    double MillisecondsSinceStart(void)
+    {
+        return (boost::posix_time::microsec_clock::universal_time() - startTime).total_microseconds() / 1000.0;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void SleepUntil(double milliseconds)
+    {
+        double wait = milliseconds - MillisecondsSinceStart();
+        if (wait > 0.0)
+        {
+            boost::this_thread::sleep(boost::posix_time::microseconds(static_cast<boost::int64_t>(wait * 1000.0)));
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // The same message the wrapper would send for this genome, in the format run_ga asked for
+
+    std::string MakeMessage(boost::uint64_t genomeID, bool binary)
+    {
+        GridGALib::ResultMessage result;
+        result.Clear();
+        result.mGenomeID = genomeID;
+        result.mNumObjectives = 1;
+        result.mObjectives[0] = static_cast<double>(genomeID % 1000) / 10.0;
+        result.SetHost("gridga_loadgen", 14);
+        if (binary)
+        {
+            char buffer[GridGALib::RESULT_MESSAGE_MAX_SIZE];
+            std::size_t length = GridGALib::SerialiseResultMessage(result, buffer, sizeof(buffer));
+            return std::string(buffer, length);
+        }
+        return GridGALib::FormatResultXML(result);
+    }
+
+    //______________________________________________________________________________________________________________
+    // Sends sends[i] for every i == client (mod numClients). With the sync pattern every client waits at the barrier
+    // after each send, so a round only starts once the slowest client of the previous one has been acknowledged.
+
+    void ClientLoop(zmq::context_t* zmqContext, const LoadSettings* settings, std::vector<Send>* sends, boost::barrier* roundBarrier,
+        std::size_t client)
+    {
+        std::size_t numRounds = (sends->size() + settings->mNumClients - 1) / settings->mNumClients;
+        for (std::size_t round = 0; round < numRounds; ++round)
+        {
+            std::size_t i = (round * settings->mNumClients) + client;
+            if (i < sends->size())
+            {
+                Send& send = (*sends)[i];
+                std::string message(MakeMessage(send.mGenomeID, settings->mBinary));
+                if (settings->mPattern == ARRIVAL_SYNC)
+                {
+                    send.mScheduledMs = MillisecondsSinceStart();
+                }
+                else
+                {
+                    SleepUntil(send.mScheduledMs);
+                }
+                send.mSentMs = MillisecondsSinceStart();
+                GridGALib::TransmitOutcome outcome = GridGALib::TransmitToGAServer(*zmqContext, message, settings->mServer,
+                    settings->mMaxAttempts, settings->mTimeoutMilliseconds, false);
+                send.mAckedMs = MillisecondsSinceStart();
+                send.mNumAttempts = outcome.mNumAttempts;
+                send.mSentOk = outcome.mSentOk;
+            }
+            if (settings->mPattern == ARRIVAL_SYNC)
+            {
+                roundBarrier->wait();
+            }
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // Stands in for run_ga when there isn't one to load, and counts what arrives
+
+    void DrainLoop(GridGALib::ResultsReceiver* receiver, boost::atomic<bool>* running, std::map<boost::uint64_t, std::size_t>* received)
+    {
+        GridGALib::ResultMessage result;
+        while (running->load())
+        {
+            while (receiver->Pop(result))
+            {
+                ++(*received)[result.mGenomeID];
+            }
+            receiver->WaitForResults(100);
+        }
+        while (receiver->Pop(result))
+        {
+            ++(*received)[result.mGenomeID];
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    double Percentile(const std::vector<double>& sorted, double percent)
+    {
+        if (sorted.empty())
+        {
+            return 0.0;
+        }
+        std::size_t index = static_cast<std::size_t>(std::ceil(percent / 100.0 * sorted.size()));
+        return sorted[std::min(std::max<std::size_t>(index, 1), sorted.size()) - 1];
+    }
+}
+
+//______________________________________________________________________________________________________________
+
+int main(int argc, char* argv[])
+{
+    po::options_description desc("gridga_loadgen options");
+    desc.add_options()
+        ("help", "Show this message")
+        ("server", po::value<std::string>()->default_value("tcp://localhost:55566"), "run_ga's results endpoint")
+        ("clients", po::value<std::size_t>()->default_value(1000), "Number of concurrent wrappers")
+        ("results", po::value<std::size_t>()->default_value(10000), "Number of results to send")
+        ("pattern", po::value<std::string>()->default_value("sync"), "sync, burst or poisson")
+        ("rate", po::value<double>()->default_value(1000.0), "Results a second for poisson")
+        ("burst-size", po::value<std::size_t>()->default_value(500), "Results in each burst")
+        ("burst-interval-ms", po::value<double>()->default_value(1000.0), "Time between the start of each burst")
+        ("attempts", po::value<std::size_t>()->default_value(GridGALib::RESULT_TRANSMIT_MAX_ATTEMPTS), "Sends before a result is dropped")
+        ("timeout-ms", po::value<long>()->default_value(GridGALib::RESULT_TRANSMIT_TIMEOUT_MILLISECONDS), "Time to wait for each acknowledgement")
+        ("format", po::value<std::string>()->default_value("binary"), "binary or xml")
+        ("first-genome-id", po::value<boost::uint64_t>()->default_value(1), "Genome id of the first result")
+        ("seed", po::value<boost::uint32_t>()->default_value(1), "Random seed for poisson arrivals")
+        ("io-threads", po::value<int>()->default_value(1), "ZeroMQ I/O threads")
+        ("receiver-threads", po::value<std::size_t>()->default_value(0), "Run a results receiver in this process with this many workers, "
+            "listening on --port, instead of sending to run_ga")
+        ("port", po::value<boost::int32_t>()->default_value(55566), "Port of the results receiver run by --receiver-threads")
+        ("output", po::value<std::string>()->default_value(""), "CSV of every result's timings");
+
+    po::variables_map variablesMap;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, desc), variablesMap);
+        po::notify(variablesMap);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl << desc << std::endl;
+        return 1;
+    }
+
+    if (variablesMap.count("help"))
+    {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+
+    LoadSettings settings;
+    settings.mServer = variablesMap["server"].as<std::string>();
+    settings.mBinary = !boost::iequals(variablesMap["format"].as<std::string>(), "xml");
+    settings.mMaxAttempts = std::max<std::size_t>(variablesMap["attempts"].as<std::size_t>(), 1);
+    settings.mTimeoutMilliseconds = variablesMap["timeout-ms"].as<long>();
+    settings.mNumClients = std::max<std::size_t>(variablesMap["clients"].as<std::size_t>(), 1);
+
+    std::string pattern(variablesMap["pattern"].as<std::string>());
+    if (boost::iequals(pattern, "sync"))
+    {
+        settings.mPattern = ARRIVAL_SYNC;
+    }
+    else if (boost::iequals(pattern, "burst"))
+    {
+        settings.mPattern = ARRIVAL_BURST;
+    }
+    else if (boost::iequals(pattern, "poisson"))
+    {
+        settings.mPattern = ARRIVAL_POISSON;
+    }
+    else
+    {
+        std::cerr << "Unknown arrival pattern " << pattern << std::endl;
+        return 1;
+    }
+
+    // the schedule is worked out up front so every pattern sends the same results, only at different times
+    std::size_t numResults = variablesMap["results"].as<std::size_t>();
+    boost::uint64_t firstGenomeID = variablesMap["first-genome-id"].as<boost::uint64_t>();
+    std::size_t burstSize = std::max<std::size_t>(variablesMap["burst-size"].as<std::size_t>(), 1);
+    double burstIntervalMs = variablesMap["burst-interval-ms"].as<double>();
+    boost::random::mt19937 random(variablesMap["seed"].as<boost::uint32_t>());
+    boost::random::exponential_distribution<double> interArrival(std::max(variablesMap["rate"].as<double>(), 0.001) / 1000.0);
+    double arrivalMs = 0.0;
+    std::vector<Send> sends(numResults);
+    for (std::size_t i = 0; i < numResults; ++i)
+    {
+        Send& send = sends[i];
+        send.mGenomeID = firstGenomeID + i;
+        send.mScheduledMs = 0.0;
+        send.mSentMs = 0.0;
+        send.mAckedMs = 0.0;
+        send.mNumAttempts = 0;
+        send.mSentOk = false;
+        if (settings.mPattern == ARRIVAL_BURST)
+        {
+            send.mScheduledMs = (i / burstSize) * burstIntervalMs;
+        }
+        else if (settings.mPattern == ARRIVAL_POISSON)
+        {
+            arrivalMs += interArrival(random);
+            send.mScheduledMs = arrivalMs;
+        }
+    }
+
+    // every client can have a socket open at once, plus the receiver's own
+    zmq::context_t zmqContext(variablesMap["io-threads"].as<int>(), static_cast<int>(settings.mNumClients + 64));
+
+    boost::scoped_ptr<GridGALib::ResultsReceiver> receiver;
+    boost::atomic<bool> draining(true);
+    std::map<boost::uint64_t, std::size_t> received;
+    boost::thread drainThread;
+    std::size_t numReceiverThreads = variablesMap["receiver-threads"].as<std::size_t>();
+    if (numReceiverThreads > 0)
+    {
+        Logger::Initialise("gridga_loadgen.log");
+        receiver.reset(new GridGALib::ResultsReceiver(zmqContext, variablesMap["port"].as<boost::int32_t>(), numReceiverThreads));
+        if (!receiver->Start())
+        {
+            std::cerr << "Cannot start the results receiver on port " << variablesMap["port"].as<boost::int32_t>() << std::endl;
+            return 1;
+        }
+        drainThread = boost::thread(boost::bind(&DrainLoop, receiver.get(), &draining, &received));
+    }
+
+    std::cerr << "Sending " << numResults << " results from " << settings.mNumClients << " clients to " << settings.mServer <<
+        " (" << pattern << ")" << std::endl;
+
+    boost::barrier roundBarrier(static_cast<unsigned int>(settings.mNumClients));
+    // thousands of threads, so keep their stacks small
+    boost::thread::attributes attributes;
+    attributes.set_stack_size(256 * 1024);
+    std::vector<boost::shared_ptr<boost::thread> > clients;
+    startTime = boost::posix_time::microsec_clock::universal_time();
+    for (std::size_t client = 0; client < settings.mNumClients; ++client)
+    {
+        clients.push_back(boost::make_shared<boost::thread>(attributes,
+            boost::bind(&ClientLoop, &zmqContext, &settings, &sends, &roundBarrier, client)));
+    }
+    BOOST_FOREACH(boost::shared_ptr<boost::thread> client, clients)
+    {
+        client->join();
+    }
+    double elapsedMs = MillisecondsSinceStart();
+
+    if (receiver)
+    {
+        draining = false;
+        drainThread.join();
+        receiver->Stop();
+    }
+
+    std::size_t numAcked = 0;
+    std::size_t numRetries = 0;
+    std::vector<double> latencies;
+    latencies.reserve(numResults);
+    BOOST_FOREACH(const Send& send, sends)
+    {
+        numRetries += send.mNumAttempts - 1;
+        if (send.mSentOk)
+        {
+            ++numAcked;
+            // from when the result was due, so time spent waiting for a client counts
+            latencies.push_back(send.mAckedMs - send.mScheduledMs);
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::string outputFile(variablesMap["output"].as<std::string>());
+    if (!outputFile.empty())
+    {
+        std::ofstream outFile(outputFile.c_str());
+        outFile << "genome_id,scheduled_ms,sent_ms,acked_ms,latency_ms,attempts,ok\n";
+        BOOST_FOREACH(const Send& send, sends)
+        {
+            outFile << send.mGenomeID << "," << send.mScheduledMs << "," << send.mSentMs << "," << send.mAckedMs << "," <<
+                (send.mAckedMs - send.mScheduledMs) << "," << send.mNumAttempts << "," << (send.mSentOk ? 1 : 0) << "\n";
+        }
+    }
+
+    std::cerr << "sent,acked,dropped,retries,elapsed_seconds,acked_per_second,p50_ms,p90_ms,p99_ms,max_ms" << std::endl;
+    std::cerr << numResults << "," << numAcked << "," << (numResults - numAcked) << "," << numRetries << "," << elapsedMs / 1000.0 << "," <<
+        (elapsedMs > 0.0 ? numAcked / (elapsedMs / 1000.0) : 0.0) << "," << Percentile(latencies, 50.0) << "," <<
+        Percentile(latencies, 90.0) << "," << Percentile(latencies, 99.0) << "," << Percentile(latencies, 100.0) << std::endl;
+
+    if (receiver)
+    {
+        // a resend after an acknowledgement that arrived too late is received twice
+        std::size_t numDuplicates = 0;
+        typedef std::map<boost::uint64_t, std::size_t>::value_type ReceivedCount;
+        BOOST_FOREACH(const ReceivedCount& count, received)
+        {
+            numDuplicates += count.second - 1;
+        }
+        std::cerr << "received,duplicates" << std::endl;
+        std::cerr << received.size() << "," << numDuplicates << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,504 @@
+#include "../run_ga/stdafx.hpp"
+
+#include "../run_ga/GeneticAlgo.hpp"
+#include "GeneticAlgoBenchAccess.hpp"
+#include "../run_ga/GenerateXMLConfig.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <iomanip>
+#include <new>
+
+namespace po = boost::program_options;
+
+//______________________________________________________________________________________________________________
+// Every allocation in the process is counted so a benchmark can report allocations per operation
+
+namespace
+{
+    boost::atomic<boost::uint64_t> gNumAllocations(0);
+}
+
+void* operator new(std::size_t size)
+{
+    ++gNumAllocations;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+//______________________________________________________________________________________________________________
+
+namespace GridGALib
+{
+    struct BenchResult
+    {
+        std::string mName;
+        std::size_t mNumGenomes;
+        std::size_t mNumParameters;
+        std::size_t mIterations;
+        double mNsPerOp;
+        double mAllocationsPerOp;
+        boost::uint64_t mPeakRSSKb;
+    };
+
+    typedef boost::function<void (void)> BenchFunc;
+
+    // Runs the operations of GeneticAlgo, Genome and GenerateXMLConfig on a synthetic population, outside of HTCondor
+	class GeneticAlgoBench : boost::noncopyable
+    {
+    public:
+        GeneticAlgoBench(std::size_t numGenomes, std::size_t numParameters, std::size_t iterations, const std::string& workDir);
+        void Run(const std::string& filter, std::vector<BenchResult>& results);
+    private:
+        zmq::context_t mZmqContext;
+        GeneticAlgo mGeneticAlgo;
+        std::size_t mNumGenomes;
+        std::size_t mNumParameters;
+        std::size_t mIterations;
+        std::string mWorkDir;
+        GenerateXMLConfig mGenerateXMLConfig;
+
+        void FillCache(void);
+        GenomePtr CreateCompleteGenome(void);
+        void WriteConfigTemplate(const std::string& fileName) const;
+        BenchResult Measure(const std::string& name, std::size_t iterations, BenchFunc setup, BenchFunc operation);
+
+        void AddGenomeToPopulation(void);
+        void Cross(bool bySlicing);
+        void Mutate(void);
+        void NextGeneration(void);
+        void RestoreState(void);
+        void Shuffle(void);
+    };
+
+    //______________________________________________________________________________________________________________
+
+    boost::uint64_t GetPeakRSSKb(void)
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return static_cast<boost::uint64_t>(counters.PeakWorkingSetSize / 1024);
+#else
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        // bytes on OS X
+        return static_cast<boost::uint64_t>(usage.ru_maxrss / 1024);
+#else
+        return static_cast<boost::uint64_t>(usage.ru_maxrss);
+#endif
+#endif
+    }
+
+    //______________________________________________________________________________________________________________
+
+    GeneticAlgoBench::GeneticAlgoBench(std::size_t numGenomes, std::size_t numParameters, std::size_t iterations, const std::string& workDir)
+    :
+        mZmqContext(1),
+        mGeneticAlgo(workDir, mZmqContext),
+        mNumGenomes(numGenomes),
+        mNumParameters(numParameters),
+        mIterations(iterations),
+        mWorkDir(workDir)
+    {
+        GAParameterMapPtr parameterMap(boost::make_shared<GAParameterMap>());
+        for (std::size_t i = 0; i < mNumParameters; ++i)
+        {
+            std::string id("p" + CommonLib::SomethingToString(i));
+            (*parameterMap)[id] = boost::make_shared<GenomeParameterContinuous>(id, 0, 1000, 1);
+        }
+        GeneticAlgoBenchAccess::SetUp(mGeneticAlgo, parameterMap);
+
+        FillCache();
+
+        std::string templateFileName(mWorkDir + "/bench_template.xml");
+        WriteConfigTemplate(templateFileName);
+        mGenerateXMLConfig.Compile(templateFileName, "xml", parameterMap);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    GenomePtr GeneticAlgoBench::CreateCompleteGenome(void)
+    {
+        GenomePtr genome(GeneticAlgoBenchAccess::CreateRandomGenome(mGeneticAlgo));
+        ResultMessage result;
+        result.Clear();
+        result.mNumObjectives = 1;
+        result.mObjectives[0] = (rand() % 100000) / 1000.0;
+        result.mExecuteMs = 1000;
+        result.SetHost("bench", 5);
+        genome->Update(result);
+        return genome;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GeneticAlgoBench::FillCache(void)
+    {
+        GenomeList cache(GeneticAlgoBenchAccess::GetGenomeCache(mGeneticAlgo));
+        cache->clear();
+        for (std::size_t i = 0; i < mNumGenomes; ++i)
+        {
+            cache->push_back(CreateCompleteGenome());
+        }
+        GeneticAlgoBenchAccess::SortPopulation(mGeneticAlgo);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GeneticAlgoBench::WriteConfigTemplate(const std::string& fileName) const
+    {
+        std::ofstream outFile(fileName.c_str());
+        outFile << "<config>\n  <model>\n";
+        for (std::size_t i = 0; i < mNumParameters; ++i)
+        {
+            outFile << "    <value-" << i << " ga-subst=\"p" << i << "\">0</value-" << i << ">\n";
+        }
+        outFile << "  </model>\n  <genetic-algo>\n    <executable>bench</executable>\n  </genetic-algo>\n</config>\n";
+    }
+
+    //______________________________________________________________________________________________________________
+    // setup runs before every iteration and isn't timed
+    BenchResult GeneticAlgoBench::Measure(const std::string& name, std::size_t iterations, BenchFunc setup, BenchFunc operation)
+    {
+        boost::int64_t elapsedNs = 0;
+        boost::uint64_t numAllocations = 0;
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            if (setup)
+            {
+                setup();
+            }
+            boost::uint64_t allocationsBefore = gNumAllocations;
+            std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+            operation();
+            elapsedNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            numAllocations += gNumAllocations - allocationsBefore;
+        }
+
+        BenchResult result;
+        result.mName = name;
+        result.mNumGenomes = mNumGenomes;
+        result.mNumParameters = mNumParameters;
+        result.mIterations = iterations;
+        result.mNsPerOp = static_cast<double>(elapsedNs) / iterations;
+        result.mAllocationsPerOp = static_cast<double>(numAllocations) / iterations;
+        result.mPeakRSSKb = GetPeakRSSKb();
+        return result;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GeneticAlgoBench::AddGenomeToPopulation(void)
+    {
+        GenomeList genomesToTest = boost::make_shared<std::deque<GenomePtr> >();
+        GeneticAlgoBenchAccess::AddGenomeToPopulation(mGeneticAlgo, genomesToTest, GeneticAlgoBenchAccess::CreateRandomGenome(mGeneticAlgo));
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GeneticAlgoBench::Cross(bool bySlicing)
+    {
+        GenomeList cache(GeneticAlgoBenchAccess::GetGenomeCache(mGeneticAlgo));
+        GenomePtr parent1 = cache->at(rand() % cache->size());
+        GenomePtr parent2 = cache->at(rand() % cache->size());
+        GenomePtr child1 = GeneticAlgoBenchAccess::CreateRandomGenome(mGeneticAlgo);
+        GenomePtr child2 = GeneticAlgoBenchAccess::CreateRandomGenome(mGeneticAlgo);
+        GeneticAlgoBenchAccess::Cross(mGeneticAlgo, bySlicing, parent1, parent2, child1, child2);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GeneticAlgoBench::Mutate(void)
+    {
+        GenomeList cache(GeneticAlgoBenchAccess::GetGenomeCache(mGeneticAlgo));
+        // 100 makes every call mutate
+        cache->at(rand() % cache->size())->Mutate(100);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GeneticAlgoBench::NextGeneration(void)
+    {
+        GeneticAlgoBenchAccess::NextGeneration(mGeneticAlgo);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GeneticAlgoBench::RestoreState(void)
+    {
+        GeneticAlgoBenchAccess::RestoreState(mGeneticAlgo);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GeneticAlgoBench::Shuffle(void)
+    {
+        GenomeList cache(GeneticAlgoBenchAccess::GetGenomeCache(mGeneticAlgo));
+        std::random_shuffle(cache->begin(), cache->end());
+    }
+
+    //______________________________________________________________________________________________________________
+    // The whole-population operations get fewer iterations, at most one per 10k genomes of the requested count
+    void GeneticAlgoBench::Run(const std::string& filter, std::vector<BenchResult>& results)
+    {
+        std::size_t populationIterations = std::max<std::size_t>(1, std::min(mIterations, (mIterations * 10000) / std::max<std::size_t>(mNumGenomes, 1)));
+        std::size_t configIterations = std::min<std::size_t>(mIterations, 1000);
+        GenomePtr genome(GeneticAlgoBenchAccess::GetGenomeCache(mGeneticAlgo)->front());
+        std::string configDir(mWorkDir);
+
+        struct Benchmark
+        {
+            const char* mName;
+            std::size_t mIterations;
+            BenchFunc mSetup;
+            BenchFunc mOperation;
+        };
+
+        Benchmark benchmarks[] =
+        {
+            { "AddGenomeToPopulation", populationIterations, BenchFunc(), boost::bind(&GeneticAlgoBench::AddGenomeToPopulation, this) },
+            { "CrossBySlicing", mIterations, BenchFunc(), boost::bind(&GeneticAlgoBench::Cross, this, true) },
+            { "CrossBySwap", mIterations, BenchFunc(), boost::bind(&GeneticAlgoBench::Cross, this, false) },
+            { "Mutate", mIterations, BenchFunc(), boost::bind(&GeneticAlgoBench::Mutate, this) },
+            { "NextGeneration", populationIterations, BenchFunc(), boost::bind(&GeneticAlgoBench::NextGeneration, this) },
+            { "SortPopulation", populationIterations, boost::bind(&GeneticAlgoBench::Shuffle, this), boost::bind(&GeneticAlgoBenchAccess::SortPopulation, boost::ref(mGeneticAlgo)) },
+            { "StoreState", populationIterations, BenchFunc(), boost::bind(&GeneticAlgoBenchAccess::StoreState, boost::ref(mGeneticAlgo)) },
+            { "RestoreState", populationIterations, BenchFunc(), boost::bind(&GeneticAlgoBench::RestoreState, this) },
+            { "GetConfigForGA", configIterations, BenchFunc(), boost::bind(&GenerateXMLConfig::GetConfigForGA, &mGenerateXMLConfig, genome, configDir) }
+        };
+
+        BOOST_FOREACH(const Benchmark& benchmark, benchmarks)
+        {
+            if (filter.empty() || std::string(benchmark.mName).find(filter) != std::string::npos)
+            {
+                results.push_back(Measure(benchmark.mName, benchmark.mIterations, benchmark.mSetup, benchmark.mOperation));
+            }
+        }
+    }
+}
+
+//______________________________________________________________________________________________________________
+// Each genome and parameter count is run in a child process, so its peak RSS is its own rather than the largest of
+// every count run before it. The child sends its results back down a pipe, one per line. Windows has no fork, so
+// there they're run in this process and the peak RSS is the process's.
+bool RunConfig(std::size_t numGenomes, std::size_t numParameters, std::size_t iterations, const std::string& filter,
+    const std::string& workDir, std::vector<GridGALib::BenchResult>& results)
+{
+#ifdef _WIN32
+    GridGALib::GeneticAlgoBench bench(numGenomes, numParameters, iterations, workDir);
+    bench.Run(filter, results);
+    return true;
+#else
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        std::cerr << "Cannot create a pipe" << std::endl;
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        std::cerr << "Cannot fork" << std::endl;
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+        std::vector<GridGALib::BenchResult> childResults;
+        {
+            GridGALib::GeneticAlgoBench bench(numGenomes, numParameters, iterations, workDir);
+            bench.Run(filter, childResults);
+        }
+
+        std::ostringstream s;
+        BOOST_FOREACH(const GridGALib::BenchResult& result, childResults)
+        {
+            s << result.mName << " " << result.mIterations << " " << std::setprecision(17) << result.mNsPerOp << " " <<
+                result.mAllocationsPerOp << " " << result.mPeakRSSKb << "\n";
+        }
+        std::string text(s.str());
+        const char* p = text.c_str();
+        std::size_t left = text.size();
+        while (left > 0)
+        {
+            ssize_t numWritten = write(fds[1], p, left);
+            if (numWritten <= 0)
+            {
+                _exit(1);
+            }
+            p += numWritten;
+            left -= static_cast<std::size_t>(numWritten);
+        }
+        close(fds[1]);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    std::string text;
+    char buffer[4096];
+    ssize_t numRead;
+    while ((numRead = read(fds[0], buffer, sizeof(buffer))) > 0)
+    {
+        text.append(buffer, static_cast<std::size_t>(numRead));
+    }
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        std::cerr << "The benchmarks with " << numGenomes << " genomes and " << numParameters << " parameters failed" << std::endl;
+        return false;
+    }
+
+    std::istringstream lines(text);
+    GridGALib::BenchResult result;
+    result.mNumGenomes = numGenomes;
+    result.mNumParameters = numParameters;
+    while (lines >> result.mName >> result.mIterations >> result.mNsPerOp >> result.mAllocationsPerOp >> result.mPeakRSSKb)
+    {
+        results.push_back(result);
+    }
+    return true;
+#endif
+}
+
+//______________________________________________________________________________________________________________
+
+void PrintResults(const std::vector<GridGALib::BenchResult>& results, const std::string& format)
+{
+    if (boost::iequals(format, "json"))
+    {
+        std::cout << "[" << std::endl;
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const GridGALib::BenchResult& result = results[i];
+            std::cout << "  {\"benchmark\":\"" << result.mName << "\",\"genomes\":" << result.mNumGenomes <<
+                ",\"parameters\":" << result.mNumParameters << ",\"iterations\":" << result.mIterations <<
+                ",\"ns_per_op\":" << result.mNsPerOp << ",\"allocs_per_op\":" << result.mAllocationsPerOp <<
+                ",\"peak_rss_kb\":" << result.mPeakRSSKb << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        std::cout << "]" << std::endl;
+        return;
+    }
+
+    std::cout << "benchmark,genomes,parameters,iterations,ns_per_op,allocs_per_op,peak_rss_kb" << std::endl;
+    BOOST_FOREACH(const GridGALib::BenchResult& result, results)
+    {
+        std::cout << result.mName << "," << result.mNumGenomes << "," << result.mNumParameters << "," << result.mIterations << "," <<
+            result.mNsPerOp << "," << result.mAllocationsPerOp << "," << result.mPeakRSSKb << std::endl;
+    }
+}
+
+//______________________________________________________________________________________________________________
+
+int main(int argc, char* argv[])
+{
+    po::options_description desc("gridga_bench options");
+    desc.add_options()
+        ("help", "Show this message")
+        ("genomes", po::value<std::vector<std::size_t> >()->multitoken(), "Numbers of cached genomes to run with (default 1000 10000 100000)")
+        ("parameters", po::value<std::vector<std::size_t> >()->multitoken(), "Numbers of parameters per genome (default 10 100)")
+        ("iterations", po::value<std::size_t>()->default_value(10000), "Iterations of the per-genome operations")
+        ("filter", po::value<std::string>()->default_value(""), "Only run benchmarks whose name contains this")
+        ("format", po::value<std::string>()->default_value("csv"), "csv or json")
+        ("work-dir", po::value<std::string>()->default_value("gridga_bench.tmp"), "Where state and config files are written");
+
+    po::variables_map variablesMap;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, desc), variablesMap);
+        po::notify(variablesMap);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl << desc << std::endl;
+        return 1;
+    }
+
+    if (variablesMap.count("help"))
+    {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+
+    std::vector<std::size_t> genomeCounts;
+    std::vector<std::size_t> parameterCounts;
+    if (variablesMap.count("genomes"))
+    {
+        genomeCounts = variablesMap["genomes"].as<std::vector<std::size_t> >();
+    }
+    else
+    {
+        genomeCounts.push_back(1000);
+        genomeCounts.push_back(10000);
+        genomeCounts.push_back(100000);
+    }
+    if (variablesMap.count("parameters"))
+    {
+        parameterCounts = variablesMap["parameters"].as<std::vector<std::size_t> >();
+    }
+    else
+    {
+        parameterCounts.push_back(10);
+        parameterCounts.push_back(100);
+    }
+
+    // the GA logs every mutation, which would swamp the timings
+    Output2FILE::Stream() = NULL;
+    srand(12345);
+
+    std::string workDir(variablesMap["work-dir"].as<std::string>());
+    boost::filesystem::create_directories(workDir);
+
+    std::vector<GridGALib::BenchResult> results;
+    BOOST_FOREACH(std::size_t numParameters, parameterCounts)
+    {
+        BOOST_FOREACH(std::size_t numGenomes, genomeCounts)
+        {
+            if (!RunConfig(numGenomes, std::max<std::size_t>(numParameters, 2), variablesMap["iterations"].as<std::size_t>(),
+                variablesMap["filter"].as<std::string>(), workDir, results))
+            {
+                boost::filesystem::remove_all(workDir);
+                return 1;
+            }
+        }
+    }
+
+    PrintResults(results, variablesMap["format"].as<std::string>());
+    boost::filesystem::remove_all(workDir);
+    return 0;
+}
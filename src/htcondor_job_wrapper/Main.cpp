@@ -1,4 +1,7 @@
 #include "stdafx.hpp"
+#include "ObjectiveExtractor.hpp"
+#include "Process.hpp"
+#include "StagingCache.hpp"
 
 namespace po = boost::program_options;
 
@@ -52,80 +55,166 @@ namespace po = boost::program_options;
 
 //______________________________________________________________________________________________________________
 
-void TransmitToGAServer(std::string backtestResults, std::string serverName)
+void TransmitToGAServer(const std::string& backtestResults, std::string serverName)
 {
-    std::cout << backtestResults << std::endl;
     zmq::context_t zmqContext(1);
+    GridGALib::TransmitToGAServer(zmqContext, backtestResults, serverName, GridGALib::RESULT_TRANSMIT_MAX_ATTEMPTS,
+        GridGALib::RESULT_TRANSMIT_TIMEOUT_MILLISECONDS, true);
+}
 
-    std::size_t attemptCount = 1;
-    bool sentOk = false;
+//______________________________________________________________________________________________________________
 
-    std::size_t secondsToWait = 10;
+// Sends the result in the format requested by run_ga. Old masters don't set result-format, so they get XML.
+void SendResult(GridGALib::ResultMessage& result, const std::string& resultFormat, std::string serverName)
+{
+    std::string hostName(DeepThoughtLib::FileUtils::GetHostName());
+    result.SetHost(hostName.c_str(), hostName.size());
 
-    while (!sentOk && attemptCount < 11)
+    if (boost::iequals(resultFormat, "binary"))
     {
-        std::cout << "Sending Attempt " << attemptCount << " to " << serverName << std::endl;
-        try
-        {
-            zmq::socket_t sendSocket(zmqContext, ZMQ_REQ);
-            // this is required due to a bug in zeromq which causes the app to hang when the context is terminated
-            int linger = 0;
-            sendSocket.setsockopt (ZMQ_LINGER, &linger, sizeof (linger));
+        char buffer[GridGALib::RESULT_MESSAGE_MAX_SIZE];
+        std::size_t length = GridGALib::SerialiseResultMessage(result, buffer, sizeof(buffer));
+        std::cout << "Sending binary result for genome " << result.mGenomeID << ", objective " << result.mObjectives[0] << std::endl;
+        TransmitToGAServer(std::string(buffer, length), serverName);
+        return;
+    }
+
+    std::string sendXML(GridGALib::FormatResultXML(result));
+    std::cout << sendXML << std::endl;
+    TransmitToGAServer(sendXML, serverName);
+}
 
-            sendSocket.connect(serverName.c_str());
-            zmq::message_t sendMessage(backtestResults.length());
-            memcpy ((void *) sendMessage.data(), backtestResults.c_str(), backtestResults.length());  
+//______________________________________________________________________________________________________________
 
-            sendSocket.send(sendMessage);
+void SendError(std::string error, GridGALib::ResultMessage& result, const std::string& resultFormat, std::string serverName)
+{
+    std::cerr << error << std::endl;
+    result.mStatus = GridGALib::RESULT_STATUS_ERROR;
+    result.mNumObjectives = 1;
+    result.mObjectives[0] = -1.0;
+    result.SetError(error.c_str(), error.size());
+    SendResult(result, resultFormat, serverName);
+}
 
-            // wait for a response
-            zmq::pollitem_t items[] = 
-            {
-                {sendSocket, 0, ZMQ_POLLIN, 0}
-            };
+//______________________________________________________________________________________________________________
 
-            zmq::poll(items, 1, secondsToWait * 1000);
+boost::uint64_t MillisecondsSince(const boost::posix_time::ptime& time)
+{
+    return static_cast<boost::uint64_t>((boost::posix_time::microsec_clock::universal_time() - time).total_milliseconds());
+}
 
-            if (items[0].revents & ZMQ_POLLIN)
+//______________________________________________________________________________________________________________
+// Collects the output of a program run with RunProcess. The output is optionally spilled to a file and the first
+// non-empty line is kept, which is where an extract-obj command prints the objective.
+class OutputCapture
+{
+public:
+    OutputCapture(const std::string& spillFileName)
+    :
+        mSpillFile(NULL)
+    {
+        if (!spillFileName.empty())
+        {
+            mSpillFile = fopen(spillFileName.c_str(), "wb");
+        }
+    }
+
+    ~OutputCapture(void)
+    {
+        Close();
+    }
+
+    void Append(const char* data, std::size_t size)
+    {
+        if (mSpillFile)
+        {
+            fwrite(data, 1, size, mSpillFile);
+        }
+
+        for (std::size_t i = 0; i < size && mFirstLine.empty(); ++i)
+        {
+            if (data[i] == '\n')
             {
-                zmq::message_t message;
-                sendSocket.recv(&message);
-                char* receivedChar = static_cast<char*>(malloc(message.size() + 1));
-                memcpy(receivedChar, message.data(), message.size());
-                receivedChar[message.size()] = 0;
-                std::string receivedString(receivedChar);
-                std::cout << "Received response " << receivedString;
-                if (receivedString.compare("_ok_") == 0)
-                {
-                    sentOk = true;
-                }
+                EndLine();
             }
             else
             {
-                std::cerr << "Could not transmit results to GA server. Attempt " << attemptCount << std::endl;
+                mCurrentLine += data[i];
             }
         }
-        catch (std::exception& e)
+    }
+
+    void Close(void)
+    {
+        EndLine();
+        if (mSpillFile)
+        {
+            fclose(mSpillFile);
+            mSpillFile = NULL;
+        }
+    }
+
+    const std::string& GetFirstLine(void) const
+    {
+        return mFirstLine;
+    }
+private:
+    FILE* mSpillFile;
+    std::string mCurrentLine;
+    std::string mFirstLine;
+
+    void EndLine(void)
+    {
+        boost::trim(mCurrentLine);
+        if (mFirstLine.empty())
         {
-            std::cerr << "Exception while sending : " << e.what() << std::endl;
+            mFirstLine.swap(mCurrentLine);
         }
-        ++attemptCount;
+        mCurrentLine.clear();
+    }
+};
+
+//______________________________________________________________________________________________________________
+
+void ForwardOutput(OutputCapture* capture, HTCondorJobWrapper::ObjectiveExtractor* extractor, const char* data, std::size_t size)
+{
+    capture->Append(data, size);
+    if (extractor)
+    {
+        extractor->Append(data, size);
     }
 }
 
 //______________________________________________________________________________________________________________
 
-void SendError(std::string error, std::string id, std::string serverName)
+bool ExtractFromFile(const std::string& fileName, HTCondorJobWrapper::ObjectiveExtractor& extractor)
 {
-    std::cerr << error << std::endl;
-    std::ostringstream s;
-    s <<         
-        "<results>" << std::endl <<
-        "    <id>" << id << "</id>" << std::endl <<
-        "    <objective>-1</objective>" << std::endl <<
-        "    <error>" << error << "</error>" << std::endl <<
-        "</results>";
-    TransmitToGAServer(s.str(), serverName);
+    std::ifstream inFile(fileName.c_str(), std::ios::binary);
+    if (!inFile)
+    {
+        return false;
+    }
+
+    char buffer[65536];
+    while (inFile.read(buffer, sizeof(buffer)) || inFile.gcount() > 0)
+    {
+        extractor.Append(buffer, static_cast<std::size_t>(inFile.gcount()));
+    }
+    extractor.Finish();
+    return true;
+}
+
+//______________________________________________________________________________________________________________
+
+std::string ReadFirstLine(const std::string& fileName)
+{
+    std::ifstream inFile;
+    inFile.open(fileName.c_str());
+    std::string line;
+    std::getline(inFile, line);
+    inFile.close();
+    boost::trim(line);
+    return line;
 }
 
 //______________________________________________________________________________________________________________
@@ -156,43 +245,172 @@ int main(int argc, char* argv[])
     std::string objCmd = CommonLib::GetOptionalParameter<std::string>("config.extract-obj-value", pt, "NONE");
     std::string server = CommonLib::GetOptionalParameter<std::string>("config.server", pt, "NONE");
     std::string genomeID = CommonLib::GetOptionalParameter<std::string>("config.genome-id", pt, "NONE");
+    std::string resultFormat = CommonLib::GetOptionalParameter<std::string>("config.result-format", pt, "xml");
+    // set when run_ga runs several experiments on one port, so the result goes to the right one
+    boost::uint16_t experimentID = CommonLib::GetOptionalParameter<boost::uint16_t>("config.experiment-id", pt, 0);
+
+    // When run_ga submits a generation as a queue table all the jobs share one config, and the genome id and the
+    // %GA% arguments are passed on the command line instead.
+    if (argc > 2)
+    {
+        genomeID = argv[2];
+        std::ostringstream gaArguments;
+        for (int i = 3; i < argc; ++i)
+        {
+            gaArguments << (i > 3 ? " " : "") << argv[i];
+        }
+        boost::replace_all(executeCmd, "%GA%", gaArguments.str());
+        boost::replace_all(executeCmd, "%GENOME_ID%", genomeID);
+    }
+    // shell | direct
+    std::string spawn = CommonLib::GetOptionalParameter<std::string>("config.spawn", pt, "shell");
+    bool keepOutput = !boost::iequals(CommonLib::GetOptionalParameter<std::string>("config.keep-output", pt, "true"), "false");
+
+    const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+    boost::posix_time::ptime startTime(boost::posix_time::microsec_clock::universal_time());
+
+    GridGALib::ResultMessage result;
+    result.Clear();
+    result.mGenomeID = CommonLib::StringToInt(genomeID);
+    result.mExperimentID = experimentID;
+    result.mStartTimeMs = MillisecondsSince(epoch);
 
     if (boost::iequals(executeCmd, "NONE"))
     {
-        SendError("execute command has not been supplied!", genomeID, server);
+        SendError("execute command has not been supplied!", result, resultFormat, server);
         return 1;
     }
-    executeCmd = executeCmd + " > std.out 2>&1";
-    std::system(executeCmd.c_str());
 
-    if (!boost::iequals(objCmd, "NONE"))
+    // the built-in extractor replaces extract-obj-value, so nothing else has to be started to read the objective
+    boost::scoped_ptr<HTCondorJobWrapper::ObjectiveExtractor> extractor;
+    if (pt.get_child_optional("config.objective-extractor"))
     {
-        objCmd = objCmd + " > obj.out 2>&1";
-        std::system(objCmd.c_str());
+        try
+        {
+            extractor.reset(new HTCondorJobWrapper::ObjectiveExtractor(pt.get_child("config.objective-extractor")));
+        }
+        catch (std::exception& e)
+        {
+            SendError(std::string("Invalid objective-extractor: ") + e.what(), result, resultFormat, server);
+            return 1;
+        }
     }
 
-    if (!boost::filesystem::exists("obj.out"))
+    // required files sent through the staging cache instead of by HTCondor
+    std::string stagingCacheDir = CommonLib::GetOptionalParameter<std::string>("config.staging-cache-dir", pt, "");
+    if (!stagingCacheDir.empty())
     {
-        SendError("Could not find the value of the objective function (obj.out)!", genomeID, server);
-        return 1;
+        HTCondorJobWrapper::StagingCache stagingCache(stagingCacheDir, server);
+        try
+        {
+            BOOST_FOREACH(const HTCondorJobWrapper::StagedFileInfo& stagedFile, HTCondorJobWrapper::StagingCache::ReadStagedFiles(pt))
+            {
+                std::string error;
+                if (!stagingCache.Stage(stagedFile, error))
+                {
+                    SendError(error, result, resultFormat, server);
+                    return 1;
+                }
+            }
+        }
+        catch (std::exception& e)
+        {
+            SendError(std::string("Invalid staged-file: ") + e.what(), result, resultFormat, server);
+            return 1;
+        }
+        // the execute time doesn't include fetching the files
+        startTime = boost::posix_time::microsec_clock::universal_time();
     }
 
-    std::ifstream inFile;
-    inFile.open("obj.out");
     std::string objValue;
-    std::getline(inFile, objValue);
-    inFile.close();
+    if (boost::iequals(spawn, "direct"))
+    {
+        bool runObjCmd = !extractor && !boost::iequals(objCmd, "NONE");
+        // if nothing else is configured the objective is the last number printed, as with parse_libsvm_output.py
+        HTCondorJobWrapper::ObjectiveExtractor lastNumber("last-number", "");
+        HTCondorJobWrapper::ObjectiveExtractor* outputExtractor = extractor ? extractor.get() : (runObjCmd ? NULL : &lastNumber);
 
-    // write the out
-    std::ostringstream sendXML;
-    sendXML << 
-        "<results>" << std::endl <<
-        "    <id>" << genomeID << "</id>" << std::endl <<
-        "    <objective>" << objValue << "</objective>" << std::endl <<
-        "</results>";
+        // Run the executable without a shell and read its output through a pipe. std.out is only written if it
+        // is wanted, or if an external extract-obj command needs to read it.
+        OutputCapture capture((keepOutput || runObjCmd) ? "std.out" : "");
+        int exitCode = HTCondorJobWrapper::RunProcess(HTCondorJobWrapper::SplitCommandLine(executeCmd),
+            boost::bind(&ForwardOutput, &capture, outputExtractor, _1, _2));
+        capture.Close();
+        if (outputExtractor)
+        {
+            outputExtractor->Finish();
+        }
+        result.mExecuteMs = static_cast<boost::uint32_t>(MillisecondsSince(startTime));
+        if (exitCode == -1)
+        {
+            SendError("Could not start the execute command: " + executeCmd, result, resultFormat, server);
+            return 1;
+        }
+
+        boost::posix_time::ptime extractTime(boost::posix_time::microsec_clock::universal_time());
+        if (extractor)
+        {
+            objValue = extractor->GetValue();
+        }
+        else if (runObjCmd)
+        {
+            OutputCapture objCapture(keepOutput ? "obj.out" : "");
+            HTCondorJobWrapper::RunProcess(HTCondorJobWrapper::SplitCommandLine(objCmd),
+                boost::bind(&OutputCapture::Append, &objCapture, _1, _2));
+            objCapture.Close();
+            objValue = objCapture.GetFirstLine();
+        }
+        else if (boost::filesystem::exists("obj.out"))
+        {
+            // the executable wrote the objective itself
+            objValue = ReadFirstLine("obj.out");
+        }
+        else
+        {
+            objValue = lastNumber.GetValue();
+        }
+        result.mExtractMs = static_cast<boost::uint32_t>(MillisecondsSince(extractTime));
+    }
+    else
+    {
+        executeCmd = executeCmd + " > std.out 2>&1";
+        std::system(executeCmd.c_str());
+        result.mExecuteMs = static_cast<boost::uint32_t>(MillisecondsSince(startTime));
+
+        boost::posix_time::ptime extractTime(boost::posix_time::microsec_clock::universal_time());
+        if (extractor)
+        {
+            ExtractFromFile("std.out", *extractor);
+            objValue = extractor->GetValue();
+        }
+        else
+        {
+            if (!boost::iequals(objCmd, "NONE"))
+            {
+                objCmd = objCmd + " > obj.out 2>&1";
+                std::system(objCmd.c_str());
+            }
 
-    TransmitToGAServer(sendXML.str(), server);
+            if (!boost::filesystem::exists("obj.out"))
+            {
+                SendError("Could not find the value of the objective function (obj.out)!", result, resultFormat, server);
+                return 1;
+            }
+            objValue = ReadFirstLine("obj.out");
+        }
+        result.mExtractMs = static_cast<boost::uint32_t>(MillisecondsSince(extractTime));
+    }
+
+    if (objValue.empty())
+    {
+        SendError("Could not find the value of the objective function in the output!", result, resultFormat, server);
+        return 1;
+    }
+
+    result.mNumObjectives = 1;
+    result.mObjectives[0] = strtod(objValue.c_str(), NULL);
+
+    SendResult(result, resultFormat, server);
 
     return 0;
 }
-
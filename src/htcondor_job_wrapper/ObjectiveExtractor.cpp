@@ -0,0 +1,427 @@
+#include "stdafx.hpp"
+#include "ObjectiveExtractor.hpp"
+
+namespace HTCondorJobWrapper
+{
+    namespace
+    {
+        // anything past this on a single line is dropped, so a program that never prints a newline can't make us
+        // buffer its whole output
+        const std::size_t MAX_LINE_LENGTH = 65536;
+
+        bool IsNumberStart(const std::string& s, std::size_t i)
+        {
+            if (s[i] >= '0' && s[i] <= '9')
+            {
+                return true;
+            }
+            return (s[i] == '-' || s[i] == '.') && (i + 1 < s.size()) && ((s[i + 1] >= '0' && s[i + 1] <= '9') || s[i + 1] == '.');
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ObjectiveExtractor::ObjectiveExtractor(const std::string& type, const std::string& expression)
+    {
+        Init(type, expression);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ObjectiveExtractor::ObjectiveExtractor(const boost::property_tree::ptree& pt)
+    {
+        std::string type(pt.get<std::string>("<xmlattr>.type"));
+        if (boost::iequals(type, "regex"))
+        {
+            Init(type, pt.get<std::string>("<xmlattr>.pattern"));
+        }
+        else if (boost::iequals(type, "last-number"))
+        {
+            Init(type, pt.get<std::string>("<xmlattr>.prefix", ""));
+        }
+        else
+        {
+            Init(type, pt.get<std::string>("<xmlattr>.path", ""));
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ObjectiveExtractor::Init(const std::string& type, const std::string& expression)
+    {
+        mFound = false;
+        mJsonState = JSON_OUTSIDE;
+        mCapturing = false;
+
+        if (boost::iequals(type, "regex"))
+        {
+            mType = EXTRACTOR_REGEX;
+            // throws boost::regex_error if the pattern is invalid
+            mRegex.assign(expression);
+        }
+        else if (boost::iequals(type, "last-number"))
+        {
+            mType = EXTRACTOR_LAST_NUMBER;
+            mPrefix = expression;
+        }
+        else if (boost::iequals(type, "json"))
+        {
+            mType = EXTRACTOR_JSON;
+            ParsePath(expression);
+        }
+        else
+        {
+            throw std::runtime_error("Unknown objective-extractor type " + type);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // Paths are member names separated by dots, with array indices in brackets, e.g. results.scores[0]
+    void ObjectiveExtractor::ParsePath(const std::string& path)
+    {
+        std::vector<std::string> parts;
+        boost::split(parts, path, boost::is_any_of("."));
+        BOOST_FOREACH(std::string part, parts)
+        {
+            std::size_t bracket = part.find('[');
+            std::string key(part.substr(0, bracket));
+            if (!key.empty())
+            {
+                PathElement element = { key, -1 };
+                mPath.push_back(element);
+            }
+
+            while (bracket != std::string::npos)
+            {
+                std::size_t close = part.find(']', bracket);
+                if (close == std::string::npos)
+                {
+                    throw std::runtime_error("Invalid objective-extractor path " + path);
+                }
+                PathElement element = { "", boost::lexical_cast<boost::int32_t>(part.substr(bracket + 1, close - bracket - 1)) };
+                mPath.push_back(element);
+                bracket = part.find('[', close);
+            }
+        }
+
+        if (mPath.empty())
+        {
+            throw std::runtime_error("The json objective-extractor needs a path");
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ObjectiveExtractor::Append(const char* data, std::size_t size)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (mType == EXTRACTOR_JSON)
+            {
+                ProcessJson(data[i]);
+            }
+            else if (data[i] == '\n')
+            {
+                ProcessLine();
+                mLine.clear();
+            }
+            else if (mLine.size() < MAX_LINE_LENGTH)
+            {
+                mLine += data[i];
+            }
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ObjectiveExtractor::Finish(void)
+    {
+        if (mType == EXTRACTOR_JSON)
+        {
+            // a literal at the very end of the output is only terminated by the next character
+            ProcessJson(' ');
+        }
+        else
+        {
+            ProcessLine();
+            mLine.clear();
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool ObjectiveExtractor::Found(void) const
+    {
+        return mFound;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    const std::string& ObjectiveExtractor::GetValue(void) const
+    {
+        return mValue;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ObjectiveExtractor::ProcessLine(void)
+    {
+        if (!mLine.empty() && mLine[mLine.size() - 1] == '\r')
+        {
+            mLine.erase(mLine.size() - 1);
+        }
+
+        if (mType == EXTRACTOR_REGEX)
+        {
+            boost::smatch match;
+            if (boost::regex_search(mLine, match, mRegex))
+            {
+                mValue = (match.size() > 1 && match[1].matched) ? match[1].str() : match[0].str();
+                mFound = true;
+            }
+        }
+        else
+        {
+            std::size_t start = mLine.find_first_not_of(" \t");
+            if (start == std::string::npos || mLine.compare(start, mPrefix.size(), mPrefix) != 0)
+            {
+                return;
+            }
+
+            std::string number(FindLastNumber(mLine.substr(start + mPrefix.size())));
+            if (!number.empty())
+            {
+                mValue = number;
+                mFound = true;
+            }
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // e.g. "Cross Validation Accuracy = 49.9%" gives 49.9
+    std::string ObjectiveExtractor::FindLastNumber(const std::string& line)
+    {
+        std::string number;
+        std::size_t i = 0;
+        while (i < line.size())
+        {
+            if (!IsNumberStart(line, i))
+            {
+                ++i;
+                continue;
+            }
+
+            std::size_t end = i + 1;
+            while (end < line.size() && (isdigit(static_cast<unsigned char>(line[end])) || line[end] == '.' ||
+                ((line[end] == 'e' || line[end] == 'E') && end + 1 < line.size() &&
+                    (isdigit(static_cast<unsigned char>(line[end + 1])) || line[end + 1] == '-' || line[end + 1] == '+'))))
+            {
+                end += (line[end] == 'e' || line[end] == 'E') ? 2 : 1;
+            }
+            number = line.substr(i, end - i);
+            i = end;
+        }
+        return number;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ObjectiveExtractor::ProcessJson(char c)
+    {
+        bool isSpace = (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+        switch (mJsonState)
+        {
+        case JSON_OUTSIDE:
+            if (c == '{' || c == '[')
+            {
+                PushJsonFrame(c == '[');
+            }
+            break;
+        case JSON_EXPECT_KEY:
+            if (c == '"')
+            {
+                mJsonStack.back().mKey.clear();
+                mJsonState = JSON_IN_KEY;
+            }
+            else if (c == '}')
+            {
+                PopJsonFrame();
+            }
+            else if (!isSpace && c != ',')
+            {
+                mJsonStack.clear();
+                mJsonState = JSON_OUTSIDE;
+            }
+            break;
+        case JSON_IN_KEY:
+            if (c == '\\')
+            {
+                mJsonState = JSON_KEY_ESCAPE;
+            }
+            else if (c == '"')
+            {
+                mJsonState = JSON_EXPECT_COLON;
+            }
+            else
+            {
+                mJsonStack.back().mKey += c;
+            }
+            break;
+        case JSON_KEY_ESCAPE:
+            mJsonStack.back().mKey += c;
+            mJsonState = JSON_IN_KEY;
+            break;
+        case JSON_EXPECT_COLON:
+            if (c == ':')
+            {
+                mJsonState = JSON_EXPECT_VALUE;
+            }
+            else if (!isSpace)
+            {
+                mJsonStack.clear();
+                mJsonState = JSON_OUTSIDE;
+            }
+            break;
+        case JSON_EXPECT_VALUE:
+            if (c == '{' || c == '[')
+            {
+                PushJsonFrame(c == '[');
+            }
+            else if (c == ']' && mJsonStack.back().mIsArray)
+            {
+                // empty array
+                PopJsonFrame();
+            }
+            else if (c == '"')
+            {
+                StartJsonValue();
+                mJsonState = JSON_IN_STRING;
+            }
+            else if (!isSpace)
+            {
+                StartJsonValue();
+                mToken += c;
+                mJsonState = JSON_IN_LITERAL;
+            }
+            break;
+        case JSON_IN_STRING:
+            if (c == '\\')
+            {
+                mJsonState = JSON_STRING_ESCAPE;
+            }
+            else if (c == '"')
+            {
+                EndJsonValue();
+            }
+            else if (mCapturing && mToken.size() < MAX_LINE_LENGTH)
+            {
+                mToken += c;
+            }
+            break;
+        case JSON_STRING_ESCAPE:
+            if (mCapturing && mToken.size() < MAX_LINE_LENGTH)
+            {
+                mToken += c;
+            }
+            mJsonState = JSON_IN_STRING;
+            break;
+        case JSON_IN_LITERAL:
+            if (isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-' || c == '+')
+            {
+                if (mCapturing && mToken.size() < MAX_LINE_LENGTH)
+                {
+                    mToken += c;
+                }
+            }
+            else
+            {
+                EndJsonValue();
+                ProcessJson(c);
+            }
+            break;
+        case JSON_AFTER_VALUE:
+            if (c == ',')
+            {
+                if (mJsonStack.back().mIsArray)
+                {
+                    ++mJsonStack.back().mIndex;
+                    mJsonState = JSON_EXPECT_VALUE;
+                }
+                else
+                {
+                    mJsonState = JSON_EXPECT_KEY;
+                }
+            }
+            else if ((c == '}' && !mJsonStack.back().mIsArray) || (c == ']' && mJsonStack.back().mIsArray))
+            {
+                PopJsonFrame();
+            }
+            else if (!isSpace)
+            {
+                mJsonStack.clear();
+                mJsonState = JSON_OUTSIDE;
+            }
+            break;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ObjectiveExtractor::StartJsonValue(void)
+    {
+        mToken.clear();
+        mCapturing = JsonPathMatches();
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ObjectiveExtractor::EndJsonValue(void)
+    {
+        if (mCapturing)
+        {
+            mValue = mToken;
+            mFound = true;
+            mCapturing = false;
+        }
+        mJsonState = mJsonStack.empty() ? JSON_OUTSIDE : JSON_AFTER_VALUE;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ObjectiveExtractor::PushJsonFrame(bool isArray)
+    {
+        JsonFrame frame = { isArray, "", 0 };
+        mJsonStack.push_back(frame);
+        mJsonState = isArray ? JSON_EXPECT_VALUE : JSON_EXPECT_KEY;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ObjectiveExtractor::PopJsonFrame(void)
+    {
+        mJsonStack.pop_back();
+        mJsonState = mJsonStack.empty() ? JSON_OUTSIDE : JSON_AFTER_VALUE;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool ObjectiveExtractor::JsonPathMatches(void) const
+    {
+        if (mJsonStack.size() != mPath.size())
+        {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < mPath.size(); ++i)
+        {
+            if (mJsonStack[i].mIsArray ? (mPath[i].mIndex != mJsonStack[i].mIndex) :
+                (mPath[i].mIndex != -1 || mPath[i].mKey != mJsonStack[i].mKey))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+namespace HTCondorJobWrapper
+{
+    // Pulls the value of the objective function out of a program's output while it is being produced, so the output
+    // never has to be held in memory and no external extract-obj command has to be started. Set in the job config as
+    // one of
+    //   <objective-extractor type="regex" pattern="Accuracy = ([0-9.]+)%" />
+    //   <objective-extractor type="last-number" prefix="Cross Validation Accuracy" />
+    //   <objective-extractor type="json" path="results.scores[0]" />
+    // The regex uses its first capture group (or the whole match if it has none) and last-number takes the last
+    // number on a line starting with the prefix. For both, the last matching line wins. json takes the value at the
+    // path in the last JSON document printed, ignoring any text outside the document.
+	class ObjectiveExtractor : boost::noncopyable
+    {
+    public:
+        enum ExtractorType
+        {
+            EXTRACTOR_REGEX,
+            EXTRACTOR_LAST_NUMBER,
+            EXTRACTOR_JSON
+        };
+
+        ObjectiveExtractor(const std::string& type, const std::string& expression);
+        ObjectiveExtractor(const boost::property_tree::ptree& pt);
+        void Append(const char* data, std::size_t size);
+        void Finish(void);
+        bool Found(void) const;
+        const std::string& GetValue(void) const;
+
+        static std::string FindLastNumber(const std::string& line);
+    private:
+        struct PathElement
+        {
+            std::string mKey;
+            // -1 for an object member
+            boost::int32_t mIndex;
+        };
+
+        struct JsonFrame
+        {
+            bool mIsArray;
+            std::string mKey;
+            boost::int32_t mIndex;
+        };
+
+        enum JsonState
+        {
+            JSON_OUTSIDE,
+            JSON_EXPECT_KEY,
+            JSON_IN_KEY,
+            JSON_KEY_ESCAPE,
+            JSON_EXPECT_COLON,
+            JSON_EXPECT_VALUE,
+            JSON_IN_STRING,
+            JSON_STRING_ESCAPE,
+            JSON_IN_LITERAL,
+            JSON_AFTER_VALUE
+        };
+
+        ExtractorType mType;
+        boost::regex mRegex;
+        std::string mPrefix;
+        std::vector<PathElement> mPath;
+        std::string mLine;
+        std::string mValue;
+        bool mFound;
+
+        std::vector<JsonFrame> mJsonStack;
+        JsonState mJsonState;
+        std::string mToken;
+        bool mCapturing;
+
+        void Init(const std::string& type, const std::string& expression);
+        void ParsePath(const std::string& path);
+        void ProcessLine(void);
+        void ProcessJson(char c);
+        void StartJsonValue(void);
+        void EndJsonValue(void);
+        void PushJsonFrame(bool isArray);
+        void PopJsonFrame(void);
+        bool JsonPathMatches(void) const;
+    };
+}
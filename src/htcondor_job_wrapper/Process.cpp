@@ -0,0 +1,199 @@
+#include "stdafx.hpp"
+#include "Process.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace HTCondorJobWrapper
+{
+    std::vector<std::string> SplitCommandLine(const std::string& commandLine)
+    {
+        std::vector<std::string> arguments;
+        std::string argument;
+        bool inQuotes = false;
+        bool haveArgument = false;
+
+        BOOST_FOREACH(char c, commandLine)
+        {
+            if (c == '"')
+            {
+                inQuotes = !inQuotes;
+                haveArgument = true;
+            }
+            else if (!inQuotes && isspace(static_cast<unsigned char>(c)))
+            {
+                if (haveArgument)
+                {
+                    arguments.push_back(argument);
+                    argument.clear();
+                    haveArgument = false;
+                }
+            }
+            else
+            {
+                argument += c;
+                haveArgument = true;
+            }
+        }
+
+        if (haveArgument)
+        {
+            arguments.push_back(argument);
+        }
+        return arguments;
+    }
+
+    //______________________________________________________________________________________________________________
+
+#ifdef _WIN32
+
+    int RunProcess(const std::vector<std::string>& arguments, ProcessOutputFunc output)
+    {
+        if (arguments.empty())
+        {
+            return -1;
+        }
+
+        SECURITY_ATTRIBUTES securityAttributes;
+        securityAttributes.nLength = sizeof(SECURITY_ATTRIBUTES);
+        securityAttributes.bInheritHandle = TRUE;
+        securityAttributes.lpSecurityDescriptor = NULL;
+
+        HANDLE readPipe = NULL;
+        HANDLE writePipe = NULL;
+        if (!CreatePipe(&readPipe, &writePipe, &securityAttributes, 0))
+        {
+            return -1;
+        }
+        SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+        std::ostringstream commandLine;
+        BOOST_FOREACH(const std::string& argument, arguments)
+        {
+            commandLine << "\"" << argument << "\" ";
+        }
+        std::string commandLineString(commandLine.str());
+        std::vector<char> commandLineBuffer(commandLineString.begin(), commandLineString.end());
+        commandLineBuffer.push_back(0);
+
+        STARTUPINFO startupInfo;
+        ZeroMemory(&startupInfo, sizeof(startupInfo));
+        startupInfo.cb = sizeof(startupInfo);
+        startupInfo.hStdOutput = writePipe;
+        startupInfo.hStdError = writePipe;
+        startupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        startupInfo.dwFlags |= STARTF_USESTDHANDLES;
+
+        PROCESS_INFORMATION processInfo;
+        ZeroMemory(&processInfo, sizeof(processInfo));
+
+        BOOL created = CreateProcess(NULL, &commandLineBuffer[0], NULL, NULL, TRUE, 0, NULL, NULL, &startupInfo, &processInfo);
+        CloseHandle(writePipe);
+        if (!created)
+        {
+            CloseHandle(readPipe);
+            return -1;
+        }
+
+        char buffer[65536];
+        DWORD bytesRead = 0;
+        while (ReadFile(readPipe, buffer, sizeof(buffer), &bytesRead, NULL) && bytesRead > 0)
+        {
+            output(buffer, bytesRead);
+        }
+        CloseHandle(readPipe);
+
+        WaitForSingleObject(processInfo.hProcess, INFINITE);
+        DWORD exitCode = 0;
+        GetExitCodeProcess(processInfo.hProcess, &exitCode);
+        CloseHandle(processInfo.hProcess);
+        CloseHandle(processInfo.hThread);
+        return static_cast<int>(exitCode);
+    }
+
+#else
+
+    int RunProcess(const std::vector<std::string>& arguments, ProcessOutputFunc output)
+    {
+        if (arguments.empty())
+        {
+            return -1;
+        }
+
+        int pipeFds[2];
+        if (pipe(pipeFds) != 0)
+        {
+            return -1;
+        }
+
+        posix_spawn_file_actions_t fileActions;
+        posix_spawn_file_actions_init(&fileActions);
+        posix_spawn_file_actions_adddup2(&fileActions, pipeFds[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&fileActions, pipeFds[1], STDERR_FILENO);
+        posix_spawn_file_actions_addclose(&fileActions, pipeFds[0]);
+        posix_spawn_file_actions_addclose(&fileActions, pipeFds[1]);
+
+        std::vector<char*> argv;
+        BOOST_FOREACH(const std::string& argument, arguments)
+        {
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        }
+        argv.push_back(NULL);
+
+        // posix_spawnp doesn't search the current directory, which is where HTCondor puts the transferred executable
+        std::string program(arguments.front());
+        if (program.find('/') == std::string::npos && boost::filesystem::exists(program))
+        {
+            program = "./" + program;
+        }
+
+        pid_t pid;
+        int rc = posix_spawnp(&pid, program.c_str(), &fileActions, NULL, &argv[0], environ);
+        posix_spawn_file_actions_destroy(&fileActions);
+        close(pipeFds[1]);
+        if (rc != 0)
+        {
+            close(pipeFds[0]);
+            std::cerr << "Cannot start " << program << " : " << strerror(rc) << std::endl;
+            return -1;
+        }
+
+        char buffer[65536];
+        while (true)
+        {
+            ssize_t bytesRead = read(pipeFds[0], buffer, sizeof(buffer));
+            if (bytesRead < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (bytesRead <= 0)
+            {
+                break;
+            }
+            output(buffer, static_cast<std::size_t>(bytesRead));
+        }
+        close(pipeFds[0]);
+
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        {
+        }
+
+        if (WIFSIGNALED(status))
+        {
+            // report it the same way a shell would
+            return 128 + WTERMSIG(status);
+        }
+        return WEXITSTATUS(status);
+    }
+
+#endif
+
+    //______________________________________________________________________________________________________________
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+namespace HTCondorJobWrapper
+{
+    typedef boost::function<void (const char* data, std::size_t size)> ProcessOutputFunc;
+
+    // Splits a command line into its arguments. Whitespace separates arguments unless it is inside double quotes.
+    std::vector<std::string> SplitCommandLine(const std::string& commandLine);
+
+    // Runs a program directly, without starting a shell. stdout and stderr are merged (as with 2>&1) and passed to
+    // output as they are read from the pipe. Returns the exit code of the program (128 + signal number if it
+    // was killed), or -1 if it could not be started.
+    int RunProcess(const std::vector<std::string>& arguments, ProcessOutputFunc output);
+}
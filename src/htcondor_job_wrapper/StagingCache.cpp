@@ -0,0 +1,219 @@
+#include "stdafx.hpp"
+#include "StagingCache.hpp"
+
+#include "../run_ga/StagingMessage.hpp"
+
+namespace HTCondorJobWrapper
+{
+    namespace
+    {
+        const std::size_t MAX_REQUEST_ATTEMPTS = 10;
+        const long REPLY_TIMEOUT_MILLISECONDS = 30000;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    StagingCache::StagingCache(const std::string& cacheDir, const std::string& serverName)
+    :
+        mCacheDir(cacheDir),
+        mServerName(serverName),
+        mZmqContext(1)
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+    // <staged-file name="heart_scale" sha1="..." size="27670" mode="644" />, where an older run_ga doesn't send the mode
+    // and the file is made executable in case it's the executable
+    std::vector<StagedFileInfo> StagingCache::ReadStagedFiles(const boost::property_tree::ptree& pt)
+    {
+        std::vector<StagedFileInfo> stagedFiles;
+        BOOST_FOREACH(const boost::property_tree::ptree::value_type& child, pt.get_child("config"))
+        {
+            if (child.first.compare("staged-file") == 0)
+            {
+                StagedFileInfo stagedFile;
+                stagedFile.mName = child.second.get<std::string>("<xmlattr>.name");
+                stagedFile.mHash = child.second.get<std::string>("<xmlattr>.sha1");
+                stagedFile.mSize = child.second.get<boost::uint64_t>("<xmlattr>.size");
+                stagedFile.mMode = static_cast<boost::uint32_t>(strtoul(child.second.get<std::string>("<xmlattr>.mode", "755").c_str(), 0, 8)) & 0777;
+                stagedFiles.push_back(stagedFile);
+            }
+        }
+        return stagedFiles;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool StagingCache::Stage(const StagedFileInfo& stagedFile, std::string& error)
+    {
+        if (stagedFile.mHash.size() != GridGALib::STAGING_HASH_LENGTH)
+        {
+            error = "Invalid hash for staged file " + stagedFile.mName;
+            return false;
+        }
+
+        boost::system::error_code ec;
+        boost::filesystem::create_directories(mCacheDir, ec);
+
+        std::string cacheFileName((boost::filesystem::path(mCacheDir) / stagedFile.mHash).string());
+        if (boost::filesystem::exists(cacheFileName, ec) && boost::filesystem::file_size(cacheFileName, ec) == stagedFile.mSize)
+        {
+            std::cout << "Staging cache hit for " << stagedFile.mName << std::endl;
+        }
+        else if (!Fetch(stagedFile, cacheFileName, error))
+        {
+            return false;
+        }
+
+        boost::filesystem::remove(stagedFile.mName, ec);
+        boost::filesystem::create_hard_link(cacheFileName, stagedFile.mName, ec);
+        if (ec)
+        {
+            // the cache is on another file system, or it doesn't support links
+            ec.clear();
+            boost::filesystem::copy_file(cacheFileName, stagedFile.mName, ec);
+            if (ec)
+            {
+                error = "Cannot copy " + cacheFileName + " to " + stagedFile.mName + " : " + ec.message();
+                return false;
+            }
+        }
+
+        // the cached copy may have been fetched for a file with other permissions but the same contents
+        boost::filesystem::permissions(stagedFile.mName, static_cast<boost::filesystem::perms>(stagedFile.mMode), ec);
+        if (ec)
+        {
+            error = "Cannot set the permissions of " + stagedFile.mName + " : " + ec.message();
+            return false;
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool StagingCache::Fetch(const StagedFileInfo& stagedFile, const std::string& cacheFileName, std::string& error)
+    {
+        std::cout << "Fetching " << stagedFile.mName << " (" << stagedFile.mSize << " bytes) from " << mServerName << std::endl;
+
+        // unique to this job, so concurrent fetches of the same file never write to the same place
+        std::string tempFileName(cacheFileName + "." + boost::lexical_cast<std::string>(boost::uuids::random_generator()()) + ".tmp");
+        std::ofstream tempFile(tempFileName.c_str(), std::ios::binary);
+        if (!tempFile)
+        {
+            error = "Cannot write to the staging cache " + tempFileName;
+            return false;
+        }
+
+        boost::uuids::detail::sha1 sha1;
+        boost::uint64_t offset = 0;
+        std::vector<char> reply;
+        bool ok = true;
+        while (ok && offset < stagedFile.mSize)
+        {
+            if (!RequestChunk(stagedFile.mHash, offset, reply))
+            {
+                error = "Could not fetch " + stagedFile.mName + " from " + mServerName;
+                ok = false;
+                break;
+            }
+
+            std::size_t dataSize = reply.size() - GridGALib::STAGING_REPLY_HEADER_SIZE;
+            boost::uint16_t status = GridGALib::ResultMessageDetail::Read<boost::uint16_t>(&reply[4]);
+            if (status != GridGALib::STAGING_STATUS_OK || dataSize == 0)
+            {
+                error = "run_ga does not have the staged file " + stagedFile.mName;
+                ok = false;
+                break;
+            }
+
+            const char* data = &reply[GridGALib::STAGING_REPLY_HEADER_SIZE];
+            sha1.process_bytes(data, dataSize);
+            tempFile.write(data, static_cast<std::streamsize>(dataSize));
+            offset += dataSize;
+        }
+        tempFile.close();
+
+        boost::system::error_code ec;
+        if (ok && (!tempFile || GridGALib::GetHashString(sha1) != stagedFile.mHash))
+        {
+            error = "The fetched copy of " + stagedFile.mName + " does not match its hash";
+            ok = false;
+        }
+        if (!ok)
+        {
+            boost::filesystem::remove(tempFileName, ec);
+            return false;
+        }
+
+        // written by ofstream with the default permissions, which don't include execute
+        boost::filesystem::permissions(tempFileName, static_cast<boost::filesystem::perms>(stagedFile.mMode), ec);
+        boost::filesystem::rename(tempFileName, cacheFileName, ec);
+        if (ec)
+        {
+            // Windows won't replace a file, which is fine if another job got there first
+            boost::filesystem::remove(tempFileName, ec);
+            if (!boost::filesystem::exists(cacheFileName, ec))
+            {
+                error = "Cannot add " + stagedFile.mName + " to the staging cache";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+    // A REQ socket can't send again until it has had a reply, so a new one is used for every attempt
+    bool StagingCache::RequestChunk(const std::string& hash, boost::uint64_t offset, std::vector<char>& reply)
+    {
+        GridGALib::StagingRequest request;
+        request.mOffset = offset;
+        request.mLength = GridGALib::STAGING_CHUNK_SIZE;
+        memcpy(request.mHash, hash.c_str(), GridGALib::STAGING_HASH_LENGTH);
+        request.mHash[GridGALib::STAGING_HASH_LENGTH] = 0;
+
+        for (std::size_t attempt = 1; attempt <= MAX_REQUEST_ATTEMPTS; ++attempt)
+        {
+            try
+            {
+                zmq::socket_t socket(mZmqContext, ZMQ_REQ);
+                // this is required due to a bug in zeromq which causes the app to hang when the context is terminated
+                int linger = 0;
+                socket.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+                socket.connect(mServerName.c_str());
+
+                zmq::message_t requestMessage(GridGALib::STAGING_REQUEST_SIZE);
+                GridGALib::SerialiseStagingRequest(request, static_cast<char*>(requestMessage.data()));
+                socket.send(requestMessage);
+
+                zmq::pollitem_t items[] =
+                {
+                    { socket, 0, ZMQ_POLLIN, 0 }
+                };
+                zmq::poll(items, 1, REPLY_TIMEOUT_MILLISECONDS);
+                if (items[0].revents & ZMQ_POLLIN)
+                {
+                    zmq::message_t replyMessage;
+                    socket.recv(&replyMessage);
+                    if (replyMessage.size() >= GridGALib::STAGING_REPLY_HEADER_SIZE &&
+                        memcmp(replyMessage.data(), GridGALib::STAGING_REPLY_MAGIC, 4) == 0)
+                    {
+                        const char* data = static_cast<const char*>(replyMessage.data());
+                        reply.assign(data, data + replyMessage.size());
+                        return true;
+                    }
+                    // an old run_ga acknowledges anything it is sent
+                    std::cerr << "Unexpected reply to a staging request" << std::endl;
+                    return false;
+                }
+                std::cerr << "No reply to staging request. Attempt " << attempt << std::endl;
+            }
+            catch (std::exception& e)
+            {
+                std::cerr << "Exception while fetching : " << e.what() << std::endl;
+            }
+        }
+        return false;
+    }
+
+    //______________________________________________________________________________________________________________
+}
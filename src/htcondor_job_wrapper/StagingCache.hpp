@@ -0,0 +1,37 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+namespace HTCondorJobWrapper
+{
+    struct StagedFileInfo
+    {
+        std::string mName;
+        std::string mHash;
+        boost::uint64_t mSize;
+        // permission bits, e.g. 0755 for an executable
+        boost::uint32_t mMode;
+    };
+
+    // Puts the required files into the job's directory from a cache shared by every job on the execute node. Files
+    // are kept in the cache under the SHA-1 of their contents, so a file is only fetched from run_ga the first time
+    // a job on the node needs it. A fetched file is checked against its hash before it is renamed into the cache,
+    // which means jobs starting together can fetch the same file without seeing each other's partial copies.
+    // Files are hard linked from the cache where possible, so a job must not change its required files in place.
+    // The permissions given by run_ga are set on the fetched file and on the job's copy.
+	class StagingCache : boost::noncopyable
+    {
+    public:
+        StagingCache(const std::string& cacheDir, const std::string& serverName);
+        bool Stage(const StagedFileInfo& stagedFile, std::string& error);
+
+        static std::vector<StagedFileInfo> ReadStagedFiles(const boost::property_tree::ptree& pt);
+    private:
+        std::string mCacheDir;
+        std::string mServerName;
+        zmq::context_t mZmqContext;
+
+        bool Fetch(const StagedFileInfo& stagedFile, const std::string& cacheFileName, std::string& error);
+        bool RequestChunk(const std::string& hash, boost::uint64_t offset, std::vector<char>& reply);
+    };
+}
@@ -70,4 +70,6 @@
 
 #include "../run_ga/FileUtils.hpp"
 #include "../run_ga/Log.hpp"
+#include "../run_ga/ResultMessage.hpp"
+#include "../run_ga/ResultTransmit.hpp"
 #include "../run_ga/Utils.hpp"
@@ -0,0 +1,137 @@
+#include "stdafx.hpp"
+#include "CondorUserLog.hpp"
+
+namespace GridGALib
+{
+    CondorUserLog::CondorUserLog(const std::string& fileName)
+    :
+        mFileName(fileName),
+        mOffset(0)
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+
+    std::size_t CondorUserLog::ReadEvents(std::vector<CondorJobEvent>& events)
+    {
+        boost::system::error_code ec;
+        boost::uintmax_t fileSize = boost::filesystem::file_size(mFileName, ec);
+        if (ec)
+        {
+            // nothing has been submitted yet
+            return 0;
+        }
+
+        if (fileSize < mOffset)
+        {
+            FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "- " << mFileName << " has been truncated, reading it again from the start.";
+            mOffset = 0;
+            mPending.clear();
+        }
+        if (fileSize == mOffset)
+        {
+            return 0;
+        }
+
+        std::ifstream logFile(mFileName.c_str(), std::ios::binary);
+        logFile.seekg(static_cast<std::streamoff>(mOffset));
+        std::vector<char> buffer(static_cast<std::size_t>(fileSize - mOffset));
+        logFile.read(&buffer[0], buffer.size());
+        std::size_t bytesRead = static_cast<std::size_t>(logFile.gcount());
+        mOffset += bytesRead;
+        mPending.append(&buffer[0], bytesRead);
+
+        // every event is terminated by a line holding "..."
+        std::size_t numEvents = 0;
+        std::size_t eventStart = 0;
+        std::size_t lineStart = 0;
+        std::size_t lineEnd;
+        while ((lineEnd = mPending.find('\n', lineStart)) != std::string::npos)
+        {
+            if (mPending.compare(lineStart, 3, "...") == 0)
+            {
+                CondorJobEvent event;
+                if (ParseEvent(mPending.substr(eventStart, lineStart - eventStart), event))
+                {
+                    events.push_back(event);
+                    ++numEvents;
+                }
+                eventStart = lineEnd + 1;
+            }
+            lineStart = lineEnd + 1;
+        }
+        mPending.erase(0, eventStart);
+        return numEvents;
+    }
+
+    //______________________________________________________________________________________________________________
+    // An event looks like
+    //   005 (1234.003.000) 05/14 10:21:33 Job terminated.
+    //       (1) Normal termination (return value 0)
+    //       ...
+    bool CondorUserLog::ParseEvent(const std::string& text, CondorJobEvent& event)
+    {
+        boost::int32_t subProc = 0;
+        if (sscanf(text.c_str(), "%d (%d.%d.%d)", &event.mEventCode, &event.mJobID.first, &event.mJobID.second, &subProc) != 4)
+        {
+            return false;
+        }
+        event.mNormalTermination = true;
+        event.mReturnValue = 0;
+
+        std::size_t firstLineEnd = text.find('\n');
+        std::string firstLine(text.substr(0, firstLineEnd));
+        std::string secondLine;
+        if (firstLineEnd != std::string::npos)
+        {
+            secondLine = text.substr(firstLineEnd + 1, text.find('\n', firstLineEnd + 1) - firstLineEnd - 1);
+            boost::trim(secondLine);
+        }
+
+        switch (event.mEventCode)
+        {
+        case CONDOR_EVENT_EXECUTE:
+            {
+                // Job executing on host: <10.0.0.12:9618?addrs=...>
+                std::size_t hostStart = firstLine.find('<');
+                if (hostStart != std::string::npos)
+                {
+                    std::size_t hostEnd = firstLine.find_first_of("?>", hostStart);
+                    event.mDetail = firstLine.substr(hostStart + 1, hostEnd == std::string::npos ? std::string::npos : hostEnd - hostStart - 1);
+                }
+            }
+            break;
+        case CONDOR_EVENT_TERMINATED:
+            {
+                std::size_t pos;
+                if ((pos = text.find("Normal termination (return value ")) != std::string::npos)
+                {
+                    event.mReturnValue = atoi(text.c_str() + pos + strlen("Normal termination (return value "));
+                }
+                else if ((pos = text.find("Abnormal termination (signal ")) != std::string::npos)
+                {
+                    event.mNormalTermination = false;
+                    event.mReturnValue = atoi(text.c_str() + pos + strlen("Abnormal termination (signal "));
+                }
+            }
+            break;
+        case CONDOR_EVENT_EXECUTABLE_ERROR:
+            {
+                // the reason is on the first line, after the time stamp
+                std::size_t pos = firstLine.find(')');
+                for (int field = 0; field < 3 && pos != std::string::npos; ++field)
+                {
+                    pos = firstLine.find(' ', pos + 1);
+                }
+                event.mDetail = (pos == std::string::npos) ? firstLine : firstLine.substr(pos + 1);
+            }
+            break;
+        default:
+            event.mDetail = secondLine;
+            break;
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+namespace GridGALib
+{
+    // cluster, proc
+    typedef std::pair<boost::int32_t, boost::int32_t> CondorJobID;
+
+    // Event numbers as written to the HTCondor user log. Only the events that change what the GA does are listed.
+    enum CondorEventCode
+    {
+        CONDOR_EVENT_SUBMIT = 0,
+        CONDOR_EVENT_EXECUTE = 1,
+        CONDOR_EVENT_EXECUTABLE_ERROR = 2,
+        CONDOR_EVENT_EVICTED = 4,
+        CONDOR_EVENT_TERMINATED = 5,
+        CONDOR_EVENT_ABORTED = 9,
+        CONDOR_EVENT_HELD = 12
+    };
+
+    struct CondorJobEvent
+    {
+        boost::int32_t mEventCode;
+        CondorJobID mJobID;
+        // the execute host for execute events, otherwise the reason given by HTCondor
+        std::string mDetail;
+        // terminated events only
+        bool mNormalTermination;
+        // the exit code for a normal termination, otherwise the signal number
+        boost::int32_t mReturnValue;
+    };
+
+    // Follows an HTCondor user log as it grows. Each call to ReadEvents() only reads what has been appended since the
+    // previous call, and an event that is still being written is left until it is complete.
+	class CondorUserLog : boost::noncopyable
+    {
+    public:
+        CondorUserLog(const std::string& fileName);
+        std::size_t ReadEvents(std::vector<CondorJobEvent>& events);
+
+        static bool ParseEvent(const std::string& text, CondorJobEvent& event);
+    private:
+        std::string mFileName;
+        boost::uintmax_t mOffset;
+        std::string mPending;
+    };
+}
@@ -0,0 +1,198 @@
+#include "stdafx.hpp"
+#include "DispatchScheduler.hpp"
+
+namespace GridGALib
+{
+    DispatchScheduler::DispatchScheduler(std::size_t maxJobs, DispatchPolicy policy)
+    :
+        mMaxJobs(maxJobs),
+        mPolicy(policy),
+        mNumInFlight(0)
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+
+    DispatchPolicy DispatchScheduler::PolicyFromString(const std::string& policy)
+    {
+        if (boost::iequals(policy, "fair-share"))
+        {
+            return DISPATCH_FAIR_SHARE;
+        }
+        if (boost::iequals(policy, "priority"))
+        {
+            return DISPATCH_PRIORITY;
+        }
+        return DISPATCH_UNKNOWN;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    std::size_t DispatchScheduler::AddExperiment(double weight)
+    {
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        ExperimentShare share;
+        share.mWeight = (weight > 0.0) ? weight : 1.0;
+        share.mInFlight = 0;
+        share.mWaiting = 0;
+        mShares.push_back(share);
+        return mShares.size() - 1;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    std::size_t DispatchScheduler::GetMaxJobs(void) const
+    {
+        return mMaxJobs;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Waits in short steps so a submit thread being stopped is never stuck here for long
+    std::size_t DispatchScheduler::Acquire(std::size_t experimentID, std::size_t numJobs, DispatchCancelledFunc cancelled)
+    {
+        boost::unique_lock<boost::mutex> lock(mMutex);
+        ExperimentShare& share(mShares[experimentID]);
+        if (mMaxJobs == 0 || numJobs == 0)
+        {
+            share.mInFlight += numJobs;
+            mNumInFlight += numJobs;
+            return numJobs;
+        }
+
+        share.mWaiting = numJobs;
+        while (true)
+        {
+            if (cancelled && cancelled())
+            {
+                share.mWaiting = 0;
+                // someone else may be next now
+                mJobsReleased.notify_all();
+                return 0;
+            }
+
+            if (mNumInFlight < mMaxJobs && IsNext(experimentID))
+            {
+                std::size_t numGranted = std::min(std::min(numJobs, mMaxJobs - mNumInFlight), GetQuota(experimentID));
+                share.mWaiting = 0;
+                share.mInFlight += numGranted;
+                mNumInFlight += numGranted;
+                mJobsReleased.notify_all();
+                return numGranted;
+            }
+
+            mJobsReleased.timed_wait(lock, boost::posix_time::milliseconds(100));
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void DispatchScheduler::Release(std::size_t experimentID, std::size_t numJobs)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mMutex);
+            ExperimentShare& share(mShares[experimentID]);
+            numJobs = std::min(numJobs, share.mInFlight);
+            share.mInFlight -= numJobs;
+            mNumInFlight -= numJobs;
+        }
+        mJobsReleased.notify_all();
+    }
+
+    //______________________________________________________________________________________________________________
+    // Fair-share serves the waiting experiment with the fewest jobs in flight for its weight. Priority serves the
+    // waiting experiment with the highest weight, and then the same as fair-share between equal weights.
+    bool DispatchScheduler::IsNext(std::size_t experimentID) const
+    {
+        std::size_t next = mShares.size();
+        for (std::size_t i = 0; i < mShares.size(); ++i)
+        {
+            if (mShares[i].mWaiting == 0)
+            {
+                continue;
+            }
+            if (next == mShares.size())
+            {
+                next = i;
+                continue;
+            }
+            if (mPolicy == DISPATCH_PRIORITY && mShares[i].mWeight != mShares[next].mWeight)
+            {
+                if (mShares[i].mWeight > mShares[next].mWeight)
+                {
+                    next = i;
+                }
+                continue;
+            }
+            if ((mShares[i].mInFlight / mShares[i].mWeight) < (mShares[next].mInFlight / mShares[next].mWeight))
+            {
+                next = i;
+            }
+        }
+        return next == experimentID;
+    }
+
+    //______________________________________________________________________________________________________________
+    // The experiment's share of max-jobs, less what it already has in flight. Shares are weighted max-min fair over
+    // what the experiments want, i.e. their jobs in flight and waiting, so capacity an experiment doesn't want is split
+    // between the rest. Never less than 1, so the experiment that's next always makes progress.
+    std::size_t DispatchScheduler::GetQuota(std::size_t experimentID) const
+    {
+        if (mPolicy == DISPATCH_PRIORITY)
+        {
+            return mShares[experimentID].mWaiting;
+        }
+
+        std::vector<std::size_t> unsettled;
+        for (std::size_t i = 0; i < mShares.size(); ++i)
+        {
+            if (mShares[i].mInFlight + mShares[i].mWaiting > 0)
+            {
+                unsettled.push_back(i);
+            }
+        }
+
+        // experiments that want less than their weighted share get what they want, and the rest is shared again
+        double capacity = static_cast<double>(mMaxJobs);
+        double allocation = 0.0;
+        bool settled = false;
+        while (!settled && !unsettled.empty())
+        {
+            double totalWeight = 0.0;
+            BOOST_FOREACH(std::size_t i, unsettled)
+            {
+                totalWeight += mShares[i].mWeight;
+            }
+
+            double roundCapacity = capacity;
+            settled = true;
+            std::vector<std::size_t> stillUnsettled;
+            BOOST_FOREACH(std::size_t i, unsettled)
+            {
+                double demand = static_cast<double>(mShares[i].mInFlight + mShares[i].mWaiting);
+                double fairShare = roundCapacity * mShares[i].mWeight / totalWeight;
+                if (demand <= fairShare)
+                {
+                    capacity -= demand;
+                    settled = false;
+                    if (i == experimentID)
+                    {
+                        allocation = demand;
+                    }
+                }
+                else
+                {
+                    stillUnsettled.push_back(i);
+                    if (i == experimentID)
+                    {
+                        allocation = fairShare;
+                    }
+                }
+            }
+            unsettled.swap(stillUnsettled);
+        }
+
+        std::size_t quota = static_cast<std::size_t>(std::ceil(allocation));
+        const ExperimentShare& share(mShares[experimentID]);
+        return (quota > share.mInFlight) ? quota - share.mInFlight : 1;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include "ResultsReceiver.hpp"
+
+namespace GridGALib
+{
+    enum DispatchPolicy
+    {
+        DISPATCH_FAIR_SHARE,
+        DISPATCH_PRIORITY,
+        DISPATCH_UNKNOWN
+    };
+
+    typedef boost::function<bool (void)> DispatchCancelledFunc;
+
+    // Decides which experiment's jobs are submitted next when run_ga runs several experiments, so that together they
+    // never have more than max-jobs in flight. An experiment's submit thread asks for as many jobs as it has waiting
+    // and is told how many it may submit now, blocking until it's its turn.
+    //
+    //   fair-share   jobs are shared out in proportion to the experiments' weights, and the experiment furthest below
+    //                its share goes first. A share that isn't being used, e.g. while an experiment breeds its next
+    //                generation, is handed to the others until it's wanted again.
+    //   priority     the experiment with the highest weight submits everything it has before the others get a slot
+    //
+    // With max-jobs 0 nothing is held back and every request is granted in full.
+	class DispatchScheduler : boost::noncopyable
+    {
+    public:
+        DispatchScheduler(std::size_t maxJobs, DispatchPolicy policy);
+        // experiments are numbered in the order they are added, as they are by ResultsReceiver::AddExperiment()
+        std::size_t AddExperiment(double weight);
+        // returns the number of jobs granted, at least 1, or 0 if cancelled returned true while waiting
+        std::size_t Acquire(std::size_t experimentID, std::size_t numJobs, DispatchCancelledFunc cancelled);
+        void Release(std::size_t experimentID, std::size_t numJobs);
+        std::size_t GetMaxJobs(void) const;
+
+        static DispatchPolicy PolicyFromString(const std::string& policy);
+    private:
+        struct ExperimentShare
+        {
+            double mWeight;
+            std::size_t mInFlight;
+            std::size_t mWaiting;
+        };
+
+        std::size_t mMaxJobs;
+        DispatchPolicy mPolicy;
+        std::size_t mNumInFlight;
+        std::vector<ExperimentShare> mShares;
+        boost::mutex mMutex;
+        boost::condition_variable mJobsReleased;
+
+        bool IsNext(std::size_t experimentID) const;
+        std::size_t GetQuota(std::size_t experimentID) const;
+    };
+
+    // What an experiment needs to run alongside others in one run_ga: the results port they share, the scheduler
+    // and its id on both
+    struct SharedExecution
+    {
+        boost::shared_ptr<ResultsReceiver> mResultsReceiver;
+        boost::shared_ptr<DispatchScheduler> mScheduler;
+        std::size_t mExperimentID;
+        // e.g. tcp://gridga-master:55566, where the wrappers send their results
+        std::string mServer;
+        boost::int32_t mPort;
+    };
+}
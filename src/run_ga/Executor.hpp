@@ -0,0 +1,20 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include "Genome.hpp"
+
+namespace GridGALib
+{
+    // Evaluates the genomes of each generation, selected by config.genetic-algo.execution-type. ExecuteGeneration
+    // returns once the generation is over, with the complete genomes added to the cache.
+	class Executor
+    {
+    public:
+        virtual ~Executor(void) {}
+        virtual bool ReadConfig(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap) = 0;
+        virtual bool ExecuteGeneration(GenomeList genomesToTest, GenomeList genomeCache, std::size_t generationNumber) = 0;
+        // genomes from earlier generations that are still being evaluated
+        virtual std::vector<GenomePtr> GetGenomesInFlight(void) const = 0;
+    };
+}
@@ -0,0 +1,132 @@
+#include "stdafx.hpp"
+#include "ExperimentRunner.hpp"
+
+namespace GridGALib
+{
+    ExperimentRunner::ExperimentRunner(const std::string& experimentsFileName, zmq::context_t& zmqContext)
+    :
+        mExperimentsFileName(experimentsFileName),
+        mZmqContext(zmqContext)
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+    // The GAs go first, they cancel their jobs and hand them back to the scheduler
+    ExperimentRunner::~ExperimentRunner(void)
+    {
+        mExperiments.clear();
+        if (mResultsReceiver)
+        {
+            mResultsReceiver->Stop();
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool ExperimentRunner::ReadConfig(void)
+    {
+        boost::property_tree::ptree pt;
+        try
+        {
+            boost::property_tree::read_xml(mExperimentsFileName, pt);
+        }
+        catch (std::exception& e)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Cannot read the experiments file " << mExperimentsFileName << ": " << e.what();
+            return false;
+        }
+
+        // the experiments share the process's log, so its settings are the experiments file's, not each experiment's
+        Logger::SetLevel(CommonLib::GetOptionalParameter<std::string>("experiments.log-level", pt, "spam"));
+        if (CommonLib::GetOptionalBoolParameter("experiments.async-log", pt, true))
+        {
+            Logger::StartAsync();
+        }
+
+        std::string server = CommonLib::GetOptionalParameter<std::string>("experiments.ga-server", pt, "tcp://localhost");
+        boost::int32_t port = CommonLib::GetOptionalParameter<boost::int32_t>("experiments.ga-server-port", pt, 55566);
+        std::size_t numReceiverThreads = CommonLib::GetOptionalParameter<std::size_t>("experiments.receiver-threads", pt, 2);
+        // the most jobs all the experiments may have in flight at once, 0 for no limit
+        std::size_t maxJobs = CommonLib::GetOptionalParameter<std::size_t>("experiments.max-jobs", pt, 0);
+        // fair-share | priority
+        std::string scheduling = CommonLib::GetOptionalParameter<std::string>("experiments.scheduling", pt, "fair-share");
+        DispatchPolicy policy = DispatchScheduler::PolicyFromString(scheduling);
+        if (policy == DISPATCH_UNKNOWN)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Unknown scheduling: " << scheduling;
+            return false;
+        }
+
+        mResultsReceiver = boost::make_shared<ResultsReceiver>(boost::ref(mZmqContext), port, numReceiverThreads);
+        mScheduler = boost::make_shared<DispatchScheduler>(maxJobs, policy);
+
+        std::string experimentsLocation = boost::filesystem::path(mExperimentsFileName).parent_path().string();
+        if (experimentsLocation.empty())
+        {
+            experimentsLocation = ".";
+        }
+
+        BOOST_FOREACH(const boost::property_tree::ptree::value_type& item, pt.get_child("experiments", boost::property_tree::ptree()))
+        {
+            if (item.first.compare("experiment") != 0)
+            {
+                continue;
+            }
+
+            std::string dir = boost::trim_copy(item.second.data());
+            if (!boost::filesystem::path(dir).is_absolute())
+            {
+                dir = experimentsLocation + "/" + dir;
+            }
+            if (mExperiments.size() > std::numeric_limits<boost::uint16_t>::max())
+            {
+                FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Too many experiments, the most is " << std::numeric_limits<boost::uint16_t>::max() + 1;
+                return false;
+            }
+
+            // the wrappers send the id back with their results
+            SharedExecution sharedExecution;
+            sharedExecution.mResultsReceiver = mResultsReceiver;
+            sharedExecution.mScheduler = mScheduler;
+            sharedExecution.mExperimentID = mResultsReceiver->AddExperiment();
+            mScheduler->AddExperiment(CommonLib::GetOptionalParameter<double>("<xmlattr>.weight", item.second, 1.0));
+            sharedExecution.mServer = server + ":" + CommonLib::SomethingToString(port);
+            sharedExecution.mPort = port;
+
+            boost::shared_ptr<GeneticAlgo> geneticAlgo(boost::make_shared<GeneticAlgo>(dir, boost::ref(mZmqContext)));
+            geneticAlgo->SetSharedExecution(sharedExecution);
+            if (!geneticAlgo->ReadConfig())
+            {
+                FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Cannot read the config of experiment " << sharedExecution.mExperimentID << " in " << dir;
+                return false;
+            }
+            FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Experiment " << sharedExecution.mExperimentID << " is " << dir;
+            mExperiments.push_back(geneticAlgo);
+        }
+
+        if (mExperiments.empty())
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "No experiments in " << mExperimentsFileName;
+            return false;
+        }
+
+        // every experiment has added its staged files by now
+        return mResultsReceiver->Start();
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ExperimentRunner::Run(void)
+    {
+        std::cout << "Running " << mExperiments.size() << " experiments" << std::endl;
+        boost::thread_group threads;
+        BOOST_FOREACH(boost::shared_ptr<GeneticAlgo> geneticAlgo, mExperiments)
+        {
+            threads.create_thread(boost::bind(&GeneticAlgo::Evolve, geneticAlgo.get()));
+        }
+        threads.join_all();
+
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "All " << mExperiments.size() << " experiments have finished";
+        std::cout << "All " << mExperiments.size() << " experiments have finished" << std::endl;
+    }
+}
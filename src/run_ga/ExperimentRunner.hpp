@@ -0,0 +1,40 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include "DispatchScheduler.hpp"
+#include "GeneticAlgo.hpp"
+#include "ResultsReceiver.hpp"
+
+namespace GridGALib
+{
+    // Runs several experiments in one run_ga, each with its own directory, config and cache as if it had been run on
+    // its own, but sharing one results port and one limit on the jobs in flight. The experiments file looks like
+    //
+    //   <experiments>
+    //       <ga-server>tcp://gridga-master</ga-server>
+    //       <ga-server-port>55566</ga-server-port>
+    //       <receiver-threads>4</receiver-threads>
+    //       <max-jobs>2000</max-jobs>
+    //       <scheduling>fair-share</scheduling>
+    //       <experiment weight="2">momentum</experiment>
+    //       <experiment>mean-reversion</experiment>
+    //   </experiments>
+    //
+    // where the experiment directories are relative to the file unless absolute. Each experiment's GA runs on its own
+    // thread. The ga-server settings in the experiments' configs are ignored.
+	class ExperimentRunner : boost::noncopyable
+    {
+    public:
+        ExperimentRunner(const std::string& experimentsFileName, zmq::context_t& zmqContext);
+        ~ExperimentRunner(void);
+        bool ReadConfig(void);
+        void Run(void);
+    private:
+        std::string mExperimentsFileName;
+        zmq::context_t& mZmqContext;
+        boost::shared_ptr<ResultsReceiver> mResultsReceiver;
+        boost::shared_ptr<DispatchScheduler> mScheduler;
+        std::vector<boost::shared_ptr<GeneticAlgo> > mExperiments;
+    };
+}
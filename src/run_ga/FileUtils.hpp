@@ -98,5 +98,22 @@ return "TODO";
 
         //______________________________________________________________________________________________________________
 
+        inline std::string GetHostName(void)
+        {
+#ifdef _WIN32
+            const char* host = getenv("COMPUTERNAME");
+            return host ? host : "undefined";
+#else
+            char host[256] = {0};
+            if (gethostname(host, sizeof(host) - 1) != 0)
+            {
+                return "undefined";
+            }
+            return host;
+#endif
+        }
+
+        //______________________________________________________________________________________________________________
+
     }
 }
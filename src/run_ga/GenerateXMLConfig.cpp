@@ -5,6 +5,10 @@
 namespace GridGALib
 {
 	GenerateXMLConfig::GenerateXMLConfig()
+    :
+        mIsXML(true),
+        mNumParameters(0),
+        mLiteralSize(0)
     {
     }
 
@@ -16,34 +20,94 @@ namespace GridGALib
 
     //______________________________________________________________________________________________________________
 
-    void GenerateXMLConfig::ParseConfigBlocks(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap)
+    std::string GenerateXMLConfig::GetSlotMarker(std::size_t slot) const
+    {
+        std::ostringstream s;
+        s << "@@ga-slot-" << slot << "@@";
+        return s.str();
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool GenerateXMLConfig::FindParameter(const std::string& parameterID, const GAParameterMapPtr parameterMap, Slot& slot) const
+    {
+        boost::int32_t index = 0;
+        BOOST_FOREACH(GAParameterMap::value_type& parameter, *parameterMap)
+        {
+            if (boost::iequals(parameterID, parameter.second->GetIdentifier()))
+            {
+                slot.mParameterID = parameter.first;
+                slot.mIndex = index;
+                return true;
+            }
+            ++index;
+        }
+
+        if (boost::iequals(parameterID, "genome-id"))
+        {
+            slot.mParameterID.clear();
+            slot.mIndex = -1;
+            return true;
+        }
+        return false;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GenerateXMLConfig::AddSlots(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap)
     {
         // recursively iterate the XML config file
         BOOST_FOREACH(boost::property_tree::ptree::value_type& configBlock, pt)
         {
-            ParseConfigBlocks(configBlock.second, parameterMap);
+            AddSlots(configBlock.second, parameterMap);
             if (configBlock.second.get_child_optional("<xmlattr>.ga-subst"))
             {
-                BOOST_FOREACH(GAParameterMap::value_type& parameter, *parameterMap)
+                Slot slot;
+                if (FindParameter(configBlock.second.get_child("<xmlattr>").get<std::string>("ga-subst"), parameterMap, slot))
                 {
-                    if (boost::iequals(configBlock.second.get_child("<xmlattr>").get<std::string>("ga-subst"), parameter.second->GetIdentifier()))
-                    {
-                        configBlock.second.put_value<std::string>(parameter.second->GetValueForConfig());
-                    }
+                    configBlock.second.put_value<std::string>(GetSlotMarker(mSlots.size()));
+                    mSlots.push_back(slot);
                 }
             }
         }
     }
 
     //______________________________________________________________________________________________________________
-
-    std::string GenerateXMLConfig::GetConfigForGA(const GenomePtr genome, const std::string& dir)
+    // format is xml or text. If it isn't given, templates ending in .xml are xml and anything else is text.
+    bool GenerateXMLConfig::Compile(const std::string& configTemplateFileName, const std::string& format, const GAParameterMapPtr parameterMap)
     {
+        mConfigXMLTemplateFileName = configTemplateFileName;
+        mConfigExtension = boost::filesystem::path(configTemplateFileName).extension().string();
+        mNumParameters = parameterMap->size();
+        mLiteralSize = 0;
+        mSegments.clear();
+        mSlots.clear();
+
         if (!boost::filesystem::exists(mConfigXMLTemplateFileName))
         {
             FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- Cannot find template file "  << mConfigXMLTemplateFileName;
+            return false;
+        }
+
+        mIsXML = format.empty() ? boost::iequals(mConfigExtension, ".xml") : boost::iequals(format, "xml");
+        if (!mIsXML && !boost::iequals(format, "text") && !format.empty())
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- Unknown template format "  << format;
+            return false;
         }
 
+        bool ok = mIsXML ? CompileXML(parameterMap) : CompileText(parameterMap);
+        if (ok)
+        {
+            FILE_LOG(logINFO) << __FUNCTION_NAME__ << "- Compiled template " << mConfigXMLTemplateFileName << " with " << mSlots.size() << " slots.";
+        }
+        return ok;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool GenerateXMLConfig::CompileXML(const GAParameterMapPtr parameterMap)
+    {
         // read in the file line by line to remove spaces as the read_xml directly from file fucks up the output.
         std::ifstream inFile(mConfigXMLTemplateFileName.c_str());
         std::ostringstream s;
@@ -60,20 +124,168 @@ namespace GridGALib
         inFile.close();
 
         boost::property_tree::ptree pt;
-        std::istringstream input(s.str());
-        read_xml(input, pt);
-
-        ParseConfigBlocks(pt, genome->GetParameters());
+        try
+        {
+            std::istringstream input(s.str());
+            read_xml(input, pt);
+        }
+        catch (std::exception& e)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- Cannot load template file "  << mConfigXMLTemplateFileName << " : " << e.what();
+            return false;
+        }
 
-        pt.put("config.genetic-algo.genome-id", genome->GetGenomeID());
+        // put a marker where each value goes and write the template out once, then cut the output up at the markers
+        AddSlots(pt, parameterMap);
+        Slot genomeIDSlot = { "", -1 };
+        pt.put("config.genetic-algo.genome-id", GetSlotMarker(mSlots.size()));
+        mSlots.push_back(genomeIDSlot);
 
-        std::ostringstream output;  
+        std::ostringstream output;
         boost::property_tree::xml_writer_settings<typename boost::property_tree::ptree::key_type> settings(' ', 4);
         boost::property_tree::xml_parser::write_xml(output, pt, settings);
+        std::string text(output.str());
+
+        std::vector<Slot> slots;
+        slots.swap(mSlots);
+        std::size_t segmentStart = 0;
+        std::size_t markerStart;
+        while ((markerStart = text.find("@@ga-slot-", segmentStart)) != std::string::npos)
+        {
+            std::size_t numberStart = markerStart + strlen("@@ga-slot-");
+            std::size_t markerEnd = text.find("@@", numberStart);
+            std::size_t slot = static_cast<std::size_t>(atoi(text.c_str() + numberStart));
+            if (markerEnd == std::string::npos || slot >= slots.size())
+            {
+                break;
+            }
+            mSegments.push_back(text.substr(segmentStart, markerStart - segmentStart));
+            mSlots.push_back(slots[slot]);
+            segmentStart = markerEnd + 2;
+        }
+        mSegments.push_back(text.substr(segmentStart));
+        mLiteralSize = text.size();
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Any text file, e.g. JSON, INI, YAML or key=value, with {{parameter id}} wherever a value goes and
+    // {{genome-id}} for the genome's id. The rest of the file is copied unchanged.
+    bool GenerateXMLConfig::CompileText(const GAParameterMapPtr parameterMap)
+    {
+        std::ifstream inFile(mConfigXMLTemplateFileName.c_str(), std::ios::binary);
+        std::ostringstream s;
+        s << inFile.rdbuf();
+        std::string text(s.str());
 
-        //boost::property_tree::xml_writer_settings<char> settings(' ', 4);
-        //boost::property_tree::xml_parser::write_xml(output, pt, settings);
-        return output.str();
+        std::string literal;
+        std::size_t pos = 0;
+        std::size_t open;
+        while ((open = text.find("{{", pos)) != std::string::npos)
+        {
+            std::size_t close = text.find("}}", open + 2);
+            if (close == std::string::npos)
+            {
+                break;
+            }
+
+            Slot slot;
+            std::string parameterID(boost::trim_copy(text.substr(open + 2, close - open - 2)));
+            literal.append(text, pos, open - pos);
+            if (FindParameter(parameterID, parameterMap, slot))
+            {
+                mSegments.push_back(literal);
+                mSlots.push_back(slot);
+                literal.clear();
+            }
+            else
+            {
+                FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "- " << mConfigXMLTemplateFileName << " has no parameter named " << parameterID << ", leaving it as it is.";
+                literal.append(text, open, close + 2 - open);
+            }
+            pos = close + 2;
+        }
+        literal.append(text, pos, std::string::npos);
+        mSegments.push_back(literal);
+        mLiteralSize = text.size();
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    std::string GenerateXMLConfig::Render(const GenomePtr genome) const
+    {
+        const GAParameterMap& parameters = *genome->GetParameters();
+
+        // every genome has the parameters in the same order as the map the template was compiled with
+        std::vector<const GenomeParameter*> byIndex;
+        if (parameters.size() == mNumParameters)
+        {
+            byIndex.reserve(parameters.size());
+            BOOST_FOREACH(const GAParameterMap::value_type& parameter, parameters)
+            {
+                byIndex.push_back(parameter.second.get());
+            }
+        }
+
+        std::string config;
+        config.reserve(mLiteralSize + (16 * mSlots.size()));
+        for (std::size_t i = 0; i < mSlots.size(); ++i)
+        {
+            config += mSegments[i];
+            if (mSlots[i].mIndex < 0)
+            {
+                config += CommonLib::SomethingToString(genome->GetGenomeID());
+            }
+            else if (!byIndex.empty())
+            {
+                AppendValue(config, byIndex[mSlots[i].mIndex]->GetValueForConfig());
+            }
+            else
+            {
+                GAParameterMap::const_iterator parameter = parameters.find(mSlots[i].mParameterID);
+                if (parameter != parameters.end())
+                {
+                    AppendValue(config, parameter->second->GetValueForConfig());
+                }
+            }
+        }
+        config += mSegments.back();
+        return config;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GenerateXMLConfig::AppendValue(std::string& config, const std::string& value) const
+    {
+        config += mIsXML ? CommonLib::EscapeXML(value) : value;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Keeps the template's extension so programs that go by it still recognise the file
+    std::string GenerateXMLConfig::GetConfigFileName(const std::string& genomeID) const
+    {
+        return genomeID + "_config" + mConfigExtension;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    //______________________________________________________________________________________________________________
+    // Writes the genome's config into dir and returns its path, for transfer_input_files
+    std::string GenerateXMLConfig::GetConfigForGA(const GenomePtr genome, const std::string& dir)
+    {
+        return WriteConfig(CommonLib::SomethingToString(genome->GetGenomeID()), Render(genome), dir);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    std::string GenerateXMLConfig::WriteConfig(const std::string& genomeID, const std::string& config, const std::string& dir) const
+    {
+        std::string fileName(dir + "/" + GetConfigFileName(genomeID));
+        std::ofstream outFile(fileName.c_str(), std::ios::binary);
+        outFile.write(config.c_str(), static_cast<std::streamsize>(config.size()));
+        outFile.close();
+        return fileName;
     }
 
     //______________________________________________________________________________________________________________
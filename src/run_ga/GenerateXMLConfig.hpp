@@ -7,12 +7,24 @@
 
 namespace GridGALib
 {
+    // Writes a config file for each genome from a template. In an XML template the value of every element with a
+    // ga-subst="<parameter id>" attribute is replaced by the genome's value for that parameter, e.g.
+    //   <c ga-subst="c">0</c>
+    // Any other kind of file (JSON, INI, YAML, key=value...) is a text template with {{<parameter id>}} placeholders.
+    // The template is parsed once by Compile() into literal text and parameter slots, so rendering a genome is
+    // only a string append per segment.
 	class GenerateXMLConfig
     {
     public:
         GenerateXMLConfig(); //std::string configTemplateFileName, zmq::context_t& zmqContext);
         ~GenerateXMLConfig(void);
+        bool Compile(const std::string& configTemplateFileName, const std::string& format, const GAParameterMapPtr parameterMap);
+        std::string Render(const GenomePtr genome) const;
         std::string GetConfigForGA(const GenomePtr genome, const std::string& dir);
+        // writes a config already rendered, and returns its path
+        std::string WriteConfig(const std::string& genomeID, const std::string& config, const std::string& dir) const;
+
+        std::string GetConfigFileName(const std::string& genomeID) const;
 
         //void ReadConfig(void);
         //void Evolve(void);
@@ -44,10 +56,28 @@ namespace GridGALib
         CrossFunc mCross;
         std::string mExecutable;
         GetGenomeConfigFunc mGetGenomeConfig;*/
-        std::string mConfigXMLTemplateFileName;
+        struct Slot
+        {
+            std::string mParameterID;
+            // position of the parameter in the genome's parameter map, or -1 for the genome id
+            boost::int32_t mIndex;
+        };
 
+        std::string mConfigXMLTemplateFileName;
+        std::string mConfigExtension;
+        bool mIsXML;
+        std::size_t mNumParameters;
+        std::size_t mLiteralSize;
+        // always one more segment than slots, the text before each slot followed by whatever is left
+        std::vector<std::string> mSegments;
+        std::vector<Slot> mSlots;
 
-        void ParseConfigBlocks(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap);
+        bool FindParameter(const std::string& parameterID, const GAParameterMapPtr parameterMap, Slot& slot) const;
+        void AddSlots(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap);
+        bool CompileXML(const GAParameterMapPtr parameterMap);
+        bool CompileText(const GAParameterMapPtr parameterMap);
+        void AppendValue(std::string& config, const std::string& value) const;
+        std::string GetSlotMarker(std::size_t slot) const;
         /*bool GAParametersOk(const GAParameterMapPtr parameters);
         GenomePtr CreateRandomGenome(void);
         void CrossBySlicing(const GenomePtr parent1, const GenomePtr parent2, GenomePtr child1, GenomePtr child2);
@@ -6,6 +6,12 @@ namespace GridGALib
 	GeneticAlgo::GeneticAlgo(std::string filesLocation, zmq::context_t& zmqContext)
     :
         mGenomeCache(boost::make_shared<std::deque<GenomePtr> >()),
+        mInitialPopulation(DESIGN_RANDOM),
+        mMaximinIterations(1000),
+        mExhaustiveSearch(true),
+        mExhaustiveMaxPoints(0),
+        mExhaustiveCoveragePercent(90.0),
+        mSeedGenomes(boost::make_shared<std::deque<GenomePtr> >()),
         mFilesLocation(filesLocation),
         mGAPort(55577),
         mZmqContext(zmqContext),
@@ -20,8 +26,20 @@ namespace GridGALib
 
     //______________________________________________________________________________________________________________
 
+    void GeneticAlgo::SetSharedExecution(const SharedExecution& sharedExecution)
+    {
+        mSharedExecution = sharedExecution;
+        // the experiments' metrics and traces would otherwise be mixed up in one file
+        mMetrics.reset(new Metrics);
+        mTraceRecorder.reset(new TraceRecorder);
+    }
+
+    //______________________________________________________________________________________________________________
+
     bool GeneticAlgo::ReadConfig(void)
     {
+        ScopedMetricsInstance metricsInstance(mMetrics.get());
+        ScopedTraceInstance traceInstance(mTraceRecorder.get());
         boost::replace_all(mFilesLocation, "\\", "/");
 
         std::string configTemplateFileName = CommonLib::GetConfigFileNameIfExists(mFilesLocation);
@@ -54,21 +72,33 @@ namespace GridGALib
         mNumNewRandomGenomes = CommonLib::GetOptionalParameter<std::size_t>("config.genetic-algo.num-new-random-genomes", pt, 2);
         mNumGenerations = CommonLib::GetOptionalParameter<std::size_t>("config.genetic-algo.num-generations", pt, 5);
 
+        // random | lhs | sobol | maximin-lhs, how the first generation is spread over the parameters' values
+        std::string initialPopulation = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.initial-population", pt, "random");
+        mInitialPopulation = SpaceFilling::FromString(initialPopulation);
+        if (mInitialPopulation == DESIGN_UNKNOWN)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Unknown initial population: " << initialPopulation;
+            return false;
+        }
+        mMaximinIterations = CommonLib::GetOptionalParameter<std::size_t>("config.genetic-algo.maximin-iterations", pt, 1000);
+
         mUsingRecordedSignals = CommonLib::GetOptionalBoolParameter("config.backtest.use-recorded-signals", pt, false);
 
-        std::string executionType = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.execution-type", pt, "not-set");
-        if (boost::iequals(executionType, "htcondor"))
+        // Prometheus text format, rewritten every metrics-interval-seconds while waiting for results and at the end of
+        // every generation
+        std::string metricsFile = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.metrics-file", pt, "");
+        if (!metricsFile.empty())
         {
-            mHTCondor.reset(new HTCondor(mFilesLocation, mZmqContext));
-            if (!mHTCondor->ReadConfig(pt))
-            {
-                return false;
-            }
+            Metrics::Instance().SetFileName(mFilesLocation + "/" + metricsFile,
+                CommonLib::GetOptionalParameter<std::size_t>("config.genetic-algo.metrics-interval-seconds", pt, 10));
         }
-        else
+
+        // Chrome trace_event JSON of each generation's phases and of the jobs, for Perfetto
+        std::string traceFile = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.trace-file", pt, "");
+        if (!traceFile.empty())
         {
-            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Execution type not set! Please check the entry config.genetic-algo.execution-type in the config.";
-            return false;
+            TraceRecorder::Instance().SetFileName(mFilesLocation + "/" + traceFile,
+                CommonLib::GetOptionalParameter<std::size_t>("config.genetic-algo.trace-sample-percent", pt, 100));
         }
 
         // read the parameters
@@ -118,6 +148,69 @@ namespace GridGALib
             }
         }
 
+        // Small spaces, e.g. a few exp-2 and categorical parameters, are enumerated rather than bred. By default that's
+        // when the run would evaluate as many genomes as there are points anyway.
+        mSearchSpace.SetParameters(*mParameterMap);
+        mExhaustiveSearch = CommonLib::GetOptionalBoolParameter("config.genetic-algo.exhaustive-search", pt, true);
+        mExhaustiveMaxPoints = CommonLib::GetOptionalParameter<boost::uint64_t>("config.genetic-algo.exhaustive-max-points", pt,
+            static_cast<boost::uint64_t>(mPopulationSize) * mNumGenerations);
+        mExhaustiveCoveragePercent = CommonLib::GetOptionalParameter<double>("config.genetic-algo.exhaustive-coverage-percent", pt, 90.0);
+        if (mSearchSpace.GetSize() == std::numeric_limits<boost::uint64_t>::max())
+        {
+            FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Search space has more than " << mSearchSpace.GetSize() << " points";
+        }
+        else
+        {
+            FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Search space has " << mSearchSpace.GetSize() << " points" <<
+                (mSearchSpace.IsTracked() ? "" : ", too many to track coverage");
+        }
+
+        // <seed-from> entries, used when there's no cache to restore
+        if (!mSeeder.ReadConfig(pt, mFilesLocation))
+        {
+            return false;
+        }
+
+        // htcondor | synthetic | simulated | trace-replay
+        std::string executionType = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.execution-type", pt, "not-set");
+        if (boost::iequals(executionType, "htcondor"))
+        {
+            HTCondor* htcondor = new HTCondor(mFilesLocation, mZmqContext);
+            mExecutor.reset(htcondor);
+            if (mSharedExecution)
+            {
+                htcondor->SetSharedExecution(*mSharedExecution);
+            }
+        }
+        else if (boost::iequals(executionType, "synthetic"))
+        {
+            mExecutor.reset(new SyntheticExecutor(mFilesLocation));
+        }
+        else if (boost::iequals(executionType, "simulated"))
+        {
+            mExecutor.reset(new SimulatedExecutor(mFilesLocation));
+        }
+        else if (boost::iequals(executionType, "trace-replay"))
+        {
+            mExecutor.reset(new TraceReplayExecutor(mFilesLocation));
+        }
+        else
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Execution type not set! Please check the entry config.genetic-algo.execution-type in the config.";
+            return false;
+        }
+        if (!mExecutor->ReadConfig(pt, mParameterMap))
+        {
+            return false;
+        }
+
+        // makes a run repeatable, given the same execution order of the results
+        boost::int32_t randomSeed = CommonLib::GetOptionalParameter<boost::int32_t>("config.genetic-algo.random-seed", pt, -1);
+        if (randomSeed >= 0)
+        {
+            srand(static_cast<boost::uint32_t>(randomSeed));
+        }
+
         if (!mCross)
         {
             FILE_LOG(logDEBUG) << __FUNCTION_NAME__ << "Using default genome cross function: CrossBySlicing";
@@ -171,29 +264,78 @@ namespace GridGALib
 
     void GeneticAlgo::Evolve(void)
     {
+        ScopedMetricsInstance metricsInstance(mMetrics.get());
+        ScopedTraceInstance traceInstance(mTraceRecorder.get());
         mGenerationNumber = 1;
 
-        RestoreState();      
+        if (!RestoreState())
+        {
+            SeedPopulation();
+        }
 
         while (mGenerationNumber <= mNumGenerations)
         {
             Genome::SetGenerationNumber(static_cast<boost::int32_t>(mGenerationNumber));
+            Metrics::Instance().Set(Metrics::GENERATION, static_cast<double>(mGenerationNumber));
 
             FILE_LOG(logDEBUG) << __FUNCTION_NAME__ << "Generation " << mGenerationNumber;
 
-            GenomeList genomesToTest = NextGeneration();
+            GenomeList genomesToTest;
+            {
+                ScopedTraceSpan span("NextGeneration", TraceRecorder::TRACK_GA);
+                genomesToTest = NextGeneration();
+            }
 
-            if (genomesToTest->size() == 0)
+            if (genomesToTest->size() == 0 && mGenomesInFlight.empty())
             {
-                FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "No genomes to test. Exiting.";
+                if (mSearchSpace.IsFullyCovered())
+                {
+                    FILE_LOG(logINFOwithCOUT) << __FUNCTION_NAME__ << "All " << mSearchSpace.GetSize() <<
+                        " points of the search space have been evaluated. Exiting.";
+                }
+                else
+                {
+                    FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "No genomes to test. Exiting.";
+                }
                 break;
             }
 
-            mHTCondor->ExecuteGeneration(genomesToTest, mGenomeCache, mGenerationNumber);
+            mExecutor->ExecuteGeneration(genomesToTest, mGenomeCache, mGenerationNumber);
             StoreState();
+            UpdatePopulationMetrics();
+            TraceRecorder::Instance().Write();
             ++mGenerationNumber;
 
         }
+
+        // cancels any jobs still running now, so an experiment that finishes early hands its share of max-jobs to the
+        // others instead of holding it until run_ga exits
+        mExecutor.reset();
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GeneticAlgo::UpdatePopulationMetrics(void) const
+    {
+        Metrics& metrics = Metrics::Instance();
+        std::size_t numComplete = 0;
+        double sum = 0.0;
+        double best = 0.0;
+        BOOST_FOREACH(GenomePtr genome, *mGenomeCache)
+        {
+            if (genome->IsComplete() && !genome->IsFailed())
+            {
+                best = (numComplete == 0) ? genome->GetObjective() : std::max(best, genome->GetObjective());
+                sum += genome->GetObjective();
+                ++numComplete;
+            }
+        }
+        if (numComplete > 0)
+        {
+            metrics.Set(Metrics::BEST_OBJECTIVE, best);
+            metrics.Set(Metrics::MEAN_OBJECTIVE, sum / numComplete);
+        }
+        metrics.Write(true);
     }
 
     //______________________________________________________________________________________________________________
@@ -270,22 +412,36 @@ namespace GridGALib
             return false;
         }
 
-        // will return false if an individual with the same genome already exists and is complete
-        // note that we only call this routine after a generation has been run, so there are no 'in-progress' genonmes
+        // the coverage bitmap holds the cache, the genomes in flight and those already added, so answers without the
+        // scans below for any genome on its parameters' levels
+        boost::uint64_t index = 0;
+        if (mSearchSpace.GetIndex(newGenome, index))
+        {
+            if (!mSearchSpace.Cover(index))
+            {
+                Metrics::Instance().Increment(Metrics::DUPLICATE_GENOMES);
+                return false;
+            }
+            genomesToTest->push_back(newGenome);
+            return true;
+        }
+
+        // will return false if an individual with the same genome already exists and is complete, or is still running
+        // having been carried over from the previous generation
         BOOST_FOREACH(GenomePtr genome, *mGenomeCache)
         {
-            bool match = true;
-            BOOST_FOREACH(const GAParameterMap::value_type& parameter, *(newGenome->GetParameters()))
+            if (SameParameters(newGenome, genome))
             {
-                if (parameter.second->GetHasValue() && parameter.second->InternalValue() != genome->GetInternalParameterValue(parameter.first))
-                {
-                    match = false;
-                    break;
-                }
+                Metrics::Instance().Increment(Metrics::DUPLICATE_GENOMES);
+                return false;
             }
+        }
 
-            if (match)
+        BOOST_FOREACH(GenomePtr genome, mGenomesInFlight)
+        {
+            if (SameParameters(newGenome, genome))
             {
+                Metrics::Instance().Increment(Metrics::DUPLICATE_GENOMES);
                 return false;
             }
         }
@@ -294,6 +450,123 @@ namespace GridGALib
         return true;
     }
 
+    //______________________________________________________________________________________________________________
+    // Each point of the design is mapped onto one level of every parameter. Points that land on the same levels as an
+    // earlier one are dropped, which only happens when parameters have fewer levels than the population size.
+
+    std::size_t GeneticAlgo::AddSpaceFillingGenomes(GenomeList genomesToTest, std::size_t populationSize)
+    {
+        ScopedTraceSpan span("AddSpaceFillingGenomes", TraceRecorder::TRACK_GA);
+        // seeded from rand() so config.genetic-algo.random-seed still makes the run repeatable
+        boost::random::mt19937 random(static_cast<boost::uint32_t>(rand()));
+        DesignPoints points(SpaceFilling::Generate(mInitialPopulation, populationSize, mParameterMap->size(), random, mMaximinIterations));
+
+        std::set<std::vector<std::size_t> > designLevels;
+        std::size_t numAdded = 0;
+        std::size_t numDuplicates = 0;
+        BOOST_FOREACH(const std::vector<double>& point, points)
+        {
+            GenomePtr genome(CreateRandomGenome());
+            std::vector<std::size_t> levels;
+            std::size_t dimension = 0;
+            BOOST_FOREACH(GAParameterMap::value_type& parameter, *(genome->GetParameters()))
+            {
+                std::size_t numLevels = parameter.second->GetNumLevels();
+                parameter.second->SetLevel(std::min(static_cast<std::size_t>(point[dimension++] * numLevels), numLevels - 1));
+                levels.push_back(parameter.second->GetLevel());
+            }
+
+            if (designLevels.insert(levels).second && AddGenomeToPopulation(genomesToTest, genome))
+            {
+                ++numAdded;
+            }
+            else
+            {
+                ++numDuplicates;
+            }
+        }
+
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Added " << numAdded << " genomes from a " << SpaceFilling::ToString(mInitialPopulation) <<
+            " design, " << numDuplicates << " duplicates dropped.";
+        return numAdded;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Fills the population with points of the search space that haven't been covered, picked at random. Each call
+    // hands out one generation's worth, so the space is worked through a population at a time.
+
+    std::size_t GeneticAlgo::AddUncoveredGenomes(GenomeList genomesToTest, std::size_t populationSize)
+    {
+        if (genomesToTest->size() >= populationSize)
+        {
+            return 0;
+        }
+
+        ScopedTraceSpan span("AddUncoveredGenomes", TraceRecorder::TRACK_GA);
+        boost::random::mt19937 random(static_cast<boost::uint32_t>(rand()));
+        std::size_t numAdded = 0;
+        BOOST_FOREACH(boost::uint64_t index, mSearchSpace.GetUncovered(populationSize - genomesToTest->size(), random))
+        {
+            GenomePtr genome(CreateRandomGenome());
+            mSearchSpace.SetGenome(index, genome);
+            if (AddGenomeToPopulation(genomesToTest, genome))
+            {
+                ++numAdded;
+            }
+        }
+
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Added " << numAdded << " uncovered genomes, " << mSearchSpace.GetNumCovered() <<
+            " of " << mSearchSpace.GetSize() << " points covered.";
+        return numAdded;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Rebuilds the coverage from the cache and the genomes in flight, as incomplete genomes have just been dropped
+    // from the cache. Returns true if this generation should enumerate uncovered points instead of breeding.
+
+    bool GeneticAlgo::UpdateCoverage(void)
+    {
+        if (!mSearchSpace.IsTracked())
+        {
+            return false;
+        }
+
+        mSearchSpace.ClearCoverage();
+        boost::uint64_t index = 0;
+        BOOST_FOREACH(GenomePtr genome, *mGenomeCache)
+        {
+            if (mSearchSpace.GetIndex(genome, index))
+            {
+                mSearchSpace.Cover(index);
+            }
+        }
+        BOOST_FOREACH(GenomePtr genome, mGenomesInFlight)
+        {
+            if (mSearchSpace.GetIndex(genome, index))
+            {
+                mSearchSpace.Cover(index);
+            }
+        }
+        Metrics::Instance().Set(Metrics::SEARCH_SPACE_COVERED, mSearchSpace.GetCoveredFraction());
+
+        return mExhaustiveSearch && (mSearchSpace.GetSize() <= mExhaustiveMaxPoints ||
+            mSearchSpace.GetCoveredFraction() * 100.0 >= mExhaustiveCoveragePercent);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool GeneticAlgo::SameParameters(const GenomePtr newGenome, const GenomePtr genome) const
+    {
+        BOOST_FOREACH(const GAParameterMap::value_type& parameter, *(newGenome->GetParameters()))
+        {
+            if (parameter.second->GetHasValue() && parameter.second->InternalValue() != genome->GetInternalParameterValue(parameter.first))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
     //______________________________________________________________________________________________________________
 
     void GeneticAlgo::RemoveIncomleteGenomes(void)
@@ -331,14 +604,52 @@ namespace GridGALib
 
         RemoveIncomleteGenomes();
 
+        // genomes carried over from the previous generation, which are still running, count towards the population
+        mGenomesInFlight.clear();
+        if (mExecutor)
+        {
+            mGenomesInFlight = mExecutor->GetGenomesInFlight();
+        }
+        std::size_t populationSize = mPopulationSize - std::min(mGenomesInFlight.size(), mPopulationSize);
+
         GenomeList genomesToTest = boost::make_shared<std::deque<GenomePtr> >();
 
-        // initialise the initial population with random genomes
-        if (mGenomeCache->size() == 0)
+        bool enumerate = UpdateCoverage();
+        if (mSearchSpace.IsFullyCovered())
+        {
+            FILE_LOG(logINFO) << __FUNCTION_NAME__ << "- All " << mSearchSpace.GetSize() << " points of the search space are covered";
+            return genomesToTest;
+        }
+
+        // seeds that weren't evaluated go first
+        while (!mSeedGenomes->empty() && genomesToTest->size() < populationSize)
+        {
+            if (AddGenomeToPopulation(genomesToTest, mSeedGenomes->front()))
+            {
+                ++addedCount;
+            }
+            mSeedGenomes->pop_front();
+        }
+
+        if (enumerate)
+        {
+            AddUncoveredGenomes(genomesToTest, populationSize);
+            return genomesToTest;
+        }
+
+        // initialise the initial population with random genomes. Breeding needs two parents, which a seeded cache may
+        // not have.
+        if (mGenomeCache->size() < 2)
         {
+            if (mInitialPopulation != DESIGN_RANDOM && genomesToTest->size() < populationSize)
+            {
+                addedCount += AddSpaceFillingGenomes(genomesToTest, populationSize - genomesToTest->size());
+            }
+
+            // and top it up with random ones if the design couldn't fill it
             std::size_t initialRejectionCount = 0;
             // initialise population
-            while (genomesToTest->size() < mPopulationSize)
+            while (genomesToTest->size() < populationSize)
             {
                 if (AddGenomeToPopulation(genomesToTest, CreateRandomGenome()))
                 {
@@ -363,7 +674,7 @@ namespace GridGALib
         // create some new random genomes
         std::size_t numAdded = 0;
         std::size_t i = 0;
-        while (i < mNumNewRandomGenomes)
+        while (i < mNumNewRandomGenomes && genomesToTest->size() < populationSize)
         {
             if (!AddGenomeToPopulation(genomesToTest, CreateRandomGenome()))
             {
@@ -390,8 +701,19 @@ namespace GridGALib
        
         numBreeders  = std::min(numBreeders, mGenomeCache->size()-1);
 
+        // the failed genomes are sorted to the end, and are only bred from if there aren't two that succeeded
+        std::size_t numSucceeded = 0;
+        while (numSucceeded < mGenomeCache->size() && !mGenomeCache->at(numSucceeded)->IsFailed())
+        {
+            ++numSucceeded;
+        }
+        if (numSucceeded >= 2)
+        {
+            numBreeders = std::min(numBreeders, numSucceeded);
+        }
+
         // breed and mutate
-        while ((genomesToTest->size() < mPopulationSize) && (rejectionCount < 1000))
+        while ((genomesToTest->size() < populationSize) && (rejectionCount < 1000))
         {
             GenomePtr parent1 = mGenomeCache->at(rand() % numBreeders);
             GenomePtr parent2 = mGenomeCache->at(rand() % numBreeders);
@@ -428,7 +750,7 @@ namespace GridGALib
                         ++addedCount;
                     }
 
-                    if (genomesToTest->size() < mPopulationSize)
+                    if (genomesToTest->size() < populationSize)
                     {
                         if (!AddGenomeToPopulation(genomesToTest, child2))
                         {
@@ -452,13 +774,21 @@ namespace GridGALib
         }
 
         FILE_LOG(logDEBUG) << __FUNCTION_NAME__ << "Number of mutants: " << numMutations;
+        Metrics::Instance().Increment(Metrics::MUTATIONS, numMutations);
 
         if (rejectionCount >= 1000)
         {
             FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "- Rejection count is " << rejectionCount;
         }
 
-        if (genomesToTest->size() < mPopulationSize)
+        // breeding kept producing genomes that have been seen, so fill up with ones that haven't, unless the search
+        // should only ever breed
+        if (mExhaustiveSearch && mSearchSpace.IsTracked())
+        {
+            AddUncoveredGenomes(genomesToTest, populationSize);
+        }
+
+        if (genomesToTest->size() < populationSize)
         {
             FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "- Population size is " << genomesToTest->size();
         }
@@ -516,6 +846,8 @@ namespace GridGALib
 
     void GeneticAlgo::StoreState(void) const
     {
+        ScopedMetricsTimer timer(Metrics::STORE_STATE_SECONDS);
+        ScopedTraceSpan span("StoreState", TraceRecorder::TRACK_GA);
     	boost::property_tree::xml_writer_settings<typename boost::property_tree::ptree::key_type> settings(' ', 4);
 
         //boost::property_tree::xml_writer_settings<char> settings(' ', 4);
@@ -577,6 +909,27 @@ namespace GridGALib
         return true;
     }
 
+    //______________________________________________________________________________________________________________
+    // Seeds with an objective join the cache as breeders for the first generation. The others are tested before any
+    // new genomes.
+
+    void GeneticAlgo::SeedPopulation(void)
+    {
+        if (!mSeeder.HasSources())
+        {
+            return;
+        }
+
+        GenomeList evaluated(boost::make_shared<std::deque<GenomePtr> >());
+        mSeedGenomes->clear();
+        mSeeder.Load(boost::bind(&GeneticAlgo::CreateRandomGenome, this), evaluated, mSeedGenomes);
+        mGenomeCache->insert(mGenomeCache->end(), evaluated->begin(), evaluated->end());
+        SortPopulation();
+
+        FILE_LOG(logINFOwithCOUT) << __FUNCTION_NAME__ << "Seeded the cache with " << evaluated->size() << " evaluated genomes, " <<
+            mSeedGenomes->size() << " more to test.";
+    }
+
     //______________________________________________________________________________________________________________
 
     void GeneticAlgo::SortPopulation()
@@ -605,7 +958,16 @@ namespace GridGALib
             "    <min-num-breeders>30</min-num-breeders>  <!-- The minimum number of genomes to use as breeders. -->" << std::endl <<
             "    <num-new-random-genomes>2</num-new-random-genomes>  <!-- Number of random genomes to create" << std::endl <<
             "                                                             for each generation. -->" << std::endl <<
+            "    <initial-population>random</initial-population>  <!-- How the first generation is spread over the" << std::endl <<
+            "                                                          parameters. One of: random | lhs | sobol | maximin-lhs. -->" << std::endl <<
             "    <num-generations>15</num-generations>  <!-- Stop after this many generations. -->" << std::endl <<
+            "    <seed-from best=\"100\">../previous-run/genetic-algo-cache.xml</seed-from>  <!-- Start from genomes" << std::endl <<
+            "        evaluated by another run, or listed in a .csv file, when there's no cache to restore. -->" << std::endl <<
+            "    <exhaustive-search>true</exhaustive-search>  <!-- Evaluate every point of a small search space, or the" << std::endl <<
+            "                                                      rest of a nearly covered one, instead of breeding. -->" << std::endl <<
+            "    <exhaustive-max-points>300</exhaustive-max-points>  <!-- Spaces up to this size are enumerated from the" << std::endl <<
+            "                                                            start. Defaults to population-size * num-generations. -->" << std::endl <<
+            "    <exhaustive-coverage-percent>90</exhaustive-coverage-percent>  <!-- Enumerate once this much is covered. -->" << std::endl <<
             "    <!-- The entries below are examples on how to define parameters for optimisation. -->" << std::endl <<
             "    <parameter id=\"stop-loss\" type=\"integer\" low=\"10\" high=\"200\" step=\"5\" />" << std::endl <<
             "    <parameter id=\"time-of-day\" type=\"categorical\" values=\"h1,h4,single,none\" />" << std::endl <<
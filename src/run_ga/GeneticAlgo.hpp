@@ -3,7 +3,15 @@
 #include "stdafx.hpp"
 
 #include "Genome.hpp"
+#include "GenomeSeeder.hpp"
 #include "HTCondor.hpp"
+#include "Metrics.hpp"
+#include "SearchSpace.hpp"
+#include "SimulatedExecutor.hpp"
+#include "SpaceFilling.hpp"
+#include "SyntheticObjective.hpp"
+#include "TraceRecorder.hpp"
+#include "TraceReplayExecutor.hpp"
 
 namespace GridGALib
 {
@@ -11,10 +19,15 @@ namespace GridGALib
 
 	class GeneticAlgo
     {
+        // the one way into the private operations, for gridga_bench, see src/bench/GeneticAlgoBenchAccess.hpp
+        friend class GeneticAlgoBenchAccess;
     public:
         GeneticAlgo(std::string configTemplateFileName, zmq::context_t& zmqContext);
         ~GeneticAlgo(void);
+        // must be called before ReadConfig, when run_ga is running several experiments, see ExperimentRunner
+        void SetSharedExecution(const SharedExecution& sharedExecution);
         bool ReadConfig(void);
+        // runs the generations, then cancels whatever is still running
         void Evolve(void);
         void SendTestMessage(std::string machineName, std::string sendString);
 
@@ -30,6 +43,15 @@ namespace GridGALib
         std::size_t mNumNewRandomGenomes;
         std::size_t mGenerationNumber;       
         std::size_t mNumGenerations;
+        SpaceFillingDesign mInitialPopulation;
+        std::size_t mMaximinIterations;
+        SearchSpace mSearchSpace;
+        bool mExhaustiveSearch;
+        boost::uint64_t mExhaustiveMaxPoints;
+        double mExhaustiveCoveragePercent;
+        GenomeSeeder mSeeder;
+        // seeds still to be tested, a population's worth each generation
+        GenomeList mSeedGenomes;
         boost::int32_t mCondorClusterID;
         GAParameterMapPtr mParameterMap;
         std::string mFilesLocation;
@@ -41,7 +63,12 @@ namespace GridGALib
         std::string mCacheFile;
         CrossFunc mCross;
         GetGenomeConfigFunc mGetGenomeConfig;
-        boost::scoped_ptr<HTCondor> mHTCondor;
+        // an experiment's own, when run_ga is running several, otherwise null for the process's
+        boost::scoped_ptr<Metrics> mMetrics;
+        boost::scoped_ptr<TraceRecorder> mTraceRecorder;
+        boost::scoped_ptr<Executor> mExecutor;
+        boost::optional<SharedExecution> mSharedExecution;
+        std::vector<GenomePtr> mGenomesInFlight;
 
         std::string GetConfigForGA(const GenomePtr genome, const std::string& dir);
 
@@ -51,11 +78,17 @@ namespace GridGALib
         void CrossBySlicing(const GenomePtr parent1, const GenomePtr parent2, GenomePtr child1, GenomePtr child2);
         void CrossBySwap(const GenomePtr parent1, const GenomePtr parent2, GenomePtr child1, GenomePtr child2);
         bool AddGenomeToPopulation(GenomeList genomesToTest, GenomePtr genome);
+        std::size_t AddSpaceFillingGenomes(GenomeList genomesToTest, std::size_t populationSize);
+        std::size_t AddUncoveredGenomes(GenomeList genomesToTest, std::size_t populationSize);
+        bool UpdateCoverage(void);
+        bool SameParameters(const GenomePtr newGenome, const GenomePtr genome) const;
         void RemoveIncomleteGenomes(void);
         GenomeList NextGeneration(void);
         void SendString(void* socket, const std::string& sendString) const; 
         void StoreState(void) const;
+        void UpdatePopulationMetrics(void) const;
         bool RestoreState(void);   
+        void SeedPopulation(void);
         void SortPopulation();     
     };
 }
\ No newline at end of file
@@ -4,13 +4,15 @@
 
 namespace GridGALib
 {
-    std::size_t Genome::GenomeID = 0;
+    boost::atomic<std::size_t> Genome::GenomeID(0);
 
     Genome::Genome(void)
     :
         mGenomeID(++GenomeID),
         mComplete(false),
-        mObjective(0.0)
+        mFailed(false),
+        mObjective(0.0),
+        mExecuteMs(0)
     {
     }
 
@@ -47,20 +49,29 @@ namespace GridGALib
 
         mObjective = pt.get("objective", 0.0);
         mComplete = CommonLib::GetOptionalBoolParameter("complete", pt, false);
+        mFailed = CommonLib::GetOptionalBoolParameter("failed", pt, false);
         mComputeHost = pt.get("compute-host", "undefined");
+        mExecuteMs = pt.get("execute-ms", 0);
 
-        if (mGenomeID >= GenomeID)
-        {
-            GenomeID = mGenomeID + 1;
-        }
+        RaiseGenomeID(mGenomeID + 1);
     }
 
     //______________________________________________________________________________________________________________
 
-    void Genome::Update(const boost::property_tree::ptree& pt)
+    void Genome::Update(const ResultMessage& result)
     {
-        mObjective = pt.get("results.objective", 0.0);
-        mComputeHost = pt.get("results.compute-host", "undefined");
+        mFailed = (result.mStatus != RESULT_STATUS_OK);
+        // whether the wrapper reported the error or run_ga gave up on the job, the same as the wrapper's SendError
+        if (mFailed)
+        {
+            mObjective = -1.0;
+        }
+        else
+        {
+            mObjective = result.mNumObjectives > 0 ? result.mObjectives[0] : 0.0;
+        }
+        mComputeHost = result.mHost[0] != 0 ? result.mHost : "undefined";
+        mExecuteMs = result.mExecuteMs;
         mComplete = true;
     }
 
@@ -74,12 +85,20 @@ namespace GridGALib
         {
             if (parameter.second->GetHasValue())
             {
-                genomeTree.put(parameter.second->GetIdentifier(), parameter.second->InternalValue());
+                boost::property_tree::ptree& valueTree = genomeTree.put(parameter.second->GetIdentifier(), parameter.second->InternalValue());
+                // the category's name too, so other runs can seed from this one after the list has changed
+                if (parameter.second->GetParameterType() == PARAMETER_TYPE_CATEGORICAL)
+                {
+                    valueTree.put("<xmlattr>.value", parameter.second->GetValueForConfig());
+                }
             }
         }
 
         genomeTree.put("objective", mObjective);
         genomeTree.put("complete", mComplete ? "True" : "False");
+        genomeTree.put("failed", mFailed ? "True" : "False");
+        genomeTree.put("compute-host", mComputeHost);
+        genomeTree.put("execute-ms", mExecuteMs);
     }
 
     //______________________________________________________________________________________________________________
@@ -189,6 +208,27 @@ namespace GridGALib
 
     //______________________________________________________________________________________________________________
 
+    bool Genome::IsFailed() const
+    {
+        return mFailed;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void Genome::SetSubmitTime(const boost::posix_time::ptime& submitTime)
+    {
+        mSubmitTime = submitTime;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    const boost::posix_time::ptime& Genome::GetSubmitTime(void) const
+    {
+        return mSubmitTime;
+    }
+
+    //______________________________________________________________________________________________________________
+
     std::string Genome::GetCommandLineArguments(const std::string& paramPrefix, const std::string& valuePrefix) const
     {
         std::ostringstream s;
@@ -206,7 +246,20 @@ namespace GridGALib
 
     void Genome::SetGenerationNumber(boost::int32_t generationNumber)
     {
-        GenomeID = generationNumber * 1000;
+        // never go backwards, so ids stay unique when a generation has more than 1000 genomes or genomes from an
+        // earlier generation are still running
+        RaiseGenomeID(static_cast<std::size_t>(generationNumber) * 1000);
+    }
+
+    //______________________________________________________________________________________________________________
+    // Genomes are created by every experiment's thread when run_ga runs several at once, so the counter is only ever
+    // raised with a compare and swap
+    void Genome::RaiseGenomeID(std::size_t genomeID)
+    {
+        std::size_t current = GenomeID.load();
+        while (current < genomeID && !GenomeID.compare_exchange_weak(current, genomeID))
+        {
+        }
     }
 
     //______________________________________________________________________________________________________________
@@ -2,6 +2,8 @@
 
 #include "stdafx.hpp"
 
+#include "ResultMessage.hpp"
+
 namespace GridGALib
 {
     enum ParameterType
@@ -22,6 +24,14 @@ namespace GridGALib
         virtual void SetRandomValue(void) = 0;
         virtual void SetInternalValue(boost::int32_t newValue) = 0;
         virtual ParameterType GetParameterType(void) const = 0;
+        // where the value lies in the parameter's range, 0 for the lowest and 1 for the highest
+        virtual double GetNormalisedValue(void) const = 0;
+        // the number of distinct values the parameter can take, and which of them it has, 0 being the lowest
+        virtual std::size_t GetNumLevels(void) const = 0;
+        virtual std::size_t GetLevel(void) const = 0;
+        virtual void SetLevel(std::size_t level) = 0;
+        // false if the value lies between levels or outside the range, as a mutation can leave it
+        virtual bool IsOnLevel(void) const = 0;
 
         GenomeParameter(std::string identifier)
         :
@@ -111,6 +121,48 @@ namespace GridGALib
             return PARAMETER_TYPE_INTEGER;
         }
 
+        double GetNormalisedValue(void) const override
+        {
+            if (mMax <= mMinimum)
+            {
+                return 0.0;
+            }
+            return std::min(1.0, std::max(0.0, static_cast<double>(mValue - mMinimum) / (mMax - mMinimum)));
+        }
+
+        // the levels are low, low + step, ... up to high
+        std::size_t GetNumLevels(void) const override
+        {
+            if (mMax <= mMinimum)
+            {
+                return 1;
+            }
+            return static_cast<std::size_t>((mMax - mMinimum) / std::max(mStep, 1)) + 1;
+        }
+
+        std::size_t GetLevel(void) const override
+        {
+            if (mValue <= mMinimum)
+            {
+                return 0;
+            }
+            return std::min(static_cast<std::size_t>((mValue - mMinimum) / std::max(mStep, 1)), GetNumLevels() - 1);
+        }
+
+        void SetLevel(std::size_t level) override
+        {
+            mValue = mMinimum + (static_cast<boost::int32_t>(std::min(level, GetNumLevels() - 1)) * std::max(mStep, 1));
+        }
+
+        bool IsOnLevel(void) const override
+        {
+            if (mMax <= mMinimum)
+            {
+                return mValue == mMinimum;
+            }
+            return mValue >= mMinimum && mValue <= mMax && ((mValue - mMinimum) % std::max(mStep, 1)) == 0;
+        }
+
         void SetRandomValue(void) override
         {
             mValue = mMinimum + (rand() % ((mMax+1) - mMinimum));
@@ -199,6 +251,35 @@ namespace GridGALib
             return PARAMETER_TYPE_CATEGORICAL;
         }
 
+        double GetNormalisedValue(void) const override
+        {
+            if (mCategories.size() < 2)
+            {
+                return 0.0;
+            }
+            return static_cast<double>(mIndex) / (mCategories.size() - 1);
+        }
+
+        std::size_t GetNumLevels(void) const override
+        {
+            return std::max<std::size_t>(mCategories.size(), 1);
+        }
+
+        std::size_t GetLevel(void) const override
+        {
+            return static_cast<std::size_t>(std::max(mIndex, 0));
+        }
+
+        void SetLevel(std::size_t level) override
+        {
+            mIndex = static_cast<boost::int32_t>(std::min(level, GetNumLevels() - 1));
+        }
+
+        bool IsOnLevel(void) const override
+        {
+            return mIndex >= 0 && mIndex < static_cast<boost::int32_t>(mCategories.size());
+        }
+
         void SetRandomValue(void) override
         {
             mIndex = rand() % mCategories.size();
@@ -233,29 +314,45 @@ namespace GridGALib
         double GetObjective(void) const;
         std::size_t GetGenomeID(void) const;
         void SaveAsXML(boost::property_tree::ptree& genomeTree) const;
-        void Update(const boost::property_tree::ptree& pt);
+        void Update(const ResultMessage& result);
         bool Mutate(std::size_t mutationProbability);
         std::string ToString(void) const;
         GAParameterMapPtr GetParameters() const;
         bool IsComplete(void) const;
+        // complete, but the job reported an error so the objective means nothing
+        bool IsFailed(void) const;
         std::string GetCommandLineArguments(const std::string& paramPrefix, const std::string& valuePrefix) const;
+        void SetSubmitTime(const boost::posix_time::ptime& submitTime);
+        const boost::posix_time::ptime& GetSubmitTime(void) const;
 
         static void SetGenerationNumber(boost::int32_t generationNumber);
     private:
         GAParameterMapPtr mParameters;
         std::size_t mGenomeID;
         bool mComplete;
+        bool mFailed;
         boost::int32_t mPriceMoveTarget;
         double mObjective;
         std::string mComputeHost;
-        static std::size_t GenomeID;
+        boost::uint32_t mExecuteMs;
+        // when the job was last submitted, not set until condor_submit has returned
+        boost::posix_time::ptime mSubmitTime;
+        static boost::atomic<std::size_t> GenomeID;
+
+        static void RaiseGenomeID(std::size_t genomeID);
     };
 
     typedef boost::shared_ptr<Genome> GenomePtr;
     typedef boost::shared_ptr<std::deque<GenomePtr> > GenomeList;
 
+    // Best first, with failed genomes after every real result so they're never picked as breeders, even when the
+    // real objectives are below a failed genome's
     inline bool CompareGenomeByObjective(GenomePtr i, GenomePtr j)
     {
+        if (i->IsFailed() != j->IsFailed())
+        {
+            return j->IsFailed();
+        }
         return (i->GetObjective() > j->GetObjective());
     }
 
@@ -0,0 +1,424 @@
+#include "stdafx.hpp"
+#include "GenomeSeeder.hpp"
+
+namespace GridGALib
+{
+    namespace
+    {
+        // the elements of a cached genome that aren't parameters
+        const char* CACHE_FIELDS[] = { "id", "objective", "complete", "compute-host", "execute-ms" };
+
+        //______________________________________________________________________________________________________________
+
+        bool IsCacheField(const std::string& name)
+        {
+            BOOST_FOREACH(const char* field, CACHE_FIELDS)
+            {
+                if (name == field)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //______________________________________________________________________________________________________________
+        // Levels hold increasing internal values, so the nearest is found by bisection
+
+        void SetNearestLevel(GenomeParameterPtr parameter, boost::int32_t value)
+        {
+            std::size_t low = 0;
+            std::size_t high = parameter->GetNumLevels() - 1;
+            while (low < high)
+            {
+                std::size_t middle = low + ((high - low) / 2);
+                parameter->SetLevel(middle);
+                if (parameter->InternalValue() < value)
+                {
+                    low = middle + 1;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+
+            parameter->SetLevel(low);
+            boost::int32_t above = parameter->InternalValue();
+            if (low > 0)
+            {
+                parameter->SetLevel(low - 1);
+                if (value - parameter->InternalValue() <= above - value)
+                {
+                    return;
+                }
+                parameter->SetLevel(low);
+            }
+        }
+
+        //______________________________________________________________________________________________________________
+
+        // objective, row
+        typedef std::pair<double, std::size_t> RowObjective;
+
+        bool CompareRowsByObjective(const RowObjective& i, const RowObjective& j)
+        {
+            return i.first > j.first;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    GenomeSeeder::GenomeSeeder(void)
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool GenomeSeeder::ReadConfig(const boost::property_tree::ptree& pt, const std::string& filesLocation)
+    {
+        mSources.clear();
+        BOOST_FOREACH(const boost::property_tree::ptree::value_type& item, pt.get_child("config.genetic-algo", boost::property_tree::ptree()))
+        {
+            if (!boost::iequals(item.first, "seed-from"))
+            {
+                continue;
+            }
+
+            SeedSource source;
+            source.mFileName = boost::trim_copy(item.second.data());
+            if (!boost::filesystem::path(source.mFileName).is_absolute())
+            {
+                source.mFileName = filesLocation + "/" + source.mFileName;
+            }
+
+            std::string type = item.second.get<std::string>("<xmlattr>.type",
+                boost::iends_with(source.mFileName, ".csv") ? "csv" : "cache");
+            std::string outOfRange = item.second.get<std::string>("<xmlattr>.out-of-range", "clamp");
+            std::string missing = item.second.get<std::string>("<xmlattr>.missing", "random");
+            if ((!boost::iequals(type, "csv") && !boost::iequals(type, "cache")) ||
+                (!boost::iequals(outOfRange, "clamp") && !boost::iequals(outOfRange, "skip")) ||
+                (!boost::iequals(missing, "random") && !boost::iequals(missing, "skip")))
+            {
+                FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Unknown type, out-of-range or missing setting for seed-from " << source.mFileName;
+                return false;
+            }
+            source.mCsv = boost::iequals(type, "csv");
+            source.mReevaluate = boost::iequals(item.second.get<std::string>("<xmlattr>.reevaluate", "false"), "true");
+            source.mBest = item.second.get<std::size_t>("<xmlattr>.best", 0);
+            source.mSkipOutOfRange = boost::iequals(outOfRange, "skip");
+            source.mSkipMissing = boost::iequals(missing, "skip");
+            mSources.push_back(source);
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool GenomeSeeder::HasSources(void) const
+    {
+        return !mSources.empty();
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void GenomeSeeder::Load(CreateGenomeFunc createGenome, GenomeList evaluated, GenomeList toEvaluate)
+    {
+        BOOST_FOREACH(const SeedSource& source, mSources)
+        {
+            std::vector<SeedRow> rows;
+            if (!(source.mCsv ? ReadCsv(source, rows) : ReadCache(source, rows)))
+            {
+                continue;
+            }
+
+            GenomePtr genome(createGenome());
+            std::set<std::string> unknown;
+            BOOST_FOREACH(const SeedRow& row, rows)
+            {
+                for (std::map<std::string, SeedValue>::const_iterator value = row.mValues.begin(); value != row.mValues.end(); ++value)
+                {
+                    if (genome->GetParameters()->find(value->first) == genome->GetParameters()->end())
+                    {
+                        unknown.insert(value->first);
+                    }
+                }
+            }
+            if (!unknown.empty())
+            {
+                FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "Ignoring " << boost::algorithm::join(unknown, ", ") << " in " <<
+                    source.mFileName << ", not parameters of this run";
+            }
+
+            // the best first, leaving out any without an objective
+            if (source.mBest > 0)
+            {
+                std::vector<RowObjective> order;
+                for (std::size_t i = 0; i < rows.size(); ++i)
+                {
+                    if (rows[i].mObjective)
+                    {
+                        order.push_back(std::make_pair(*rows[i].mObjective, i));
+                    }
+                }
+                std::stable_sort(order.begin(), order.end(), CompareRowsByObjective);
+                order.resize(std::min(order.size(), source.mBest));
+                std::vector<SeedRow> best;
+                for (std::size_t i = 0; i < order.size(); ++i)
+                {
+                    best.push_back(rows[order[i].second]);
+                }
+                rows.swap(best);
+            }
+
+            SeedCounts counts = { 0, 0, 0, 0 };
+            std::size_t numEvaluated = 0;
+            std::size_t numToEvaluate = 0;
+            BOOST_FOREACH(const SeedRow& row, rows)
+            {
+                genome = createGenome();
+                if (!MapRow(source, row, genome, counts))
+                {
+                    ++counts.mSkipped;
+                    continue;
+                }
+
+                std::vector<boost::int32_t> values;
+                BOOST_FOREACH(const GAParameterMap::value_type& parameter, *(genome->GetParameters()))
+                {
+                    values.push_back(parameter.second->InternalValue());
+                }
+                if (!mSeeded.insert(values).second)
+                {
+                    ++counts.mDuplicates;
+                    continue;
+                }
+
+                if (row.mObjective && !source.mReevaluate)
+                {
+                    ResultMessage result;
+                    result.Clear();
+                    result.mNumObjectives = 1;
+                    result.mObjectives[0] = *row.mObjective;
+                    result.SetHost("seed", 4);
+                    genome->Update(result);
+                    evaluated->push_back(genome);
+                    ++numEvaluated;
+                }
+                else
+                {
+                    toEvaluate->push_back(genome);
+                    ++numToEvaluate;
+                }
+            }
+
+            FILE_LOG(logINFOwithCOUT) << __FUNCTION_NAME__ << "Seeded " << numEvaluated << " evaluated genomes and " << numToEvaluate <<
+                " to evaluate from " << source.mFileName << ". " << counts.mMissing << " missing and " << counts.mOutOfRange <<
+                " out of range values, " << counts.mSkipped << " genomes skipped, " << counts.mDuplicates << " duplicates.";
+        }
+
+        std::sort(evaluated->begin(), evaluated->end(), CompareGenomeByObjective);
+    }
+
+    //______________________________________________________________________________________________________________
+    // Only complete genomes are read, as the rest never returned a result and may well not run at all
+
+    bool GenomeSeeder::ReadCache(const SeedSource& source, std::vector<SeedRow>& rows) const
+    {
+        if (!boost::filesystem::exists(source.mFileName))
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Cannot find the cache " << source.mFileName;
+            return false;
+        }
+
+        boost::property_tree::ptree cachePt;
+        try
+        {
+            boost::property_tree::xml_parser::read_xml(source.mFileName, cachePt);
+        }
+        catch (std::exception& e)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Cannot read the cache " << source.mFileName << ": " << e.what();
+            return false;
+        }
+
+        BOOST_FOREACH(const boost::property_tree::ptree::value_type& item, cachePt.get_child("state", boost::property_tree::ptree()))
+        {
+            if (item.first.compare("genome") != 0 || !CommonLib::GetOptionalBoolParameter("complete", item.second, false))
+            {
+                continue;
+            }
+
+            SeedRow row;
+            row.mObjective = item.second.get("objective", 0.0);
+            BOOST_FOREACH(const boost::property_tree::ptree::value_type& field, item.second)
+            {
+                if (IsCacheField(field.first))
+                {
+                    continue;
+                }
+                // categories are matched by name where the cache has it, as the list may have changed since
+                boost::optional<std::string> category = field.second.get_optional<std::string>("<xmlattr>.value");
+                SeedValue value = { category ? *category : boost::trim_copy(field.second.data()), !category };
+                row.mValues[field.first] = value;
+            }
+            rows.push_back(row);
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool GenomeSeeder::ReadCsv(const SeedSource& source, std::vector<SeedRow>& rows) const
+    {
+        std::ifstream file(source.mFileName.c_str());
+        if (!file)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Cannot open " << source.mFileName;
+            return false;
+        }
+
+        std::vector<std::string> header;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            boost::trim(line);
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+
+            std::vector<std::string> cells;
+            boost::split(cells, line, boost::is_any_of(",;\t"));
+            BOOST_FOREACH(std::string& cell, cells)
+            {
+                boost::trim(cell);
+            }
+
+            if (header.empty())
+            {
+                header = cells;
+                continue;
+            }
+
+            SeedRow row;
+            for (std::size_t i = 0; i < std::min(header.size(), cells.size()); ++i)
+            {
+                if (cells[i].empty())
+                {
+                    continue;
+                }
+                if (boost::iequals(header[i], "objective"))
+                {
+                    try
+                    {
+                        row.mObjective = boost::lexical_cast<double>(cells[i]);
+                    }
+                    catch (boost::bad_lexical_cast&)
+                    {
+                        FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "Ignoring objective " << cells[i] << " in " << source.mFileName;
+                    }
+                    continue;
+                }
+                SeedValue value = { cells[i], false };
+                row.mValues[header[i]] = value;
+            }
+            rows.push_back(row);
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+    // The genome comes with random values, which are kept for any parameter the row doesn't give
+
+    bool GenomeSeeder::MapRow(const SeedSource& source, const SeedRow& row, GenomePtr genome, SeedCounts& counts) const
+    {
+        BOOST_FOREACH(GAParameterMap::value_type& parameter, *(genome->GetParameters()))
+        {
+            std::map<std::string, SeedValue>::const_iterator value = row.mValues.find(parameter.first);
+            bool onLevel = true;
+            if (value == row.mValues.end() || !MapValue(value->second, parameter.second, onLevel))
+            {
+                ++counts.mMissing;
+                if (source.mSkipMissing)
+                {
+                    return false;
+                }
+                parameter.second->SetRandomValue();
+                continue;
+            }
+
+            if (!onLevel)
+            {
+                ++counts.mOutOfRange;
+                if (source.mSkipOutOfRange)
+                {
+                    return false;
+                }
+                SetNearestLevel(parameter.second, parameter.second->InternalValue());
+            }
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Sets the parameter to the value, which may be off its levels. Returns false if the value can't be read, or is a
+    // category the parameter doesn't have.
+
+    bool GenomeSeeder::MapValue(const SeedValue& value, GenomeParameterPtr parameter, bool& onLevel) const
+    {
+        if (parameter->GetParameterType() == PARAMETER_TYPE_CATEGORICAL && !value.mInternal)
+        {
+            for (std::size_t level = 0; level < parameter->GetNumLevels(); ++level)
+            {
+                parameter->SetLevel(level);
+                if (parameter->GetValueForConfig() == value.mText)
+                {
+                    onLevel = true;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        double number = 0.0;
+        try
+        {
+            number = boost::lexical_cast<double>(value.mText);
+        }
+        catch (boost::bad_lexical_cast&)
+        {
+            return false;
+        }
+
+        // exp-2 parameters are passed as 2^value
+        bool exp2 = (parameter->GetParameterType() == PARAMETER_TYPE_EXP_2 && !value.mInternal);
+        double passedValue = number;
+        if (exp2)
+        {
+            if (number <= 0.0)
+            {
+                return false;
+            }
+            number = std::log(number) / std::log(2.0);
+        }
+
+        double internalValue = std::floor(number + 0.5);
+        if (internalValue < std::numeric_limits<boost::int32_t>::min() || internalValue > std::numeric_limits<boost::int32_t>::max())
+        {
+            return false;
+        }
+        parameter->SetInternalValue(static_cast<boost::int32_t>(internalValue));
+        if (exp2)
+        {
+            // as written by std::to_string for the executable, e.g. 0.003906 for -8
+            onLevel = (std::to_string(passedValue) == std::to_string(std::pow(2.0, internalValue)));
+        }
+        else
+        {
+            onLevel = (std::fabs(number - internalValue) < 1e-9);
+        }
+        onLevel = onLevel && parameter->IsOnLevel();
+        return true;
+    }
+}
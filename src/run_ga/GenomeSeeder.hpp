@@ -0,0 +1,73 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include "Genome.hpp"
+
+namespace GridGALib
+{
+    typedef boost::function<GenomePtr (void)> CreateGenomeFunc;
+
+    // Warm starts a run from genomes evaluated by other runs, or picked by hand, when it has no cache of its own to
+    // restore. Each <seed-from> entry in config.genetic-algo names a file, relative to the run's directory unless
+    // absolute, with these optional attributes:
+    //   type          cache | csv, by default csv for .csv files, otherwise another run's genetic-algo-cache.xml
+    //   reevaluate    true to test the genomes again rather than take their objectives as they are
+    //   best          only the best this many genomes with an objective, 0 for all
+    //   out-of-range  clamp | skip, for values outside a parameter's range or between its levels
+    //   missing       random | skip, for parameters the file doesn't have or values that can't be mapped
+    //
+    // A CSV file has a header row of parameter ids, and an optional objective column. Its values are written as they
+    // are passed to the executable, i.e. 32 rather than 5 for an exp-2 parameter and the name of a category. Columns and
+    // cache entries that aren't one of this run's parameters are ignored.
+	class GenomeSeeder : boost::noncopyable
+    {
+    public:
+        GenomeSeeder(void);
+        bool ReadConfig(const boost::property_tree::ptree& pt, const std::string& filesLocation);
+        bool HasSources(void) const;
+        // genomes with an objective go to evaluated, sorted best first, and the rest to toEvaluate
+        void Load(CreateGenomeFunc createGenome, GenomeList evaluated, GenomeList toEvaluate);
+    private:
+        struct SeedSource
+        {
+            std::string mFileName;
+            bool mCsv;
+            bool mReevaluate;
+            std::size_t mBest;
+            bool mSkipOutOfRange;
+            bool mSkipMissing;
+        };
+
+        struct SeedValue
+        {
+            std::string mText;
+            // an internal value from a cache, otherwise a value as it's passed to the executable
+            bool mInternal;
+        };
+
+        // one genome read from a file, before it's been mapped onto the parameters
+        struct SeedRow
+        {
+            std::map<std::string, SeedValue> mValues;
+            boost::optional<double> mObjective;
+        };
+
+        struct SeedCounts
+        {
+            std::size_t mMissing;
+            std::size_t mOutOfRange;
+            std::size_t mSkipped;
+            std::size_t mDuplicates;
+        };
+
+        std::vector<SeedSource> mSources;
+        // internal values in parameter order, of every genome seeded so far
+        std::set<std::vector<boost::int32_t> > mSeeded;
+
+        bool ReadCache(const SeedSource& source, std::vector<SeedRow>& rows) const;
+        bool ReadCsv(const SeedSource& source, std::vector<SeedRow>& rows) const;
+        bool MapRow(const SeedSource& source, const SeedRow& row, GenomePtr genome, SeedCounts& counts) const;
+        bool MapValue(const SeedValue& value, GenomeParameterPtr parameter, bool& onLevel) const;
+    };
+}
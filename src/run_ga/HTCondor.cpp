@@ -6,13 +6,26 @@ namespace GridGALib
 	HTCondor::HTCondor(std::string filesLocation, zmq::context_t& zmqContext)
     :
         mGenerationNumber(0),
+        mCondorClusterID(-1),
         mFilesLocation(filesLocation),
         mZmqContext(zmqContext),
         mTimeoutMinutes(1), 
         mPrintBestNum(20),
         //mExecutable("DeepThought"),
-        mGetGenomeConfig(static_cast<GetGenomeConfigFunc>(0)),
-        mStoreState(static_cast<StoreStateFunc>(0))
+        mUseConfigTemplate(false),
+        mStoreState(static_cast<StoreStateFunc>(0)),
+        mKeepOutput(true),
+        mMaxResubmits(2),
+        mResultGraceSeconds(60),
+        mNumResubmissions(0),
+        mSubmitChunkSize(1000),
+        mSubmitting(false),
+        mCancelSubmit(false),
+        mWaitingForDispatch(false),
+        mCarryOverIncomplete(false),
+        mCarryOverMaxGenerations(1),
+        mSharedReceiver(false),
+        mExperimentID(0)
     {
         FILE_LOG(logDEBUG) << __FUNCTION_NAME__ << "Created HTCondor interface.";
         srand(static_cast<boost::uint32_t>(time(NULL)));
@@ -22,6 +35,8 @@ namespace GridGALib
 
     HTCondor::~HTCondor(void)
     {
+        StopSubmitting();
+        CancelUnwantedJobs(true);
     }
 
     //______________________________________________________________________________________________________________
@@ -36,29 +51,77 @@ namespace GridGALib
         mGenomesToTest = genomesToTest;
         mGenomeCache = genomeCache;
         mGenerationNumber = generationNumber;
-        std::string submitFileName(WriteSubmitFile());
-        SubmitToCluster(submitFileName);
+        mGenerationStartTime = boost::posix_time::microsec_clock::universal_time();
+        Metrics::Instance().Set(Metrics::FIRST_RESULT_SECONDS, 0.0);
+
+        // anything still awaiting a result was carried over from the previous generation and is still running
+        if (!mGenomesAwaitingResults.empty())
+        {
+            FILE_LOG(logINFO) << __FUNCTION_NAME__ << mGenomesAwaitingResults.size() << " genomes carried over from the previous generation.";
+            std::cout << mGenomesAwaitingResults.size() << " genomes carried over from the previous generation." << std::endl;
+        }
+
+        std::vector<GenomePtr> genomesToSubmit;
+        BOOST_FOREACH(GenomePtr genome, *mGenomesToTest)
+        {
+            if (!genome->IsComplete())
+            {
+                mGenomesAwaitingResults[genome->GetGenomeID()] = genome;
+                mGenomeSubmitGenerations[genome->GetGenomeID()] = mGenerationNumber;
+                genomesToSubmit.push_back(genome);
+            }
+        }
+
+        PrepareGeneration();
+
+        // Submitted in chunks from a background thread so the first jobs are running, and their results are being
+        // collected, while the rest of the generation is still being queued.
+        std::size_t chunkSize = (mSubmitChunkSize > 0) ? mSubmitChunkSize : genomesToSubmit.size();
+        std::size_t numChunks = 0;
+        for (std::size_t first = 0; first < genomesToSubmit.size(); first += chunkSize)
+        {
+            std::size_t last = std::min(first + chunkSize, genomesToSubmit.size());
+            std::ostringstream submitName;
+            submitName << "generation-" << mGenerationNumber;
+            if (chunkSize < genomesToSubmit.size())
+            {
+                submitName << ".chunk-" << ++numChunks;
+            }
+            submitName << ".submit";
+            QueueSubmission(std::vector<GenomePtr>(genomesToSubmit.begin() + first, genomesToSubmit.begin() + last), submitName.str());
+        }
         WaitForResults();
         return true;
     }
 
     //______________________________________________________________________________________________________________
 
-    bool HTCondor::ReadConfig(boost::property_tree::ptree& pt)
+    void HTCondor::SetSharedExecution(const SharedExecution& sharedExecution)
+    {
+        mSharedReceiver = true;
+        mResultsReceiver = sharedExecution.mResultsReceiver;
+        mScheduler = sharedExecution.mScheduler;
+        mExperimentID = sharedExecution.mExperimentID;
+        mServer = sharedExecution.mServer;
+        mGAPort = sharedExecution.mPort;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool HTCondor::ReadConfig(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap)
     {
         mParamPrefix = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.param-prefix", pt, "--");
         mValuePrefix = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.value-prefix", pt, " ");
         mTimeoutMinutes = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.timeout-minutes", pt, 120);
 
-        mServer = CommonLib::GetOptionalParameter<std::string>("config.htcondor.ga-server", pt, "tcp://localhost") + ":" +
-            CommonLib::GetOptionalParameter<std::string>("config.htcondor.ga-server-port", pt, "55566");
-
-        mGAPort = CommonLib::GetOptionalParameter<boost::int32_t>("config.htcondor.ga-server-port", pt, 55566);
-
-        mExecutable = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.executable", pt, "not-set");
-        mExtractObj = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.extract-obj", pt, "not-set");
+        // the experiments file sets where the results go when the port is shared
+        if (!mSharedReceiver)
+        {
+            mServer = CommonLib::GetOptionalParameter<std::string>("config.htcondor.ga-server", pt, "tcp://localhost") + ":" +
+                CommonLib::GetOptionalParameter<std::string>("config.htcondor.ga-server-port", pt, "55566");
 
-        mArguments = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.arguments", pt, "not-set");
+            mGAPort = CommonLib::GetOptionalParameter<boost::int32_t>("config.htcondor.ga-server-port", pt, 55566);
+        }
 
         for (boost::property_tree::ptree::const_iterator itr=pt.get_child("config.genetic-algo").begin(); itr!=pt.get_child("config.genetic-algo").end(); ++itr)
         {
@@ -70,6 +133,112 @@ namespace GridGALib
             }
         }
 
+        // when set, the required files are served by the GA and cached on the execute nodes under this directory
+        // instead of being sent by HTCondor with every job
+        mStagingCacheDir = CommonLib::GetOptionalParameter<std::string>("config.htcondor.staging-cache-dir", pt, "");
+
+        // runs the jobs on this machine instead of submitting them to HTCondor, see LocalPool
+        std::size_t localPoolSlots = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.local-pool.slots", pt, 0);
+        if (localPoolSlots > 0)
+        {
+            LocalPoolSettings settings;
+            settings.mNumSlots = localPoolSlots;
+            settings.mQueueLatencyMs = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.local-pool.queue-latency-ms", pt, 0);
+            settings.mEvictPercent = CommonLib::GetOptionalParameter<double>("config.htcondor.local-pool.evict-percent", pt, 0.0);
+            settings.mHoldPercent = CommonLib::GetOptionalParameter<double>("config.htcondor.local-pool.hold-percent", pt, 0.0);
+            settings.mFailPercent = CommonLib::GetOptionalParameter<double>("config.htcondor.local-pool.fail-percent", pt, 0.0);
+            settings.mEvictAfterMs = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.local-pool.evict-after-ms", pt, 1000);
+            mLocalPool.reset(new LocalPool(mFilesLocation, settings));
+        }
+
+        // bind the results socket once for the whole run so that wrappers finishing early, or between generations,
+        // are never refused. A shared receiver is started once every experiment has added its staged files.
+        if (!mSharedReceiver)
+        {
+            std::size_t numReceiverThreads = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.receiver-threads", pt, 2);
+            mResultsReceiver.reset(new ResultsReceiver(mZmqContext, mGAPort, numReceiverThreads));
+        }
+        if (!mStagingCacheDir.empty())
+        {
+            // the executable may come from a file system, or a machine, that doesn't keep the execute bits
+            std::string executable(CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.executable", pt, ""));
+            executable = boost::filesystem::path(executable.substr(0, executable.find(' '))).filename().string();
+            BOOST_FOREACH(const std::string& file, mFiles)
+            {
+                StagedFile stagedFile;
+                if (!LoadStagedFile(file, stagedFile))
+                {
+                    return false;
+                }
+                if (stagedFile.mName == executable)
+                {
+                    stagedFile.mMode |= 0755;
+                }
+                mResultsReceiver->AddStagedFile(stagedFile);
+                mStagedFiles.push_back(stagedFile);
+            }
+            mFiles.clear();
+        }
+        if (!mSharedReceiver && !mResultsReceiver->Start())
+        {
+            return false;
+        }
+
+        mExecutable = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.executable", pt, "not-set");
+        mExtractObj = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.extract-obj", pt, "not-set");
+
+        mArguments = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.arguments", pt, "not-set");
+
+        // an XML template with ga-subst elements, or a text template with {{parameter id}} placeholders, written
+        // out for every genome and sent with its job. %CONFIG% in the arguments is replaced by the name of the
+        // genome's file.
+        std::string configTemplate = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.config-template", pt, "");
+        if (!configTemplate.empty())
+        {
+            std::string format = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.config-template.<xmlattr>.format", pt, "");
+            if (!mGenerateXMLConfig.Compile(mFilesLocation + "/" + configTemplate, format, parameterMap))
+            {
+                return false;
+            }
+            mUseConfigTemplate = true;
+        }
+
+        // binary | xml. Only needs to be set to xml if the master has to talk to wrappers built before the binary
+        // protocol existed.
+        mResultFormat = CommonLib::GetOptionalParameter<std::string>("config.htcondor.result-format", pt, "binary");
+
+        // shell | direct. direct runs the executable without a shell and reads the objective from its output.
+        mSpawn = CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.spawn", pt, "shell");
+        mKeepOutput = CommonLib::GetOptionalBoolParameter("config.genetic-algo.keep-output", pt, true);
+
+        // per-genome | table. table writes a single queue-from table and one shared job config per generation
+        // instead of a submit block and a job config file for every genome.
+        mSubmitMode = CommonLib::GetOptionalParameter<std::string>("config.htcondor.submit-mode", pt, "per-genome");
+
+        // how often a held or killed job is resubmitted before its genome is recorded as failed
+        mMaxResubmits = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.max-resubmits", pt, 2);
+        // how long to wait for the result of a job that HTCondor says has finished
+        mResultGraceSeconds = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.result-grace-seconds", pt, 60);
+        // number of jobs per condor_submit, 0 submits the whole generation at once
+        mSubmitChunkSize = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.submit-chunk-size", pt, 1000);
+
+        // leave jobs that are still running at the end of a generation to report during the next one
+        mCarryOverIncomplete = CommonLib::GetOptionalBoolParameter("config.htcondor.carry-over-incomplete", pt, false);
+        mCarryOverMaxGenerations = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.carry-over-max-generations", pt, 1);
+
+        // <objective-extractor type="regex|last-number|json" ... /> is passed through to the wrapper unchanged
+        if (pt.get_child_optional("config.genetic-algo.objective-extractor.<xmlattr>"))
+        {
+            std::ostringstream s;
+            s << "<objective-extractor";
+            BOOST_FOREACH(const boost::property_tree::ptree::value_type& attribute, pt.get_child("config.genetic-algo.objective-extractor.<xmlattr>"))
+            {
+                s << " " << attribute.first << "=\"" << CommonLib::EscapeXML(attribute.second.data()) << "\"";
+            }
+            s << " />";
+            mObjectiveExtractor = s.str();
+        }
+
         // create a batch script to clean up
         std::string batFile = mFilesLocation + "/del_ga.bat";
         std::ofstream fileOut(batFile.c_str());
@@ -94,35 +263,60 @@ namespace GridGALib
     }
 
     //______________________________________________________________________________________________________________
-
-    std::string HTCondor::WriteSubmitFile(void) 
+    // Reads the whole file into memory and hashes it. The file is read once for the whole run, so changing it while
+    // the GA is running has no effect on the jobs.
+    bool HTCondor::LoadStagedFile(const std::string& fileName, StagedFile& stagedFile)
     {
-        std::ostringstream s;
-        s << mFilesLocation << "/generation-" << mGenerationNumber << ".submit";
-        std::ofstream submitFile(s.str().c_str());
+        std::ifstream inFile(fileName.c_str(), std::ios::binary);
+        if (!inFile)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- Cannot open the required file " << fileName << ".";
+            return false;
+        }
 
-#ifdef _WIN32
-        submitFile << "Executable = htcondor_job_wrapper.exe" << "\n";
-#else
-        submitFile << "Executable = htcondor_job_wrapper" << "\n";
-#endif
+        inFile.seekg(0, std::ios::end);
+        stagedFile.mSize = static_cast<boost::uint64_t>(inFile.tellg());
+        inFile.seekg(0, std::ios::beg);
+        stagedFile.mData.reset(new char[static_cast<std::size_t>(std::max<boost::uint64_t>(stagedFile.mSize, 1))]);
+        inFile.read(stagedFile.mData.get(), static_cast<std::streamsize>(stagedFile.mSize));
+        if (static_cast<boost::uint64_t>(inFile.gcount()) != stagedFile.mSize)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- Cannot read the required file " << fileName << ".";
+            return false;
+        }
 
-        
-        submitFile << "Universe = vanilla\n";
-        submitFile << "should_transfer_files = yes\n";
-        submitFile << "stream_error = false\n";
-        submitFile << "stream_input = false\n";
-        submitFile << "stream_output = false\n";
-        submitFile << "should_transfer_files = YES\n";
-        submitFile << "when_to_transfer_output = ON_EXIT_OR_EVICT\n";    
+        // HTCondor puts transferred files in the job's directory without any path, so do the same
+        stagedFile.mName = boost::filesystem::path(fileName).filename().string();
+        stagedFile.mHash = HashData(stagedFile.mData.get(), static_cast<std::size_t>(stagedFile.mSize));
+        boost::system::error_code ec;
+        stagedFile.mMode = static_cast<boost::uint32_t>(boost::filesystem::status(fileName, ec).permissions() & boost::filesystem::all_all);
+        if (ec)
+        {
+            stagedFile.mMode = 0644;
+        }
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "- Staging " << stagedFile.mName << " (" << stagedFile.mSize << " bytes, sha1 " << stagedFile.mHash << ").";
+        return true;
+    }
 
+    //______________________________________________________________________________________________________________
+    // In the experiment's own directory, as experiments at the same generation share the process's working directory
+    std::string HTCondor::GetUserLogFileName(void) const
+    {
         std::ostringstream logFileName;
-        logFileName << "genetic-algo.condor." << mGenerationNumber << ".log";
+        logFileName << mFilesLocation << "/genetic-algo.condor." << mGenerationNumber << ".log";
+        return logFileName.str();
+    }
+
+    //______________________________________________________________________________________________________________
+    // Removes anything left from a previous run of this generation and starts following its user log
+    void HTCondor::PrepareGeneration(void)
+    {
+        std::string logFileName(GetUserLogFileName());
         try
         {
-            if (boost::filesystem::exists(logFileName.str()))
+            if (boost::filesystem::exists(logFileName))
             {       
-                boost::filesystem::remove(logFileName.str());
+                boost::filesystem::remove(logFileName);
             }
         }
         catch (std::exception& e)
@@ -132,8 +326,6 @@ namespace GridGALib
             exit(-1);
         }
 
-        submitFile << "log = " << logFileName.str() << "\n";
-
         std::ostringstream generationSubDir;
         generationSubDir << mFilesLocation << "/generation-" << mGenerationNumber;
 
@@ -175,72 +367,246 @@ namespace GridGALib
             FILE_LOG(logDEBUG) << __FUNCTION_NAME__ << "- " << generationSubDir.str() << " has been created.";
         }
 
-        BOOST_FOREACH(GenomePtr genome, *mGenomesToTest)
+        if (boost::iequals(mSubmitMode, "table"))
         {
-            if (!genome->IsComplete())
-            {  
-                std::ostringstream outFileName;
-                outFileName << genome->GetGenomeID();
+            // the wrapper fills in %GENOME_ID% from its command line
+            std::string arguments = mArguments;
+            boost::replace_all(arguments, "%CONFIG%", mGenerateXMLConfig.GetConfigFileName("%GENOME_ID%"));
+            WriteJobConfig(generationSubDir.str() + "/job_config.xml", mExecutable + " " + arguments, "");
+        }
 
-                std::ostringstream transferInputFiles;
+        mNumResubmissions = 0;
+        mUnmatchedEvents.clear();
+        if (mGenomesAwaitingResults.empty())
+        {
+            mUserLogs.clear();
+            mJobGenomes.clear();
+            mJobHosts.clear();
+            mClusterIDs.clear();
+            mResubmitCounts.clear();
+            mFinishedWithoutResult.clear();
+            mFailedResults.clear();
+        }
+        // else the jobs carried over from earlier generations are still logging to their own generation's log
+        mUserLogs.push_back(boost::make_shared<CondorUserLog>(GetUserLogFileName()));
+    }
 
-                if (mGetGenomeConfig)
-                {
-                    transferInputFiles <<  mGetGenomeConfig(genome, generationSubDir.str());
-                    if (transferInputFiles.str().size() > 0)
-                    {
-                        transferInputFiles << ",";
-                    }
-                }
+    //______________________________________________________________________________________________________________
+    // Runs on the submit thread, so only the chunk's strings and settings that don't change after ReadConfig are used
+    std::string HTCondor::WriteSubmitFile(const SubmitChunk& chunk) 
+    {
+        std::ostringstream s;
+        s << mFilesLocation << "/" << chunk.mSubmitName;
+        std::ofstream submitFile(s.str().c_str());
 
-                BOOST_FOREACH(std::string s, mFiles)
-                {
-                    transferInputFiles << s << ",";
-                }
+#ifdef _WIN32
+        submitFile << "Executable = htcondor_job_wrapper.exe" << "\n";
+#else
+        submitFile << "Executable = htcondor_job_wrapper" << "\n";
+#endif
 
-                std::string arguments = mArguments;
-                boost::replace_all(arguments, "%GA%", genome->GetCommandLineArguments(mParamPrefix, mValuePrefix));
-                submitFile << "Arguments = " << genome->GetGenomeID() << "_obj_test_config.xml" << "\n";
-                submitFile << "Output = " << generationSubDir.str() << "/" << outFileName.str() << ".out\n";
-                submitFile << "Error = " << generationSubDir.str() << "/" << outFileName.str() << ".err\n";
-
-                std::ostringstream s;
-                s << 
-                    "<config>" << std::endl <<
-                    "   <execute>" << mExecutable << " " << arguments << "</execute>" << std::endl;
-                if (!boost::iequals(mExtractObj,"not-set"))
+        
+        submitFile << "Universe = vanilla\n";
+        submitFile << "should_transfer_files = yes\n";
+        submitFile << "stream_error = false\n";
+        submitFile << "stream_input = false\n";
+        submitFile << "stream_output = false\n";
+        submitFile << "should_transfer_files = YES\n";
+        submitFile << "when_to_transfer_output = ON_EXIT_OR_EVICT\n";    
+
+        submitFile << "log = " << chunk.mUserLogFileName << "\n";
+
+        const std::string& generationSubDir(chunk.mGenerationSubDir);
+
+        if (boost::iequals(mSubmitMode, "table"))
+        {
+            WriteQueueTable(submitFile, chunk);
+            submitFile.close();
+            return s.str();
+        }
+
+        BOOST_FOREACH(const SubmitJob& job, chunk.mJobs)
+        {
+            std::ostringstream outFileName;
+            outFileName << job.mGenomeID;
+
+            std::ostringstream transferInputFiles;
+
+            if (mUseConfigTemplate)
+            {
+                transferInputFiles << mGenerateXMLConfig.WriteConfig(CommonLib::SomethingToString(job.mGenomeID), job.mConfig, generationSubDir);
+                if (transferInputFiles.str().size() > 0)
                 {
-                    s <<
-                        "   <extract-obj-value>" << mExtractObj << "</extract-obj-value>" << std::endl;
+                    transferInputFiles << ",";
                 }
-                s <<
-                    "   <server>" << mServer << "</server>" << std::endl <<
-                    "   <genome-id>" << genome->GetGenomeID() << "</genome-id>" << std::endl <<
-                    "</config>";
-                std::ostringstream jobConfigFileName;
-                jobConfigFileName << generationSubDir.str() << "/" << genome->GetGenomeID() << "_obj_test_config.xml";
-                std::ofstream jobConfig(jobConfigFileName.str().c_str());
-                jobConfig << s.str();
-                jobConfig.close();
+            }
+
+            BOOST_FOREACH(std::string s, mFiles)
+            {
+                transferInputFiles << s << ",";
+            }
+
+            std::string arguments = mArguments;
+            boost::replace_all(arguments, "%GA%", job.mArguments);
+            boost::replace_all(arguments, "%CONFIG%", mGenerateXMLConfig.GetConfigFileName(CommonLib::SomethingToString(job.mGenomeID)));
+            submitFile << "Arguments = " << job.mGenomeID << "_obj_test_config.xml" << "\n";
+            submitFile << "Output = " << generationSubDir << "/" << outFileName.str() << ".out\n";
+            submitFile << "Error = " << generationSubDir << "/" << outFileName.str() << ".err\n";
+
+            std::ostringstream jobConfigFileName;
+            jobConfigFileName << generationSubDir << "/" << job.mGenomeID << "_obj_test_config.xml";
+            WriteJobConfig(jobConfigFileName.str(), mExecutable + " " + arguments, CommonLib::SomethingToString(job.mGenomeID));
  
 #ifdef _WIN32
-                submitFile << "transfer_input_files = htcondor_job_wrapper.exe," << jobConfigFileName.str() << "," << transferInputFiles.str() << "\n"; // << GetPythonFiles();
-                submitFile << "Requirements   = (OpSys == \"WINDOWS\" && Arch ==\"X86_64\") || (OpSys == \"WINDOWS\" && Arch ==\"INTEL\")\n";
+            submitFile << "transfer_input_files = htcondor_job_wrapper.exe," << jobConfigFileName.str() << "," << transferInputFiles.str() << "\n"; // << GetPythonFiles();
+            submitFile << "Requirements   = (OpSys == \"WINDOWS\" && Arch ==\"X86_64\") || (OpSys == \"WINDOWS\" && Arch ==\"INTEL\")\n";
 #else
-                submitFile << "transfer_input_files = htcondor_job_wrapper," << jobConfigFileName.str() << "," << transferInputFiles.str() << "\n"; ;
+            submitFile << "transfer_input_files = htcondor_job_wrapper," << jobConfigFileName.str() << "," << transferInputFiles.str() << "\n"; ;
 #endif
-                //submitFile << "transfer_output_files = results.zip\n";
+            //submitFile << "transfer_output_files = results.zip\n";
 
-                // copy into the 'generation' directory
-                //submitFile << "transfer_output_remaps = \"results.zip = " << generationSubDir.str() << "/" << genome->GetGenomeID() << ".results.zip\"\n";
-                submitFile << "Queue\n";
-            }
+            // copy into the 'generation' directory
+            //submitFile << "transfer_output_remaps = \"results.zip = " << generationSubDir << "/" << job.mGenomeID << ".results.zip\"\n";
+            submitFile << "Queue\n";
         }
 
         submitFile.close();
         return s.str();
     }
 
+    //______________________________________________________________________________________________________________
+    // One submit description and job config for the whole generation. Each genome is a row of the queue table
+    // holding its id and its %GA% arguments, which the wrapper substitutes into the shared execute command.
+    void HTCondor::WriteQueueTable(std::ofstream& submitFile, const SubmitChunk& chunk)
+    {
+        const std::string& generationSubDir(chunk.mGenerationSubDir);
+        // written once by PrepareGeneration, as jobs from earlier chunks may already be transferring it
+        std::string jobConfigFileName(generationSubDir + "/job_config.xml");
+
+        std::ostringstream transferInputFiles;
+        BOOST_FOREACH(std::string s, mFiles)
+        {
+            transferInputFiles << "," << s;
+        }
+        if (mUseConfigTemplate)
+        {
+            transferInputFiles << ",$(GenomeFiles)";
+        }
+
+        // GAArgs is single quoted so the wrapper gets it as one argument, whatever spaces or quotes its values hold
+        submitFile << "Arguments = \"job_config.xml $(GenomeId) '$(GAArgs)'\"\n";
+        submitFile << "Output = " << generationSubDir << "/$(GenomeId).out\n";
+        submitFile << "Error = " << generationSubDir << "/$(GenomeId).err\n";
+#ifdef _WIN32
+        submitFile << "transfer_input_files = htcondor_job_wrapper.exe," << jobConfigFileName << transferInputFiles.str() << "\n";
+        submitFile << "Requirements   = (OpSys == \"WINDOWS\" && Arch ==\"X86_64\") || (OpSys == \"WINDOWS\" && Arch ==\"INTEL\")\n";
+#else
+        submitFile << "transfer_input_files = htcondor_job_wrapper," << jobConfigFileName << transferInputFiles.str() << "\n";
+#endif
+
+        // the last variable takes the rest of the row, so the arguments can contain spaces
+        submitFile << (mUseConfigTemplate ? "Queue GenomeId,GenomeFiles,GAArgs from (\n" : "Queue GenomeId,GAArgs from (\n");
+        BOOST_FOREACH(const SubmitJob& job, chunk.mJobs)
+        {
+            submitFile << job.mGenomeID << ",";
+            if (mUseConfigTemplate)
+            {
+                submitFile << mGenerateXMLConfig.WriteConfig(CommonLib::SomethingToString(job.mGenomeID), job.mConfig, generationSubDir) << ",";
+            }
+            submitFile << EscapeQueueTableArguments(job.mArguments) << "\n";
+        }
+        submitFile << ")\n";
+    }
+
+    //______________________________________________________________________________________________________________
+    // A row's value is expanded into the new-syntax Arguments string before that is split, so quotes are doubled
+    // and $ is written as $(DOLLAR) to stop it being read as a macro. A row ends at the line break and there's no
+    // escape for one, so a value holding a line break can't be passed in table mode and it is replaced by a space.
+    std::string HTCondor::EscapeQueueTableArguments(const std::string& arguments)
+    {
+        std::string escaped;
+        escaped.reserve(arguments.size());
+        BOOST_FOREACH(char c, arguments)
+        {
+            switch (c)
+            {
+            case '"':
+                escaped += "\"\"";
+                break;
+            case '\'':
+                escaped += "''";
+                break;
+            case '$':
+                escaped += "$(DOLLAR)";
+                break;
+            case '\n':
+            case '\r':
+                escaped += ' ';
+                break;
+            default:
+                escaped += c;
+                break;
+            }
+        }
+        if (arguments.find_first_of("\r\n") != std::string::npos)
+        {
+            FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "Line breaks in " << escaped << " have been replaced by spaces";
+        }
+        return escaped;
+    }
+
+    //______________________________________________________________________________________________________________
+    // genomeID is left out of the shared job config written in table mode as the wrapper gets it on its command line
+    void HTCondor::WriteJobConfig(const std::string& fileName, const std::string& execute, const std::string& genomeID)
+    {
+        std::ostringstream s;
+        s << 
+            "<config>" << std::endl <<
+            "   <execute>" << execute << "</execute>" << std::endl;
+        if (!boost::iequals(mExtractObj,"not-set"))
+        {
+            s <<
+                "   <extract-obj-value>" << mExtractObj << "</extract-obj-value>" << std::endl;
+        }
+        if (!mObjectiveExtractor.empty())
+        {
+            s <<
+                "   " << mObjectiveExtractor << std::endl;
+        }
+        s <<
+            "   <server>" << mServer << "</server>" << std::endl;
+        if (mSharedReceiver)
+        {
+            s <<
+                "   <experiment-id>" << mExperimentID << "</experiment-id>" << std::endl;
+        }
+        if (!genomeID.empty())
+        {
+            s <<
+                "   <genome-id>" << genomeID << "</genome-id>" << std::endl;
+        }
+        s <<
+            "   <result-format>" << mResultFormat << "</result-format>" << std::endl <<
+            "   <spawn>" << mSpawn << "</spawn>" << std::endl <<
+            "   <keep-output>" << (mKeepOutput ? "true" : "false") << "</keep-output>" << std::endl;
+        if (!mStagedFiles.empty())
+        {
+            s <<
+                "   <staging-cache-dir>" << CommonLib::EscapeXML(mStagingCacheDir) << "</staging-cache-dir>" << std::endl;
+            BOOST_FOREACH(const StagedFile& stagedFile, mStagedFiles)
+            {
+                s <<
+                    "   <staged-file name=\"" << CommonLib::EscapeXML(stagedFile.mName) << "\" sha1=\"" << stagedFile.mHash <<
+                    "\" size=\"" << stagedFile.mSize << "\" mode=\"" << std::oct << stagedFile.mMode << std::dec << "\" />" << std::endl;
+            }
+        }
+        s <<
+            "</config>";
+        std::ofstream jobConfig(fileName.c_str());
+        jobConfig << s.str();
+        jobConfig.close();
+    }
+
     //______________________________________________________________________________________________________________
 
     //std::string HTCondor::GetPythonFiles(void)
@@ -263,79 +629,590 @@ namespace GridGALib
 
     //______________________________________________________________________________________________________________
 
-    void HTCondor::SubmitToCluster(const std::string& submitFileName)
+    void HTCondor::QueueSubmission(const std::vector<GenomePtr>& genomes, const std::string& submitName)
     {
-        std::cerr << __FUNCTION_NAME__ << std::endl;
+        SubmitChunk chunk;
+        chunk.mSubmitName = submitName;
+        chunk.mGenerationSubDir = mFilesLocation + "/generation-" + CommonLib::SomethingToString(mGenerationNumber);
+        chunk.mUserLogFileName = GetUserLogFileName();
+        chunk.mNumParts = 0;
+        BOOST_FOREACH(GenomePtr genome, genomes)
+        {
+            if (genome->IsComplete())
+            {
+                continue;
+            }
+            SubmitJob job;
+            job.mGenomeID = genome->GetGenomeID();
+            job.mArguments = genome->GetCommandLineArguments(mParamPrefix, mValuePrefix);
+            if (mUseConfigTemplate)
+            {
+                job.mConfig = mGenerateXMLConfig.Render(genome);
+            }
+            chunk.mJobs.push_back(job);
+        }
+
+        boost::unique_lock<boost::mutex> lock(mSubmitMutex);
+        mSubmitQueue.push_back(chunk);
+        if (mSubmitting)
+        {
+            // the running thread picks it up
+            return;
+        }
+        mSubmitting = true;
+        lock.unlock();
+
+        // the previous thread has emptied the queue and is exiting (or has exited)
+        if (mSubmitThread.joinable())
+        {
+            mSubmitThread.join();
+        }
+        mSubmitThread = boost::thread(boost::bind(&HTCondor::SubmitLoop, this, &Metrics::Instance(), &TraceRecorder::Instance()));
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void HTCondor::SubmitLoop(Metrics* metrics, TraceRecorder* traceRecorder)
+    {
+        ScopedMetricsInstance metricsInstance(metrics);
+        ScopedTraceInstance traceInstance(traceRecorder);
+        while (true)
+        {
+            SubmitChunk chunk;
+            {
+                boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+                if (mSubmitQueue.empty() || mCancelSubmit)
+                {
+                    mSubmitQueue.clear();
+                    mSubmitting = false;
+                    return;
+                }
+                chunk = mSubmitQueue.front();
+                mSubmitQueue.pop_front();
+            }
+
+            // Waits for the scheduler to give this experiment some of the jobs in flight. Whatever isn't granted goes
+            // back on the front of the queue and is submitted as another part of the chunk.
+            if (mScheduler)
+            {
+                {
+                    boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+                    mWaitingForDispatch = true;
+                }
+                std::size_t numGranted = mScheduler->Acquire(mExperimentID, chunk.mJobs.size(), boost::bind(&HTCondor::IsSubmitCancelled, this));
+                boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+                mWaitingForDispatch = false;
+                if (numGranted == 0)
+                {
+                    continue;
+                }
+
+                if (numGranted < chunk.mJobs.size() || chunk.mNumParts > 0)
+                {
+                    SubmitChunk rest(chunk);
+                    rest.mNumParts = chunk.mNumParts + 1;
+                    rest.mJobs.erase(rest.mJobs.begin(), rest.mJobs.begin() + numGranted);
+                    chunk.mJobs.resize(numGranted);
+                    chunk.mSubmitName = boost::replace_last_copy(rest.mSubmitName, ".submit",
+                        ".part-" + CommonLib::SomethingToString(rest.mNumParts) + ".submit");
+                    if (!rest.mJobs.empty())
+                    {
+                        mSubmitQueue.push_front(rest);
+                    }
+                }
+                BOOST_FOREACH(const SubmitJob& job, chunk.mJobs)
+                {
+                    mDispatchedGenomes.insert(job.mGenomeID);
+                }
+            }
+
+            SubmittedChunk submitted;
+            std::string submitFileName;
+            {
+                ScopedTraceSpan span("WriteSubmitFile", TraceRecorder::TRACK_SUBMIT);
+                submitFileName = WriteSubmitFile(chunk);
+            }
+            {
+                ScopedMetricsTimer timer(Metrics::SUBMIT_SECONDS);
+                ScopedTraceSpan span("SubmitToCluster", TraceRecorder::TRACK_SUBMIT);
+                submitted.mClusterID = SubmitToCluster(submitFileName);
+            }
+            submitted.mSubmitTime = boost::posix_time::microsec_clock::universal_time();
+            BOOST_FOREACH(const SubmitJob& job, chunk.mJobs)
+            {
+                submitted.mGenomeIDs.push_back(job.mGenomeID);
+                // nothing is running, so the jobs go straight back to the other experiments
+                if (submitted.mClusterID == -1)
+                {
+                    ReleaseDispatch(job.mGenomeID);
+                }
+            }
+
+            boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+            mSubmittedChunks.push_back(submitted);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // Drops anything not yet submitted and waits for the submission in progress to finish
+    void HTCondor::StopSubmitting(void)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+            mCancelSubmit = true;
+        }
+        if (mSubmitThread.joinable())
+        {
+            mSubmitThread.join();
+        }
+        {
+            boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+            mCancelSubmit = false;
+        }
+        // whatever failed to submit has no job, and is cancelled with the rest by CancelUnwantedJobs
+        std::vector<std::size_t> failedGenomeIDs;
+        RegisterSubmittedChunks(failedGenomeIDs);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool HTCondor::IsSubmitCancelled(void)
+    {
+        boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+        return mCancelSubmit;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool HTCondor::IsWaitingForDispatch(void)
+    {
+        boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+        return mWaitingForDispatch;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Hands the genome's job back to the dispatch scheduler, once it has a result, has failed or its job has been
+    // removed. Releasing a genome that doesn't hold a job does nothing, so every way out can call it.
+    void HTCondor::ReleaseDispatch(std::size_t genomeID)
+    {
+        if (!mScheduler)
+        {
+            return;
+        }
+        {
+            boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+            if (mDispatchedGenomes.erase(genomeID) == 0)
+            {
+                return;
+            }
+        }
+        mScheduler->Release(mExperimentID, 1);
+    }
+
+    //______________________________________________________________________________________________________________
+    // Called on the GA thread to take over the jobs the submit thread has queued. Jobs are numbered in the order they
+    // appear in the submit file, which is all that's needed to map their events back to genomes. The genomes of a
+    // chunk that condor_submit failed on are returned in failedGenomeIDs.
+    bool HTCondor::RegisterSubmittedChunks(std::vector<std::size_t>& failedGenomeIDs)
+    {
+        std::vector<SubmittedChunk> submittedChunks;
+        {
+            boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+            submittedChunks.swap(mSubmittedChunks);
+        }
+
+        BOOST_FOREACH(const SubmittedChunk& submitted, submittedChunks)
+        {
+            if (submitted.mClusterID == -1)
+            {
+                failedGenomeIDs.insert(failedGenomeIDs.end(), submitted.mGenomeIDs.begin(), submitted.mGenomeIDs.end());
+                continue;
+            }
+
+            mCondorClusterID = submitted.mClusterID;
+            mClusterIDs.push_back(submitted.mClusterID);
+            for (std::size_t proc = 0; proc < submitted.mGenomeIDs.size(); ++proc)
+            {
+                mJobGenomes[CondorJobID(submitted.mClusterID, static_cast<boost::int32_t>(proc))] = submitted.mGenomeIDs[proc];
+
+                // the genomes are only touched on this thread
+                boost::unordered_map<std::size_t, GenomePtr>::iterator genomeItr = mGenomesAwaitingResults.find(submitted.mGenomeIDs[proc]);
+                if (genomeItr != mGenomesAwaitingResults.end())
+                {
+                    genomeItr->second->SetSubmitTime(submitted.mSubmitTime);
+                }
+            }
+            Metrics::Instance().Increment(Metrics::JOBS_SUBMITTED, submitted.mGenomeIDs.size());
+        }
+        return !submittedChunks.empty();
+    }
+
+    //______________________________________________________________________________________________________________
+    // Returns the cluster id, or -1 if the submit failed
+    boost::int32_t HTCondor::SubmitToCluster(const std::string& submitFileName)
+    {
+        if (mLocalPool)
+        {
+            return mLocalPool->Submit(submitFileName);
+        }
+
         std::ostringstream cmd;
         cmd << "condor_submit " << submitFileName;
         FILE_LOG(logINFO) << "Executing " << cmd.str();
-        std::system(cmd.str().c_str());
-        
-        // parse the log and get the cluster id
-        std::ostringstream condorLogFile;
-        condorLogFile << "genetic-algo.condor." << mGenerationNumber << ".log";
-        std::ifstream condorLog(condorLogFile.str().c_str());
-        std::string line;
-        while ( condorLog.good() )
-        {
-            getline(condorLog,line);
-            boost::trim(line);
-            if (!line.empty())
-            {
-                std::vector<std::string> stringTokens;
-                boost::split(stringTokens, line, boost::is_any_of(" "));
-                BOOST_FOREACH(std::string& token, stringTokens)
+
+#ifdef _WIN32
+        FILE* output = _popen(cmd.str().c_str(), "r");
+#else
+        FILE* output = popen(cmd.str().c_str(), "r");
+#endif
+        if (!output)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- Cannot run " << cmd.str();
+            return -1;
+        }
+
+        // e.g. "20 job(s) submitted to cluster 1234."
+        boost::int32_t clusterID = -1;
+        char line[1024];
+        while (fgets(line, sizeof(line), output))
+        {
+            const char* found = strstr(line, "submitted to cluster ");
+            if (found)
+            {
+                clusterID = atoi(found + strlen("submitted to cluster "));
+            }
+        }
+#ifdef _WIN32
+        int rc = _pclose(output);
+#else
+        int rc = pclose(output);
+#endif
+
+        if (rc != 0 || clusterID == -1)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- " << cmd.str() << " failed.";
+            return -1;
+        }
+
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Submitted " << submitFileName << " to Condor cluster " << clusterID;
+        std::cout << "Submitted to Condor cluster " << clusterID << std::endl;
+        return clusterID;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void HTCondor::RemoveJobs(const std::vector<CondorJobID>& jobIDs)
+    {
+        if (mLocalPool)
+        {
+            mLocalPool->Remove(jobIDs);
+            return;
+        }
+
+        // keep the command lines to a sensible length
+        const std::size_t jobsPerCommand = 200;
+        for (std::size_t first = 0; first < jobIDs.size(); first += jobsPerCommand)
+        {
+            std::ostringstream s;
+            s << "condor_rm";
+            for (std::size_t i = first; i < std::min(first + jobsPerCommand, jobIDs.size()); ++i)
+            {
+                s << " " << jobIDs[i].first << "." << jobIDs[i].second;
+            }
+            FILE_LOG(logINFO) << "Removing jobs - executing command " << s.str();
+            std::system(s.str().c_str());
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // Follows the user log so that jobs which can't produce a result are dealt with straight away rather than when the
+    // generation times out. Held and killed jobs, and jobs condor_submit failed on, are resubmitted up to
+    // max-resubmits times, after which, like jobs
+    // that failed to start or were removed, they are recorded as failed.
+    void HTCondor::ProcessJobEvents(void)
+    {
+        if (mUserLogs.empty())
+        {
+            return;
+        }
+
+        // Events can be in the log before the submit thread has handed over the cluster id, so they are held on to
+        // until there's nothing left being submitted.
+        std::vector<CondorJobEvent> events;
+        std::vector<std::size_t> failedGenomeIDs;
+        if (RegisterSubmittedChunks(failedGenomeIDs))
+        {
+            events.swap(mUnmatchedEvents);
+        }
+        BOOST_FOREACH(boost::shared_ptr<CondorUserLog> userLog, mUserLogs)
+        {
+            userLog->ReadEvents(events);
+        }
+
+        bool submitting;
+        {
+            boost::lock_guard<boost::mutex> lock(mSubmitMutex);
+            submitting = mSubmitting || !mSubmittedChunks.empty();
+        }
+
+        std::vector<GenomePtr> genomesToResubmit;
+        // a failed condor_submit counts against the genomes' resubmits like a held job does
+        BOOST_FOREACH(std::size_t genomeID, failedGenomeIDs)
+        {
+            boost::unordered_map<std::size_t, GenomePtr>::iterator genomeItr = mGenomesAwaitingResults.find(genomeID);
+            if (genomeItr != mGenomesAwaitingResults.end())
+            {
+                ResubmitOrFail(genomeItr->second, "condor_submit failed", "", genomesToResubmit);
+            }
+        }
+
+        BOOST_FOREACH(const CondorJobEvent& event, events)
+        {
+            if (event.mEventCode == CONDOR_EVENT_SUBMIT)
+            {
+                continue;
+            }
+
+            std::map<CondorJobID, std::size_t>::iterator jobItr = mJobGenomes.find(event.mJobID);
+            if (jobItr == mJobGenomes.end())
+            {
+                if (submitting && std::find(mClusterIDs.begin(), mClusterIDs.end(), event.mJobID.first) == mClusterIDs.end())
                 {
-                    if (std::strncmp(token.c_str(), "(", 1) == 0)
-                    {
-                        token.erase(0,1);
-                        std::vector<std::string> stringNumbers;
-                        boost::split(stringNumbers, token, boost::is_any_of("."));
-                        mCondorClusterID = CommonLib::StringToInt(stringNumbers.front());
-                        break;
-                    }
+                    mUnmatchedEvents.push_back(event);
                 }
+                // otherwise a job we have already given up on, or one from another instance of the GA sharing the log
+                continue;
+            }
+
+            std::size_t genomeID = jobItr->second;
+            boost::unordered_map<std::size_t, GenomePtr>::iterator genomeItr = mGenomesAwaitingResults.find(genomeID);
+            if (genomeItr == mGenomesAwaitingResults.end())
+            {
+                continue;
             }
-            if (mCondorClusterID != -1)
+
+            std::ostringstream jobName;
+            jobName << "Genome[" << genomeID << "] job " << event.mJobID.first << "." << event.mJobID.second;
+            std::string host(mJobHosts[event.mJobID]);
+
+            switch (event.mEventCode)
             {
+            case CONDOR_EVENT_EXECUTE:
+                mJobHosts[event.mJobID] = event.mDetail;
+                FILE_LOG(logDEBUG) << __FUNCTION_NAME__ << jobName.str() << " is running on " << event.mDetail;
+                break;
+            case CONDOR_EVENT_EVICTED:
+                // HTCondor puts an evicted vanilla job back in the queue itself
+                FILE_LOG(logWARNING) << __FUNCTION_NAME__ << jobName.str() << " was evicted from " << host << ". " << event.mDetail;
+                break;
+            case CONDOR_EVENT_TERMINATED:
+                if (event.mNormalTermination)
+                {
+                    // the result should already be on its way
+                    mFinishedWithoutResult[genomeID] = boost::posix_time::second_clock::local_time();
+                    break;
+                }
+                FILE_LOG(logWARNING) << __FUNCTION_NAME__ << jobName.str() << " was killed by signal " << event.mReturnValue << " on " << host;
+                mJobGenomes.erase(jobItr);
+                ResubmitOrFail(genomeItr->second, "Job was killed by signal " + CommonLib::SomethingToString(event.mReturnValue), host, genomesToResubmit);
+                break;
+            case CONDOR_EVENT_HELD:
+                {
+                    FILE_LOG(logWARNING) << __FUNCTION_NAME__ << jobName.str() << " is held. " << event.mDetail;
+                    mJobGenomes.erase(jobItr);
+                    RemoveJobs(std::vector<CondorJobID>(1, event.mJobID));
+                    ResubmitOrFail(genomeItr->second, "Job was held: " + event.mDetail, host, genomesToResubmit);
+                }
+                break;
+            case CONDOR_EVENT_ABORTED:
+                FILE_LOG(logWARNING) << __FUNCTION_NAME__ << jobName.str() << " was removed from the queue. " << event.mDetail;
+                mJobGenomes.erase(jobItr);
+                FailGenome(genomeID, "Job was removed from the queue", host);
+                break;
+            case CONDOR_EVENT_EXECUTABLE_ERROR:
+                FILE_LOG(logWARNING) << __FUNCTION_NAME__ << jobName.str() << " could not be started. " << event.mDetail;
+                mJobGenomes.erase(jobItr);
+                FailGenome(genomeID, "Job could not be started: " + event.mDetail, host);
+                break;
+            default:
                 break;
             }
         }
-        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Submitted to Condor cluster " << mCondorClusterID;
-        std::cout << "Submitted to Condor cluster " << mCondorClusterID << std::endl;
-        condorLog.close();
+
+        if (!genomesToResubmit.empty())
+        {
+            std::ostringstream submitName;
+            submitName << "generation-" << mGenerationNumber << ".resubmit-" << ++mNumResubmissions << ".submit";
+            FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Resubmitting " << genomesToResubmit.size() << " genomes.";
+            std::cout << "Resubmitting " << genomesToResubmit.size() << " genomes." << std::endl;
+            QueueSubmission(genomesToResubmit, submitName.str());
+        }
+
+        // the job exited normally but the result never arrived, e.g. the wrapper couldn't reach us
+        boost::posix_time::ptime now(boost::posix_time::second_clock::local_time());
+        std::map<std::size_t, boost::posix_time::ptime>::iterator finishedItr = mFinishedWithoutResult.begin();
+        while (finishedItr != mFinishedWithoutResult.end())
+        {
+            if (mGenomesAwaitingResults.find(finishedItr->first) == mGenomesAwaitingResults.end())
+            {
+                mFinishedWithoutResult.erase(finishedItr++);
+            }
+            else if ((now - finishedItr->second).total_seconds() >= static_cast<long>(mResultGraceSeconds))
+            {
+                FailGenome(finishedItr->first, "Job finished without sending a result", "");
+                mFinishedWithoutResult.erase(finishedItr++);
+            }
+            else
+            {
+                ++finishedItr;
+            }
+        }
     }
 
     //______________________________________________________________________________________________________________
 
-    void HTCondor::SortPopulation(void)
+    void HTCondor::ResubmitOrFail(GenomePtr genome, const std::string& reason, const std::string& host, std::vector<GenomePtr>& genomesToResubmit)
     {
-        std::sort(mGenomeCache->begin(), mGenomeCache->end(), CompareGenomeByObjective);
+        ReleaseDispatch(genome->GetGenomeID());
+        if (mResubmitCounts[genome->GetGenomeID()]++ < mMaxResubmits)
+        {
+            Metrics::Instance().Increment(Metrics::JOBS_RESUBMITTED);
+            genomesToResubmit.push_back(genome);
+        }
+        else
+        {
+            FailGenome(genome->GetGenomeID(), reason, host);
+        }
     }
 
     //______________________________________________________________________________________________________________
+    // The failure is handled like an error result from the wrapper
+    void HTCondor::FailGenome(std::size_t genomeID, const std::string& reason, const std::string& host)
+    {
+        ReleaseDispatch(genomeID);
+        Metrics::Instance().Increment(Metrics::JOBS_FAILED);
+        ResultMessage result;
+        result.Clear();
+        result.mGenomeID = genomeID;
+        result.mStatus = RESULT_STATUS_ERROR;
+        result.SetError(reason.c_str(), reason.size());
+        result.SetHost(host.c_str(), host.size());
+        mFailedResults.push_back(result);
+    }
 
-    void HTCondor::WaitForResults(void)
+    //______________________________________________________________________________________________________________
+    // Failed jobs were counted by FailGenome, so only results from the wrappers are counted here
+    bool HTCondor::PopResult(ResultMessage& result)
+    {
+        if (!mFailedResults.empty())
+        {
+            result = mFailedResults.back();
+            mFailedResults.pop_back();
+            return true;
+        }
+        if (!mResultsReceiver->Pop(result, mExperimentID))
+        {
+            return false;
+        }
+
+        Metrics& metrics = Metrics::Instance();
+        metrics.Increment(Metrics::RESULTS_RECEIVED);
+        if (result.mStatus != RESULT_STATUS_OK)
+        {
+            metrics.Increment(Metrics::RESULT_ERRORS);
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Removes the jobs whose results are no longer wanted, one job at a time so that nothing else in the same cluster
+    // (such as carried over genomes) is touched. With carry-over-incomplete, genomes that are still running are left
+    // alone to report during the next generation, unless they have already been carried over carry-over-max-generations
+    // times.
+    void HTCondor::CancelUnwantedJobs(bool cancelAll)
     {
-        zmq::socket_t resultsSocket(mZmqContext, ZMQ_REP);
+        std::vector<CondorJobID> jobsToRemove;
+        std::map<CondorJobID, std::size_t>::iterator jobItr = mJobGenomes.begin();
+        while (jobItr != mJobGenomes.end())
+        {
+            std::size_t genomeID = jobItr->second;
+            if (mGenomesAwaitingResults.find(genomeID) == mGenomesAwaitingResults.end())
+            {
+                // finished
+                mJobGenomes.erase(jobItr++);
+                continue;
+            }
 
-        // this is required due to a bug in zeromq which causes the app to hang when the context is terminated
-        int linger = 0;
-        resultsSocket.setsockopt (ZMQ_LINGER, &linger, sizeof (linger));
+            if (!cancelAll && mCarryOverIncomplete && 
+                (mGenerationNumber - mGenomeSubmitGenerations[genomeID]) < mCarryOverMaxGenerations)
+            {
+                ++jobItr;
+                continue;
+            }
 
-        std::ostringstream s;
-        s << "tcp://*:" <<  mGAPort;
-        resultsSocket.bind(s.str().c_str());
+            jobsToRemove.push_back(jobItr->first);
+            mJobGenomes.erase(jobItr++);
+        }
+
+        // anything left awaiting a result without a job has either been cancelled or was never submitted
+        std::set<std::size_t> genomesWithJobs;
+        for (std::map<CondorJobID, std::size_t>::const_iterator itr = mJobGenomes.begin(); itr != mJobGenomes.end(); ++itr)
+        {
+            genomesWithJobs.insert(itr->second);
+        }
+
+        boost::unordered_map<std::size_t, GenomePtr>::iterator genomeItr = mGenomesAwaitingResults.begin();
+        while (genomeItr != mGenomesAwaitingResults.end())
+        {
+            if (genomesWithJobs.count(genomeItr->first) > 0)
+            {
+                ++genomeItr;
+            }
+            else
+            {
+                ReleaseDispatch(genomeItr->first);
+                mGenomeSubmitGenerations.erase(genomeItr->first);
+                genomeItr = mGenomesAwaitingResults.erase(genomeItr);
+            }
+        }
+
+        RemoveJobs(jobsToRemove);
 
-        zmq::pollitem_t items [] = 
+        if (!mGenomesAwaitingResults.empty())
         {
-            { resultsSocket, 0, ZMQ_POLLIN, 0 }
-        };
+            FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Carrying " << mGenomesAwaitingResults.size() << " running genomes over to the next generation.";
+        }
+    }
+
+    //______________________________________________________________________________________________________________
 
+    std::vector<GenomePtr> HTCondor::GetGenomesInFlight(void) const
+    {
+        std::vector<GenomePtr> genomes;
+        for (boost::unordered_map<std::size_t, GenomePtr>::const_iterator itr = mGenomesAwaitingResults.begin(); itr != mGenomesAwaitingResults.end(); ++itr)
+        {
+            genomes.push_back(itr->second);
+        }
+        return genomes;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void HTCondor::SortPopulation(void)
+    {
+        std::sort(mGenomeCache->begin(), mGenomeCache->end(), CompareGenomeByObjective);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void HTCondor::WaitForResults(void)
+    {
+        ScopedTraceSpan span("WaitForResults", TraceRecorder::TRACK_GA);
         boost::posix_time::time_duration::sec_type timeOutPeriod = mTimeoutMinutes * 60;
         boost::posix_time::time_duration::sec_type secondsLeft = timeOutPeriod;
         std::size_t receivedCount = 0;
-        std::size_t bailOutCount = mGenomesToTest->size(); //std::min(numberOfJobs, static_cast<std::size_t>(floor(0.95 * numberOfJobs)));
+        // includes any genomes carried over from the previous generation
+        std::size_t bailOutCount = mGenomesAwaitingResults.size(); //std::min(numberOfJobs, static_cast<std::size_t>(floor(0.95 * numberOfJobs)));
 
         std::cout << "Waiting for (" << bailOutCount << ") results on port " << mGAPort << " for generation " << mGenerationNumber << 
             ". Num of jobs is " << mGenomesToTest->size() << ". Max wait time is " << 
@@ -343,43 +1220,55 @@ namespace GridGALib
 
         // NB when using ZeroMQ on Linux, boost::timer doesn't work
         boost::posix_time::ptime startTime(boost::posix_time::second_clock::local_time());
-        while (1) 
+        bool receivedAll = (receivedCount == bailOutCount);
+        while (!receivedAll) 
         {
-            zmq::poll(items, 1, static_cast<long>(secondsLeft * 1000));
+            mResultsReceiver->WaitForResults(static_cast<long>(std::min<boost::posix_time::time_duration::sec_type>(secondsLeft, 1) * 1000), mExperimentID);
+            ProcessJobEvents();
             boost::posix_time::ptime currentTime(boost::posix_time::second_clock::local_time());
+            // the timeout only starts once the dispatch scheduler has let every genome be submitted, so genomes held
+            // back for other experiments aren't dropped before they've had a chance to run
+            if (IsWaitingForDispatch())
+            {
+                startTime = currentTime;
+            }
             boost::posix_time::time_duration timeDuration = currentTime - startTime;
             boost::posix_time::time_duration::sec_type elapsedSeconds = 
                 (timeDuration.seconds() + (60 * timeDuration.minutes()) + (3600 * timeDuration.hours())); 
             secondsLeft = timeOutPeriod - elapsedSeconds;
 
-            if (items[0].revents & ZMQ_POLLIN) 
+            // drain everything the receiver has parsed so far and only sort once per batch
+            std::size_t numAdded = 0;
+            ResultMessage result;
+            Metrics& metrics = Metrics::Instance();
+            while (!receivedAll && PopResult(result))
             {
-                zmq::message_t message;
-                resultsSocket.recv(&message);
-                char* receivedString = static_cast<char*>(malloc(message.size() + 1));
-                memcpy(receivedString, message.data(), message.size());
-                receivedString[message.size()] = 0;
-                std::istringstream input(receivedString);
-
-                // Send reply back to client
-                zmq::message_t reply (4);
-                memcpy ((void *) reply.data(), "_ok_", 4);
-                resultsSocket.send (reply);
-
-                boost::property_tree::ptree pt;
-                boost::property_tree::xml_parser::read_xml(input, pt);
-                GenomePtr genome(AddCompleteGenomeToCache(pt));
-                
-                SortPopulation();
-                //StoreState();
-                if (mStoreState)
+                if (result.mStatus != RESULT_STATUS_OK)
                 {
-                    mStoreState();
+                    FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "Genome[" << result.mGenomeID << "] reported an error from " << 
+                        result.mHost << " : " << result.mError;
                 }
 
-                receivedCount++;
+                GenomePtr genome(AddCompleteGenomeToCache(result));
                 if (genome)
                 {
+                    boost::posix_time::ptime now(boost::posix_time::microsec_clock::universal_time());
+                    if (receivedCount == 0)
+                    {
+                        metrics.Set(Metrics::FIRST_RESULT_SECONDS, (now - mGenerationStartTime).total_milliseconds() / 1000.0);
+                    }
+                    if (!genome->GetSubmitTime().is_not_a_date_time())
+                    {
+                        metrics.Observe(Metrics::SUBMIT_TO_RESULT_SECONDS, (now - genome->GetSubmitTime()).total_milliseconds() / 1000.0);
+                    }
+                    if (result.mStatus == RESULT_STATUS_OK)
+                    {
+                        metrics.Observe(Metrics::EXECUTE_SECONDS, result.mExecuteMs / 1000.0);
+                    }
+                    TraceRecorder::Instance().AddGenomeSpan(genome->GetGenomeID(), genome->GetSubmitTime(), result.mHost,
+                        result.mStatus == RESULT_STATUS_OK);
+                    ++numAdded;
+                    receivedCount++;
                     std::ostringstream s;
                     s << mGenerationNumber <<"/" << receivedCount << "/" << bailOutCount << " " << 
                         genome->ToString() << ". Time left is " << 
@@ -389,16 +1278,31 @@ namespace GridGALib
                 }
                 else
                 {
-                    std::cout << "Genome not found! Received string: " << std::endl << input.str() << std::endl;
+                    metrics.Increment(Metrics::UNKNOWN_RESULTS);
+                    std::cout << "Genome not found! Received result for genome " << result.mGenomeID << " from " << result.mHost << std::endl;
                 }
 
-                if (receivedCount == bailOutCount)
+                receivedAll = (receivedCount == bailOutCount);
+            }
+            metrics.Set(Metrics::JOBS_IN_FLIGHT, static_cast<double>(mGenomesAwaitingResults.size()));
+            metrics.Write(false);
+
+            if (numAdded > 0)
+            {
+                SortPopulation();
+                //StoreState();
+                if (mStoreState)
                 {
-                    std::cout << "Received enough results (" << bailOutCount << ") for generation " << mGenerationNumber << std::endl;
-                    break;
+                    mStoreState();
                 }
             }
 
+            if (receivedAll)
+            {
+                std::cout << "Received enough results (" << bailOutCount << ") for generation " << mGenerationNumber << std::endl;
+                break;
+            }
+
             if (secondsLeft <= 0)
             {
                 FILE_LOG(logINFO) << "Wait timeout. Recevived " << receivedCount << " genomes.";
@@ -407,18 +1311,13 @@ namespace GridGALib
             }
         }
 
+        StopSubmitting();
+        CancelUnwantedJobs(false);
         if (mCondorClusterID == -1)
         {
             return;
         }
 
-        // kill any remaining jobs on the cluster - don't do this as we may have other instances of this GA
-        
-        s.str("");
-        s << "condor_rm " << mCondorClusterID;
-        FILE_LOG(logINFO) << "Removing jobs from cluster " << mCondorClusterID << " - executing command " << s.str();
-        std::system(s.str().c_str());
-
         // print the best 20 results
         FILE_LOG(logINFO) << "***********************************";
         FILE_LOG(logINFO) << "Best " << mPrintBestNum << " results for generation " << mGenerationNumber;
@@ -444,24 +1343,25 @@ namespace GridGALib
 
     //______________________________________________________________________________________________________________
 
-    GenomePtr HTCondor::AddCompleteGenomeToCache(const boost::property_tree::ptree& pt)
+    GenomePtr HTCondor::AddCompleteGenomeToCache(const ResultMessage& result)
     {
-        
-        std::size_t genomeID = pt.get("results.id", 0);
+        std::size_t genomeID = static_cast<std::size_t>(result.mGenomeID);
 
-        BOOST_FOREACH(GenomePtr genome, *mGenomesToTest)
+        // genomes are removed from the lookup once complete, so a duplicate result can't be added to the cache twice
+        boost::unordered_map<std::size_t, GenomePtr>::iterator genomeItr = mGenomesAwaitingResults.find(genomeID);
+        if (genomeItr == mGenomesAwaitingResults.end())
         {
-            if (genome->GetGenomeID() == genomeID)
-            {
-                genome->Update(pt);
-                mGenomeCache->push_back(genome);
-                return genome;
-                break;
-            }
+            std::cerr << "- Could not find genome " << genomeID;
+            return boost::shared_ptr<Genome>();
         }
 
-        std::cerr << "- Could not find genome " << genomeID;
-        return boost::shared_ptr<Genome>();
+        GenomePtr genome(genomeItr->second);
+        mGenomesAwaitingResults.erase(genomeItr);
+        mGenomeSubmitGenerations.erase(genomeID);
+        ReleaseDispatch(genomeID);
+        genome->Update(result);
+        mGenomeCache->push_back(genome);
+        return genome;
     }
 
     //______________________________________________________________________________________________________________
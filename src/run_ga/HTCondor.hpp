@@ -2,21 +2,60 @@
 
 #include "stdafx.hpp"
 
+#include "CondorUserLog.hpp"
+#include "DispatchScheduler.hpp"
+#include "Executor.hpp"
 #include "GenerateXMLConfig.hpp"
 #include "Genome.hpp"
+#include "LocalPool.hpp"
+#include "Metrics.hpp"
+#include "ResultsReceiver.hpp"
+#include "TraceRecorder.hpp"
 
 namespace GridGALib
 {
     typedef boost::function<std::string (const GenomePtr genome, const std::string& dir)> GetGenomeConfigFunc;
     typedef boost::function<void (void)> StoreStateFunc;
 
-	class HTCondor
+    // A genome's job as the submit thread writes it. Taken from the genome on the GA thread, which carries on
+    // breeding and updating genomes while the submit thread writes the files.
+    struct SubmitJob
+    {
+        std::size_t mGenomeID;
+        // replaces %GA% in the arguments
+        std::string mArguments;
+        // the genome's config-template rendered, if there is one
+        std::string mConfig;
+    };
+
+    struct SubmitChunk
+    {
+        std::string mSubmitName;
+        std::string mGenerationSubDir;
+        std::string mUserLogFileName;
+        std::vector<SubmitJob> mJobs;
+        // how many parts of the chunk have been submitted, when the dispatch scheduler grants less than all of it
+        std::size_t mNumParts;
+    };
+
+    struct SubmittedChunk
+    {
+        boost::int32_t mClusterID;
+        // in the order they were queued, i.e. by proc id
+        std::vector<std::size_t> mGenomeIDs;
+        boost::posix_time::ptime mSubmitTime;
+    };
+
+	class HTCondor : public Executor
     {
     public:
         HTCondor(std::string configTemplateFileName, zmq::context_t& zmqContext);
         ~HTCondor(void);
-        bool ReadConfig(boost::property_tree::ptree& pt);
-        bool ExecuteGeneration(GenomeList genomesToTest, GenomeList genomeCache, std::size_t generationNumber);
+        bool ReadConfig(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap) override;
+        bool ExecuteGeneration(GenomeList genomesToTest, GenomeList genomeCache, std::size_t generationNumber) override;
+        std::vector<GenomePtr> GetGenomesInFlight(void) const override;
+        // must be called before ReadConfig, when run_ga is running several experiments
+        void SetSharedExecution(const SharedExecution& sharedExecution);
     private:
         std::size_t mGenerationNumber;       
         std::size_t mNumGenerations;
@@ -27,7 +66,7 @@ namespace GridGALib
         zmq::context_t& mZmqContext;
         std::size_t mTimeoutMinutes;
         std::size_t mPrintBestNum;
-        GetGenomeConfigFunc mGetGenomeConfig;
+        bool mUseConfigTemplate;
         std::string mExecutable;
         std::string mExtractObj;
         //std::string mFullPathExecutable;
@@ -41,16 +80,76 @@ namespace GridGALib
         std::string mValuePrefix;
         std::string mServer;
         std::vector<std::string> mFiles;
+        std::string mResultFormat;
+        std::string mSpawn;
+        bool mKeepOutput;
+        std::string mObjectiveExtractor;
+        std::string mSubmitMode;
+        std::size_t mMaxResubmits;
+        std::size_t mResultGraceSeconds;
+        std::size_t mNumResubmissions;
+        std::vector<boost::shared_ptr<CondorUserLog> > mUserLogs;
+        std::vector<CondorJobEvent> mUnmatchedEvents;
+        std::vector<boost::int32_t> mClusterIDs;
+        std::map<CondorJobID, std::size_t> mJobGenomes;
+        std::map<CondorJobID, std::string> mJobHosts;
+        boost::unordered_map<std::size_t, std::size_t> mResubmitCounts;
+        std::map<std::size_t, boost::posix_time::ptime> mFinishedWithoutResult;
+        std::vector<ResultMessage> mFailedResults;
+        std::size_t mSubmitChunkSize;
+        boost::thread mSubmitThread;
+        boost::mutex mSubmitMutex;
+        std::deque<SubmitChunk> mSubmitQueue;
+        std::vector<SubmittedChunk> mSubmittedChunks;
+        bool mSubmitting;
+        bool mCancelSubmit;
+        // the submit thread is waiting for the dispatch scheduler to grant it jobs
+        bool mWaitingForDispatch;
+        bool mCarryOverIncomplete;
+        std::size_t mCarryOverMaxGenerations;
+        std::string mStagingCacheDir;
+        std::vector<StagedFile> mStagedFiles;
+        boost::unordered_map<std::size_t, std::size_t> mGenomeSubmitGenerations;
+        boost::shared_ptr<ResultsReceiver> mResultsReceiver;
+        // set when the receiver, and the jobs in flight, are shared with other experiments
+        bool mSharedReceiver;
+        boost::shared_ptr<DispatchScheduler> mScheduler;
+        std::size_t mExperimentID;
+        // the genomes holding one of the scheduler's jobs, guarded by mSubmitMutex
+        std::set<std::size_t> mDispatchedGenomes;
+        boost::scoped_ptr<LocalPool> mLocalPool;
+        boost::unordered_map<std::size_t, GenomePtr> mGenomesAwaitingResults;
+        boost::posix_time::ptime mGenerationStartTime;
 
-        std::string WriteSubmitFile(void);
+        bool LoadStagedFile(const std::string& fileName, StagedFile& stagedFile);
+        std::string GetUserLogFileName(void) const;
+        void PrepareGeneration(void);
+        std::string WriteSubmitFile(const SubmitChunk& chunk);
+        void WriteQueueTable(std::ofstream& submitFile, const SubmitChunk& chunk);
+        static std::string EscapeQueueTableArguments(const std::string& arguments);
+        void WriteJobConfig(const std::string& fileName, const std::string& execute, const std::string& genomeID);
         //std::string GetPythonFiles(void);
         void SortPopulation(void);
-        void SubmitToCluster(const std::string& submitFileName);
+        void QueueSubmission(const std::vector<GenomePtr>& genomes, const std::string& submitName);
+        // metrics and traceRecorder are the GA thread's, so the submit thread records to the same experiment
+        void SubmitLoop(Metrics* metrics, TraceRecorder* traceRecorder);
+        void StopSubmitting(void);
+        bool IsSubmitCancelled(void);
+        bool IsWaitingForDispatch(void);
+        void ReleaseDispatch(std::size_t genomeID);
+        bool RegisterSubmittedChunks(std::vector<std::size_t>& failedGenomeIDs);
+        boost::int32_t SubmitToCluster(const std::string& submitFileName);
+        void RemoveJobs(const std::vector<CondorJobID>& jobIDs);
+        void ProcessJobEvents(void);
+        void ResubmitOrFail(GenomePtr genome, const std::string& reason, const std::string& host, std::vector<GenomePtr>& genomesToResubmit);
+        void FailGenome(std::size_t genomeID, const std::string& reason, const std::string& host);
+        bool PopResult(ResultMessage& result);
+        void CancelUnwantedJobs(bool cancelAll);
         void SendTestMessage(std::string machineName, std::string sendString);
         void SendString(void* socket, const std::string& sendString) const; 
         //void StoreState(void) const;
         //bool RestoreState(void); 
         void WaitForResults(void);
-        GenomePtr AddCompleteGenomeToCache(const boost::property_tree::ptree& pt);
+        GenomePtr AddCompleteGenomeToCache(const ResultMessage& result);
     };
 }
\ No newline at end of file
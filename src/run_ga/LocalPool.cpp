@@ -0,0 +1,731 @@
+#include "stdafx.hpp"
+#include "LocalPool.hpp"
+
+#include <boost/random/uniform_real_distribution.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace GridGALib
+{
+    namespace
+    {
+#ifdef _WIN32
+        typedef HANDLE ProcessHandle;
+#else
+        typedef pid_t ProcessHandle;
+#endif
+
+        // Starts the job's executable in its sandbox with stdout and stderr going to the files HTCondor would send
+        // them to. processID can be used to kill it from another thread until CloseProcess() is called.
+        bool StartProcess(const std::string& directory, const std::vector<std::string>& arguments, const std::string& output,
+            const std::string& error, ProcessHandle& handle, boost::int64_t& processID)
+        {
+#ifdef _WIN32
+            SECURITY_ATTRIBUTES securityAttributes;
+            securityAttributes.nLength = sizeof(SECURITY_ATTRIBUTES);
+            securityAttributes.bInheritHandle = TRUE;
+            securityAttributes.lpSecurityDescriptor = NULL;
+
+            HANDLE outputFile = CreateFileA(output.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &securityAttributes, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+            HANDLE errorFile = CreateFileA(error.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &securityAttributes, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+            std::ostringstream commandLine;
+            BOOST_FOREACH(const std::string& argument, arguments)
+            {
+                commandLine << "\"" << argument << "\" ";
+            }
+            std::string commandLineString(commandLine.str());
+            std::vector<char> commandLineBuffer(commandLineString.begin(), commandLineString.end());
+            commandLineBuffer.push_back(0);
+
+            STARTUPINFOA startupInfo;
+            ZeroMemory(&startupInfo, sizeof(startupInfo));
+            startupInfo.cb = sizeof(startupInfo);
+            startupInfo.hStdOutput = outputFile;
+            startupInfo.hStdError = errorFile;
+            startupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+            startupInfo.dwFlags |= STARTF_USESTDHANDLES;
+
+            PROCESS_INFORMATION processInfo;
+            ZeroMemory(&processInfo, sizeof(processInfo));
+            BOOL created = CreateProcessA(NULL, &commandLineBuffer[0], NULL, NULL, TRUE, 0, NULL, directory.c_str(), &startupInfo, &processInfo);
+            CloseHandle(outputFile);
+            CloseHandle(errorFile);
+            if (!created)
+            {
+                return false;
+            }
+            CloseHandle(processInfo.hThread);
+            handle = processInfo.hProcess;
+            processID = static_cast<boost::int64_t>(processInfo.dwProcessId);
+            return true;
+#else
+            // everything the child needs is set up before the fork, as only async-signal-safe calls can be made after it
+            std::vector<char*> argv;
+            BOOST_FOREACH(const std::string& argument, arguments)
+            {
+                argv.push_back(const_cast<char*>(argument.c_str()));
+            }
+            argv.push_back(NULL);
+            std::string program(directory + "/" + arguments.front());
+            long maxFd = sysconf(_SC_OPEN_MAX);
+            maxFd = (maxFd < 0 || maxFd > 65536) ? 65536 : maxFd;
+
+            pid_t pid = fork();
+            if (pid < 0)
+            {
+                return false;
+            }
+            if (pid == 0)
+            {
+                int outputFd = open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                int errorFd = open(error.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (outputFd >= 0)
+                {
+                    dup2(outputFd, STDOUT_FILENO);
+                    close(outputFd);
+                }
+                if (errorFd >= 0)
+                {
+                    dup2(errorFd, STDERR_FILENO);
+                    close(errorFd);
+                }
+                // nothing else of ours, like the results sockets or a file another slot is copying, goes to the job
+                for (long fd = STDERR_FILENO + 1; fd < maxFd; ++fd)
+                {
+                    close(static_cast<int>(fd));
+                }
+                if (chdir(directory.c_str()) == 0)
+                {
+                    // the executable can still be open for writing in a child of another slot that hasn't reached
+                    // exec yet
+                    for (int attempt = 0; attempt < 100; ++attempt)
+                    {
+                        execv(program.c_str(), &argv[0]);
+                        if (errno != ETXTBSY)
+                        {
+                            break;
+                        }
+                        struct timespec delay = { 0, 10000000 };
+                        nanosleep(&delay, NULL);
+                    }
+                }
+                _exit(127);
+            }
+            handle = pid;
+            processID = static_cast<boost::int64_t>(pid);
+            return true;
+#endif
+        }
+
+        //______________________________________________________________________________________________________________
+        // Doesn't reap the process, so its id can't be reused until CloseProcess()
+        bool ProcessExited(ProcessHandle handle, bool& signalled, boost::int32_t& returnValue)
+        {
+#ifdef _WIN32
+            if (WaitForSingleObject(handle, 0) != WAIT_OBJECT_0)
+            {
+                return false;
+            }
+            DWORD exitCode = 0;
+            GetExitCodeProcess(handle, &exitCode);
+            signalled = false;
+            returnValue = static_cast<boost::int32_t>(exitCode);
+            return true;
+#else
+            siginfo_t info;
+            std::memset(&info, 0, sizeof(info));
+            if (waitid(P_PID, handle, &info, WEXITED | WNOHANG | WNOWAIT) != 0 || info.si_pid == 0)
+            {
+                return false;
+            }
+            signalled = (info.si_code == CLD_KILLED || info.si_code == CLD_DUMPED);
+            returnValue = info.si_status;
+            return true;
+#endif
+        }
+
+        //______________________________________________________________________________________________________________
+
+        void CloseProcess(ProcessHandle handle)
+        {
+#ifdef _WIN32
+            CloseHandle(handle);
+#else
+            int status = 0;
+            while (waitpid(handle, &status, 0) < 0 && errno == EINTR)
+            {
+            }
+#endif
+        }
+
+        //______________________________________________________________________________________________________________
+
+        void KillProcess(boost::int64_t processID)
+        {
+#ifdef _WIN32
+            HANDLE process = OpenProcess(PROCESS_TERMINATE, FALSE, static_cast<DWORD>(processID));
+            if (process)
+            {
+                TerminateProcess(process, 9);
+                CloseHandle(process);
+            }
+#else
+            kill(static_cast<pid_t>(processID), SIGKILL);
+#endif
+        }
+
+        //______________________________________________________________________________________________________________
+        // The new syntax, in double quotes, groups arguments in single quotes and takes a doubled quote of either kind
+        // as a literal one, the old one only splits on whitespace
+        std::vector<std::string> SplitArguments(std::string arguments)
+        {
+            bool newSyntax = arguments.size() >= 2 && arguments[0] == '"' && arguments[arguments.size() - 1] == '"';
+            if (newSyntax)
+            {
+                arguments = arguments.substr(1, arguments.size() - 2);
+            }
+
+            std::vector<std::string> split;
+            std::string argument;
+            bool inQuotes = false;
+            bool haveArgument = false;
+            for (std::size_t i = 0; i < arguments.size(); ++i)
+            {
+                char c = arguments[i];
+                if (newSyntax && (c == '"' || (c == '\'' && inQuotes)) && i + 1 < arguments.size() && arguments[i + 1] == c)
+                {
+                    argument += c;
+                    haveArgument = true;
+                    ++i;
+                }
+                else if (newSyntax && c == '\'')
+                {
+                    inQuotes = !inQuotes;
+                    haveArgument = true;
+                }
+                else if (!inQuotes && isspace(static_cast<unsigned char>(c)))
+                {
+                    if (haveArgument)
+                    {
+                        split.push_back(argument);
+                        argument.clear();
+                        haveArgument = false;
+                    }
+                }
+                else
+                {
+                    argument += c;
+                    haveArgument = true;
+                }
+            }
+            if (haveArgument)
+            {
+                split.push_back(argument);
+            }
+            return split;
+        }
+
+        //______________________________________________________________________________________________________________
+        // $(name) is replaced by the queue variable of that name, whose own macros are expanded too, and $(DOLLAR) by
+        // a $. Names aren't case sensitive.
+        std::string ExpandMacros(const std::string& value, const std::map<std::string, std::string>& variables)
+        {
+            std::string expanded;
+            std::size_t position = 0;
+            std::size_t macroStart;
+            while ((macroStart = value.find("$(", position)) != std::string::npos)
+            {
+                std::size_t macroEnd = value.find(')', macroStart);
+                if (macroEnd == std::string::npos)
+                {
+                    break;
+                }
+                expanded.append(value, position, macroStart - position);
+                std::string name(boost::to_lower_copy(value.substr(macroStart + 2, macroEnd - macroStart - 2)));
+                std::map<std::string, std::string>::const_iterator variable = variables.find(name);
+                if (name == "dollar")
+                {
+                    expanded += '$';
+                }
+                else if (variable != variables.end())
+                {
+                    expanded += ExpandMacros(variable->second, variables);
+                }
+                position = macroEnd + 1;
+            }
+            expanded.append(value, position, std::string::npos);
+            return expanded;
+        }
+
+        //______________________________________________________________________________________________________________
+
+        std::string AbsolutePath(const std::string& path)
+        {
+            return boost::filesystem::absolute(path).string();
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    LocalPool::LocalPool(const std::string& filesLocation, const LocalPoolSettings& settings)
+    :
+        mFilesLocation(filesLocation),
+        mSandboxLocation(AbsolutePath(filesLocation + "/local-pool")),
+        mSettings(settings),
+        mNextClusterID(1),
+        mStopping(false),
+        mRandom(static_cast<boost::uint32_t>(time(NULL)))
+    {
+        boost::filesystem::create_directories(mSandboxLocation);
+        mSettings.mNumSlots = std::max<std::size_t>(mSettings.mNumSlots, 1);
+        for (std::size_t slot = 1; slot <= mSettings.mNumSlots; ++slot)
+        {
+            mSlotThreads.create_thread(boost::bind(&LocalPool::SlotLoop, this, slot));
+        }
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Running jobs locally in " << mSettings.mNumSlots << " slots.";
+    }
+
+    //______________________________________________________________________________________________________________
+
+    LocalPool::~LocalPool(void)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mMutex);
+            mStopping = true;
+            for (std::map<CondorJobID, JobPtr>::iterator jobItr = mJobs.begin(); jobItr != mJobs.end(); ++jobItr)
+            {
+                if (jobItr->second->mState == JOB_RUNNING && jobItr->second->mProcessID != -1)
+                {
+                    KillProcess(jobItr->second->mProcessID);
+                }
+            }
+        }
+        mJobQueued.notify_all();
+        mSlotThreads.join_all();
+    }
+
+    //______________________________________________________________________________________________________________
+
+    boost::int32_t LocalPool::Submit(const std::string& submitFileName)
+    {
+        boost::int32_t clusterID;
+        {
+            boost::lock_guard<boost::mutex> lock(mMutex);
+            clusterID = mNextClusterID++;
+        }
+
+        std::vector<JobPtr> jobs;
+        if (!ReadSubmitFile(submitFileName, clusterID, jobs))
+        {
+            return -1;
+        }
+
+        BOOST_FOREACH(JobPtr job, jobs)
+        {
+            WriteEvent(*job, CONDOR_EVENT_SUBMIT, "Job submitted from host: <127.0.0.1:0?sock=local-pool>");
+        }
+
+        {
+            boost::lock_guard<boost::mutex> lock(mMutex);
+            boost::posix_time::ptime startAfter(boost::posix_time::microsec_clock::universal_time() +
+                boost::posix_time::milliseconds(mSettings.mQueueLatencyMs));
+            BOOST_FOREACH(JobPtr job, jobs)
+            {
+                job->mStartAfter = startAfter;
+                mJobs[job->mJobID] = job;
+                mIdleJobs.push_back(job);
+            }
+        }
+        mJobQueued.notify_all();
+
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << jobs.size() << " job(s) submitted to local cluster " << clusterID << ".";
+        return clusterID;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Only what WriteSubmitFile writes is understood: key = value lines, then either a plain Queue after each job or
+    // a single Queue ... from ( table )
+    bool LocalPool::ReadSubmitFile(const std::string& submitFileName, boost::int32_t clusterID, std::vector<JobPtr>& jobs) const
+    {
+        std::ifstream submitFile(submitFileName.c_str());
+        if (!submitFile)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- Cannot open " << submitFileName;
+            return false;
+        }
+
+        // the attributes as they stood at the Queue statement, and the row's variables for a table
+        typedef std::map<std::string, std::string> StringMap;
+        std::vector<std::pair<StringMap, StringMap> > queued;
+        StringMap attributes;
+        std::vector<std::string> tableVariables;
+        bool inTable = false;
+        std::string line;
+        while (std::getline(submitFile, line))
+        {
+            boost::trim(line);
+            if (inTable)
+            {
+                if (line == ")")
+                {
+                    inTable = false;
+                    continue;
+                }
+                if (line.empty())
+                {
+                    continue;
+                }
+                // the last variable takes the rest of the row
+                StringMap variables;
+                std::size_t position = 0;
+                for (std::size_t i = 0; i < tableVariables.size(); ++i)
+                {
+                    std::size_t comma = (i + 1 < tableVariables.size()) ? line.find(',', position) : std::string::npos;
+                    variables[tableVariables[i]] = boost::trim_copy(line.substr(position, comma == std::string::npos ? std::string::npos : comma - position));
+                    position = (comma == std::string::npos) ? line.size() : comma + 1;
+                }
+                queued.push_back(std::make_pair(attributes, variables));
+                continue;
+            }
+
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+
+            if (boost::istarts_with(line, "queue"))
+            {
+                std::string rest(boost::trim_copy(line.substr(5)));
+                std::size_t from = boost::to_lower_copy(rest).find(" from");
+                if (from != std::string::npos)
+                {
+                    std::string variableList(boost::to_lower_copy(rest.substr(0, from)));
+                    boost::split(tableVariables, variableList, boost::is_any_of(", "), boost::token_compress_on);
+                    inTable = true;
+                    continue;
+                }
+
+                std::size_t count = rest.empty() ? 1 : static_cast<std::size_t>(std::max(atoi(rest.c_str()), 0));
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    queued.push_back(std::make_pair(attributes, StringMap()));
+                }
+                continue;
+            }
+
+            std::size_t equals = line.find('=');
+            if (equals != std::string::npos)
+            {
+                attributes[boost::to_lower_copy(boost::trim_copy(line.substr(0, equals)))] = boost::trim_copy(line.substr(equals + 1));
+            }
+        }
+
+        for (std::size_t proc = 0; proc < queued.size(); ++proc)
+        {
+            StringMap& variables = queued[proc].second;
+            variables["cluster"] = CommonLib::SomethingToString(clusterID);
+            variables["process"] = CommonLib::SomethingToString(proc);
+
+            StringMap expanded;
+            for (StringMap::const_iterator itr = queued[proc].first.begin(); itr != queued[proc].first.end(); ++itr)
+            {
+                expanded[itr->first] = ExpandMacros(itr->second, variables);
+            }
+
+            JobPtr job(boost::make_shared<Job>());
+            job->mJobID = CondorJobID(clusterID, static_cast<boost::int32_t>(proc));
+            job->mState = JOB_IDLE;
+            job->mProcessID = -1;
+            job->mExecutable = expanded["executable"];
+            job->mArguments = SplitArguments(expanded["arguments"]);
+            std::vector<std::string> inputFiles;
+            boost::split(inputFiles, expanded["transfer_input_files"], boost::is_any_of(","));
+            BOOST_FOREACH(std::string& inputFile, inputFiles)
+            {
+                boost::trim(inputFile);
+                if (!inputFile.empty())
+                {
+                    job->mInputFiles.push_back(AbsolutePath(inputFile));
+                }
+            }
+            job->mOutput = expanded["output"].empty() ? "" : AbsolutePath(expanded["output"]);
+            job->mError = expanded["error"].empty() ? "" : AbsolutePath(expanded["error"]);
+            job->mUserLog = expanded["log"].empty() ? "" : AbsolutePath(expanded["log"]);
+            if (job->mExecutable.empty())
+            {
+                FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- No executable in " << submitFileName;
+                return false;
+            }
+            jobs.push_back(job);
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void LocalPool::Remove(const std::vector<CondorJobID>& jobIDs)
+    {
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        BOOST_FOREACH(const CondorJobID& jobID, jobIDs)
+        {
+            std::map<CondorJobID, JobPtr>::iterator jobItr = mJobs.find(jobID);
+            if (jobItr == mJobs.end())
+            {
+                continue;
+            }
+
+            JobPtr job(jobItr->second);
+            if (job->mState == JOB_RUNNING)
+            {
+                // the slot writes the event once the process has gone
+                job->mState = JOB_REMOVED;
+                if (job->mProcessID != -1)
+                {
+                    KillProcess(job->mProcessID);
+                }
+                continue;
+            }
+
+            if (job->mState == JOB_IDLE)
+            {
+                mIdleJobs.erase(std::remove(mIdleJobs.begin(), mIdleJobs.end(), job), mIdleJobs.end());
+            }
+            WriteEvent(*job, CONDOR_EVENT_ABORTED, "Job was aborted.\n\tvia condor_rm (by user local-pool)");
+            mJobs.erase(jobItr);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void LocalPool::SlotLoop(std::size_t slot)
+    {
+        while (true)
+        {
+            JobPtr job;
+            {
+                boost::unique_lock<boost::mutex> lock(mMutex);
+                while (!mStopping)
+                {
+                    // the queue is in submit order, but evicted jobs wait out the latency again
+                    boost::posix_time::ptime now(boost::posix_time::microsec_clock::universal_time());
+                    boost::posix_time::ptime nextStart(now + boost::posix_time::seconds(1));
+                    std::deque<JobPtr>::iterator jobItr = mIdleJobs.begin();
+                    for ( ; jobItr != mIdleJobs.end(); ++jobItr)
+                    {
+                        if ((*jobItr)->mStartAfter <= now)
+                        {
+                            break;
+                        }
+                        nextStart = std::min(nextStart, (*jobItr)->mStartAfter);
+                    }
+                    if (jobItr != mIdleJobs.end())
+                    {
+                        job = *jobItr;
+                        mIdleJobs.erase(jobItr);
+                        job->mState = JOB_RUNNING;
+                        break;
+                    }
+                    mJobQueued.timed_wait(lock, nextStart - now);
+                }
+                if (mStopping)
+                {
+                    return;
+                }
+            }
+
+            RunJob(job, slot);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void LocalPool::RunJob(JobPtr job, std::size_t slot)
+    {
+        std::ostringstream host;
+        host << "slot" << slot << "@localhost";
+
+        // what is going to go wrong, if anything
+        double roll;
+        double killAfterMs;
+        {
+            boost::lock_guard<boost::mutex> lock(mMutex);
+            roll = boost::random::uniform_real_distribution<double>(0.0, 100.0)(mRandom);
+            killAfterMs = boost::random::uniform_real_distribution<double>(0.0, static_cast<double>(mSettings.mEvictAfterMs))(mRandom);
+        }
+        bool hold = roll < mSettings.mHoldPercent;
+        bool evict = !hold && roll < mSettings.mHoldPercent + mSettings.mEvictPercent;
+        bool fail = !hold && !evict && roll < mSettings.mHoldPercent + mSettings.mEvictPercent + mSettings.mFailPercent;
+        if (evict)
+        {
+            killAfterMs = static_cast<double>(mSettings.mEvictAfterMs);
+        }
+
+        std::ostringstream sandbox;
+        sandbox << mSandboxLocation << "/" << job->mJobID.first << "." << job->mJobID.second;
+        std::string sandboxDir(sandbox.str());
+
+        std::string holdReason;
+        if (hold)
+        {
+            holdReason = "Hold injected by the local pool";
+        }
+        else
+        {
+            // transfer the input files
+            try
+            {
+                boost::filesystem::remove_all(sandboxDir);
+                boost::filesystem::create_directories(sandboxDir);
+                std::vector<std::string> files(job->mInputFiles);
+                files.push_back(AbsolutePath(job->mExecutable));
+                BOOST_FOREACH(const std::string& file, files)
+                {
+                    boost::filesystem::copy_file(file, sandboxDir + "/" + boost::filesystem::path(file).filename().string(),
+                        boost::filesystem::copy_option::overwrite_if_exists);
+                }
+            }
+            catch (std::exception& e)
+            {
+                holdReason = std::string("Error from ") + host.str() + ": failed to transfer files: " + e.what();
+            }
+        }
+
+        if (!holdReason.empty())
+        {
+            boost::lock_guard<boost::mutex> lock(mMutex);
+            if (job->mState == JOB_REMOVED)
+            {
+                WriteEvent(*job, CONDOR_EVENT_ABORTED, "Job was aborted.\n\tvia condor_rm (by user local-pool)");
+                mJobs.erase(job->mJobID);
+            }
+            else
+            {
+                // stays held until it's removed
+                job->mState = JOB_HELD;
+                WriteEvent(*job, CONDOR_EVENT_HELD, "Job was held.\n\t" + holdReason + "\n\tCode 0 Subcode 0");
+            }
+            boost::filesystem::remove_all(sandboxDir);
+            return;
+        }
+
+        WriteEvent(*job, CONDOR_EVENT_EXECUTE, "Job executing on host: <" + host.str() + ">");
+
+        std::vector<std::string> arguments;
+        arguments.push_back(boost::filesystem::path(job->mExecutable).filename().string());
+        arguments.insert(arguments.end(), job->mArguments.begin(), job->mArguments.end());
+        std::string output(job->mOutput.empty() ? sandboxDir + "/_condor_stdout" : job->mOutput);
+        std::string error(job->mError.empty() ? sandboxDir + "/_condor_stderr" : job->mError);
+
+        ProcessHandle handle;
+        boost::int64_t processID = -1;
+        if (!StartProcess(sandboxDir, arguments, output, error, handle, processID))
+        {
+            WriteEvent(*job, CONDOR_EVENT_EXECUTABLE_ERROR, "Error from " + host.str() + ": Failed to execute '" + arguments.front() + "'");
+            boost::lock_guard<boost::mutex> lock(mMutex);
+            mJobs.erase(job->mJobID);
+            boost::filesystem::remove_all(sandboxDir);
+            return;
+        }
+
+        bool killed = false;
+        {
+            boost::lock_guard<boost::mutex> lock(mMutex);
+            job->mProcessID = processID;
+            if (job->mState == JOB_REMOVED || mStopping)
+            {
+                KillProcess(processID);
+                killed = true;
+            }
+        }
+
+        boost::posix_time::ptime startTime(boost::posix_time::microsec_clock::universal_time());
+        bool signalled = false;
+        boost::int32_t returnValue = 0;
+        while (!ProcessExited(handle, signalled, returnValue))
+        {
+            if (!killed && (evict || fail) &&
+                (boost::posix_time::microsec_clock::universal_time() - startTime).total_milliseconds() >= static_cast<boost::int64_t>(killAfterMs))
+            {
+                KillProcess(processID);
+                killed = true;
+            }
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(20));
+        }
+
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        job->mProcessID = -1;
+        CloseProcess(handle);
+        boost::filesystem::remove_all(sandboxDir);
+
+        if (job->mState == JOB_REMOVED || mStopping)
+        {
+            WriteEvent(*job, CONDOR_EVENT_ABORTED, "Job was aborted.\n\tvia condor_rm (by user local-pool)");
+            mJobs.erase(job->mJobID);
+        }
+        else if (evict && killed)
+        {
+            // HTCondor puts an evicted vanilla job back in the queue
+            WriteEvent(*job, CONDOR_EVENT_EVICTED, "Job was evicted.\n\t(0) Job was not checkpointed.\n\tEviction injected by the local pool");
+            job->mState = JOB_IDLE;
+            job->mStartAfter = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(mSettings.mQueueLatencyMs);
+            mIdleJobs.push_back(job);
+            mJobQueued.notify_one();
+        }
+        else if (fail && killed)
+        {
+            WriteEvent(*job, CONDOR_EVENT_TERMINATED, "Job terminated.\n\t(0) Abnormal termination (signal 9)\n\t(0) No core file");
+            mJobs.erase(job->mJobID);
+        }
+        else
+        {
+            std::ostringstream text;
+            if (signalled)
+            {
+                text << "Job terminated.\n\t(0) Abnormal termination (signal " << returnValue << ")\n\t(0) No core file";
+            }
+            else
+            {
+                text << "Job terminated.\n\t(1) Normal termination (return value " << returnValue << ")";
+            }
+            WriteEvent(*job, CONDOR_EVENT_TERMINATED, text.str());
+            mJobs.erase(job->mJobID);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // e.g.
+    //   005 (1234.003.000) 05/14 10:21:33 Job terminated.
+    //       (1) Normal termination (return value 0)
+    //   ...
+    void LocalPool::WriteEvent(const Job& job, CondorEventCode eventCode, const std::string& text)
+    {
+        if (job.mUserLog.empty())
+        {
+            return;
+        }
+
+        std::tm time = boost::posix_time::to_tm(boost::posix_time::second_clock::local_time());
+        char timeStamp[32];
+        strftime(timeStamp, sizeof(timeStamp), "%m/%d %H:%M:%S", &time);
+
+        char header[64];
+        sprintf(header, "%03d (%03d.%03d.000) ", static_cast<int>(eventCode), job.mJobID.first, job.mJobID.second);
+
+        // the whole event is written in one go, as the GA may be reading the log at the same time
+        std::string event(std::string(header) + timeStamp + " " + text + "\n...\n");
+        boost::lock_guard<boost::mutex> lock(mLogMutex);
+        std::ofstream userLog(job.mUserLog.c_str(), std::ios::app | std::ios::binary);
+        userLog << event;
+    }
+
+    //______________________________________________________________________________________________________________
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include "CondorUserLog.hpp"
+
+#include <boost/random/mersenne_twister.hpp>
+
+namespace GridGALib
+{
+    struct LocalPoolSettings
+    {
+        std::size_t mNumSlots;
+        // between a job being submitted, or put back in the queue, and it starting
+        std::size_t mQueueLatencyMs;
+        // chance of a job being evicted, held or killed instead of running to completion
+        double mEvictPercent;
+        double mHoldPercent;
+        double mFailPercent;
+        // how long an evicted job runs before it is evicted
+        std::size_t mEvictAfterMs;
+    };
+
+    // Stands in for an HTCondor pool on the machine running the GA, set up by config.htcondor.local-pool. Submit
+    // files are read the same way condor_submit reads the ones we write, and their jobs are run in a sandbox
+    // directory per job by a fixed number of slot threads. The events are written to the job's user log in HTCondor's
+    // format, so everything from the submit thread onwards, i.e. the log follower, resubmits, stragglers, cancellation
+    // and the results receiver, is exercised as it would be against a real pool. Evictions, holds and killed jobs can
+    // be injected at random.
+	class LocalPool : boost::noncopyable
+    {
+    public:
+        LocalPool(const std::string& filesLocation, const LocalPoolSettings& settings);
+        ~LocalPool(void);
+        // like condor_submit, returns the cluster id, or -1 if the submit file is no good
+        boost::int32_t Submit(const std::string& submitFileName);
+        // like condor_rm
+        void Remove(const std::vector<CondorJobID>& jobIDs);
+    private:
+        enum JobState
+        {
+            JOB_IDLE,
+            JOB_RUNNING,
+            JOB_HELD,
+            JOB_REMOVED
+        };
+
+        struct Job
+        {
+            CondorJobID mJobID;
+            JobState mState;
+            std::string mExecutable;
+            std::vector<std::string> mArguments;
+            std::vector<std::string> mInputFiles;
+            std::string mOutput;
+            std::string mError;
+            std::string mUserLog;
+            boost::posix_time::ptime mStartAfter;
+            // while it's running
+            boost::int64_t mProcessID;
+        };
+        typedef boost::shared_ptr<Job> JobPtr;
+
+        std::string mFilesLocation;
+        std::string mSandboxLocation;
+        LocalPoolSettings mSettings;
+        boost::int32_t mNextClusterID;
+        boost::mutex mMutex;
+        boost::condition_variable mJobQueued;
+        std::deque<JobPtr> mIdleJobs;
+        std::map<CondorJobID, JobPtr> mJobs;
+        boost::mutex mLogMutex;
+        bool mStopping;
+        // decides which jobs go wrong, only used with mMutex held
+        boost::random::mt19937 mRandom;
+        boost::thread_group mSlotThreads;
+
+        bool ReadSubmitFile(const std::string& submitFileName, boost::int32_t clusterID, std::vector<JobPtr>& jobs) const;
+        void SlotLoop(std::size_t slot);
+        void RunJob(JobPtr job, std::size_t slot);
+        void WriteEvent(const Job& job, CondorEventCode eventCode, const std::string& text);
+    };
+}
@@ -1,15 +1,49 @@
 #pragma once
 
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread.hpp>
 
+#include <iostream>
 #include <sstream>
 #include <string>
 #include <stdio.h>
 
 inline std::string NowTime();
+inline std::string FormatTime(const boost::posix_time::ptime& time);
 
 enum TLogLevel {logERROR, logWARNING, logINFO, logINFONOTIMESTAMP, logINFOwithCOUT, logDEBUG, logSPAM, logDEBUG2, logDEBUG3, logDEBUG4};
 
+inline const char* LogLevelToString(TLogLevel level)
+{
+	static const char* const buffer[] = {">>ERROR<<", "Warning", "info", "InfoNoTimeStamp", "Info", "debug", "spam", "debug2", "debug3", "debug4"};
+    return buffer[level];
+}
+
+// error, warning, info, debug, spam, debug2, debug3 or debug4. Anything else is defaultLevel.
+inline TLogLevel LogLevelFromString(const std::string& name, TLogLevel defaultLevel)
+{
+    static const char* const names[] = {"error", "warning", "info", "", "", "debug", "spam", "debug2", "debug3", "debug4"};
+    for (int level = logERROR; level <= logDEBUG4; ++level)
+    {
+        if (names[level][0] != 0 && name == names[level])
+        {
+            return static_cast<TLogLevel>(level);
+        }
+    }
+    return defaultLevel;
+}
+
+// The level a message is filtered at. logINFONOTIMESTAMP and logINFOwithCOUT are info messages written differently,
+// so they're shown whenever info is.
+inline TLogLevel LogLevelRank(TLogLevel level)
+{
+    return (level == logINFONOTIMESTAMP || level == logINFOwithCOUT) ? logINFO : level;
+}
+
 template <typename T>
 class Log
 {
@@ -26,6 +60,7 @@ private:
     Log(const Log&);
     Log& operator =(const Log&);
     TLogLevel mLevel;
+    boost::posix_time::ptime mTime;
 };
 
 template <typename T>
@@ -33,24 +68,21 @@ Log<T>::Log()
 {
 }
 
+// Only the time is taken here. The time stamp and level are formatted by T::Output, which may do it on another
+// thread.
 template <typename T>
 std::ostringstream& Log<T>::Get(TLogLevel level)
 {
     mLevel = level;
-	if (level != logINFONOTIMESTAMP)
-	{
-		os << NowTime();
-		os << " " << ToString(level) << ": ";
-	}
-
+    mTime = boost::posix_time::microsec_clock::local_time();
     return os;
 }
 
 template <typename T>
 Log<T>::~Log()
 {
-    os << std::endl;
-    T::Output(os.str(), mLevel);
+    std::string msg(os.str());
+    T::Output(mTime, mLevel, msg);
 }
 
 template <typename T>
@@ -63,15 +95,59 @@ TLogLevel& Log<T>::ReportingLevel()
 template <typename T>
 std::string Log<T>::ToString(TLogLevel level)
 {
-	static const char* const buffer[] = {">>ERROR<<", "Warning", "info", "InfoNoTimeStamp", "Info", "debug", "spam", "debug2", "debug3", "debug4"};
-    return buffer[level];
+    return LogLevelToString(level);
 }
 
+inline void WriteLogRecord(FILE* pStream, const boost::posix_time::ptime& time, TLogLevel level, const std::string& msg)
+{
+    if (level != logINFONOTIMESTAMP)
+    {
+        fprintf(pStream, "%s %s: ", FormatTime(time).c_str(), LogLevelToString(level));
+    }
+    fprintf(pStream, "%s\n", msg.c_str());
+}
+
+// Hands log records from any thread to a single writer thread through a bounded lock-free ring, so FILE_LOG never
+// waits on the file. The strings are swapped in and out of the ring's slots, which keep their capacity, so once the
+// ring has warmed up a record costs no allocation. A logging thread only waits if the writer has fallen a whole
+// ring behind.
+class AsyncLogQueue : boost::noncopyable
+{
+public:
+    AsyncLogQueue();
+    ~AsyncLogQueue();
+    void Start(void);
+    void Stop(void);
+    bool IsRunning(void) const;
+    void Push(const boost::posix_time::ptime& time, TLogLevel level, std::string& msg);
+private:
+    struct Record
+    {
+        boost::atomic<std::size_t> mSequence;
+        boost::posix_time::ptime mTime;
+        TLogLevel mLevel;
+        std::string mMessage;
+    };
+
+    // must be a power of 2
+    static const std::size_t RING_SIZE = 8192;
+
+    boost::scoped_array<Record> mRecords;
+    boost::atomic<std::size_t> mEnqueuePosition;
+    std::size_t mDequeuePosition;
+    boost::atomic<bool> mRunning;
+    boost::thread mWriterThread;
+
+    std::size_t Drain(void);
+    void WriterLoop(void);
+};
+
 class Output2FILE
 {
 public:
     static FILE*& Stream();
-    static void Output(const std::string& msg, TLogLevel level);
+    static AsyncLogQueue& Queue();
+    static void Output(const boost::posix_time::ptime& time, TLogLevel level, std::string& msg);
 };
 
 inline FILE*& Output2FILE::Stream()
@@ -80,17 +156,152 @@ inline FILE*& Output2FILE::Stream()
     return pStream;
 }
 
-inline void Output2FILE::Output(const std::string& msg, TLogLevel level)
+// A function static rather than a class static so that programs which only include this header, like the job
+// wrapper, don't need Log.cpp. It is destroyed at exit, which writes out anything still queued.
+inline AsyncLogQueue& Output2FILE::Queue()
+{
+    static AsyncLogQueue queue;
+    return queue;
+}
+
+inline void Output2FILE::Output(const boost::posix_time::ptime& time, TLogLevel level, std::string& msg)
 {   
     FILE* pStream = Stream();
     if (!pStream)
         return;
-    fprintf(pStream, "%s", msg.c_str());
-    fflush(pStream);
     if (level == logINFOwithCOUT)
     {
-        std::cout << msg << std::endl;
+        std::cout << FormatTime(time) << " " << LogLevelToString(level) << ": " << msg << std::endl << std::endl;
+    }
+    AsyncLogQueue& queue = Queue();
+    if (queue.IsRunning())
+    {
+        queue.Push(time, level, msg);
+        return;
+    }
+    WriteLogRecord(pStream, time, level, msg);
+    fflush(pStream);
+}
+
+inline AsyncLogQueue::AsyncLogQueue()
+:
+    mEnqueuePosition(0),
+    mDequeuePosition(0),
+    mRunning(false)
+{
+}
+
+inline AsyncLogQueue::~AsyncLogQueue()
+{
+    Stop();
+}
+
+inline void AsyncLogQueue::Start(void)
+{
+    if (mRunning)
+    {
+        return;
+    }
+    // the ring is only allocated if it is used
+    if (!mRecords)
+    {
+        mRecords.reset(new Record[RING_SIZE]);
+        for (std::size_t i = 0; i < RING_SIZE; ++i)
+        {
+            mRecords[i].mSequence.store(i, boost::memory_order_relaxed);
+        }
+    }
+    mRunning = true;
+    mWriterThread = boost::thread(boost::bind(&AsyncLogQueue::WriterLoop, this));
+}
+
+inline void AsyncLogQueue::Stop(void)
+{
+    if (!mRunning)
+    {
+        return;
     }
+    mRunning = false;
+    mWriterThread.join();
+}
+
+inline bool AsyncLogQueue::IsRunning(void) const
+{
+    return mRunning;
+}
+
+// Bounded multi-producer queue as described by Dmitry Vyukov. A slot is free for position p when its sequence is p
+// and full when it is p + 1.
+inline void AsyncLogQueue::Push(const boost::posix_time::ptime& time, TLogLevel level, std::string& msg)
+{
+    Record* record;
+    std::size_t position = mEnqueuePosition.load(boost::memory_order_relaxed);
+    for (;;)
+    {
+        record = &mRecords[position & (RING_SIZE - 1)];
+        std::size_t sequence = record->mSequence.load(boost::memory_order_acquire);
+        std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (difference == 0)
+        {
+            if (mEnqueuePosition.compare_exchange_weak(position, position + 1, boost::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else
+        {
+            if (difference < 0)
+            {
+                // the ring is full
+                boost::this_thread::yield();
+            }
+            position = mEnqueuePosition.load(boost::memory_order_relaxed);
+        }
+    }
+
+    record->mTime = time;
+    record->mLevel = level;
+    record->mMessage.swap(msg);
+    record->mSequence.store(position + 1, boost::memory_order_release);
+}
+
+inline std::size_t AsyncLogQueue::Drain(void)
+{
+    FILE* pStream = Output2FILE::Stream();
+    std::size_t numWritten = 0;
+    for (;;)
+    {
+        Record& record = mRecords[mDequeuePosition & (RING_SIZE - 1)];
+        if (record.mSequence.load(boost::memory_order_acquire) != mDequeuePosition + 1)
+        {
+            break;
+        }
+        if (pStream)
+        {
+            WriteLogRecord(pStream, record.mTime, record.mLevel, record.mMessage);
+        }
+        record.mMessage.clear();
+        record.mSequence.store(mDequeuePosition + RING_SIZE, boost::memory_order_release);
+        ++mDequeuePosition;
+        ++numWritten;
+    }
+    if (numWritten > 0 && pStream)
+    {
+        fflush(pStream);
+    }
+    return numWritten;
+}
+
+inline void AsyncLogQueue::WriterLoop(void)
+{
+    while (mRunning)
+    {
+        if (Drain() == 0)
+        {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(2));
+        }
+    }
+    Drain();
 }
 
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
@@ -112,15 +323,20 @@ class FILELOG_DECLSPEC FILELog : public Log<Output2FILE> {};
 #endif
 
 #define FILE_LOG(level) \
-    if (level > FILELOG_MAX_LEVEL) ;\
-    else if (level > FILELog::ReportingLevel() || !Output2FILE::Stream()) ; \
+    if (LogLevelRank(level) > FILELOG_MAX_LEVEL) ;\
+    else if (LogLevelRank(level) > FILELog::ReportingLevel() || !Output2FILE::Stream()) ; \
     else FILELog().Get(level)
 
 
 
 inline std::string NowTime()
 {
-	return boost::posix_time::to_simple_string(boost::posix_time::microsec_clock::local_time()); // universal_time()); // microsec_clock::universal_time()
+	return FormatTime(boost::posix_time::microsec_clock::local_time()); // universal_time()); // microsec_clock::universal_time()
+}
+
+inline std::string FormatTime(const boost::posix_time::ptime& time)
+{
+	return boost::posix_time::to_simple_string(time);
 }
 
 
@@ -129,6 +345,8 @@ class Logger
 public:
     static void Initialise();
     static void Initialise(std::string logFileName);
+    static void StartAsync();
+    static void SetLevel(const std::string& levelName);
     static void Close();
 private:
     static bool mInitialised;
@@ -173,8 +391,20 @@ inline void Logger::Initialise(std::string logFileName)
 }
 
 
+// From here on records are written by a background thread
+inline void Logger::StartAsync(void)
+{
+    Output2FILE::Queue().Start();
+}
+
+inline void Logger::SetLevel(const std::string& levelName)
+{
+    FILELog::ReportingLevel() = LogLevelFromString(levelName, FILELog::ReportingLevel());
+}
+
 inline void Logger::Close(void)
 {
+    Output2FILE::Queue().Stop();
     FILE* pStream = Output2FILE::Stream();
     fclose(pStream);
     mInitialised = false;
@@ -1,6 +1,8 @@
 #include "stdafx.hpp"
 
+#include "ExperimentRunner.hpp"
 #include "GeneticAlgo.hpp"
+#include "TraceRecorder.hpp"
 #include "VersionConfig.hpp"
 
 namespace po = boost::program_options;
@@ -66,6 +68,9 @@ int main(int argc, char* argv[])
         ("genetic-algo", new ArgTypeString(std::string("<config template>")), 
             "Run a genetic algo using the supplied file as the template. Requires an HTCondor cluster.")
 
+        ("experiments", new ArgTypeString(std::string("<experiments file>")),
+            "Run every experiment listed in the file in one process, sharing one results port and the jobs in flight.")
+
         //   ("tcp-port", new ArgTypeInt(std::string("<Port Number>")),
      //       "Used with --genetic-algo. Specifies the TCP port node comminicate with the GA server on.")
       //  ("test-send", "Send a test message to another DeepThought instance via ZeroMQ to test comms.")
@@ -117,6 +122,12 @@ int main(int argc, char* argv[])
         logFileName = filesLocation + "/genetic-algo.log";
     }
 
+    if (variablesMap.count("experiments"))
+    {
+        std::string experimentsLocation = boost::filesystem::path(variablesMap["experiments"].as<std::string>()).parent_path().string();
+        logFileName = (experimentsLocation.empty() ? std::string(".") : experimentsLocation) + "/experiments.log";
+    }
+
     Logger::Initialise(logFileName);
 
 	if (variablesMap.count("help"))
@@ -129,12 +140,44 @@ int main(int argc, char* argv[])
     if (variablesMap.count("genetic-algo"))
     {
         zmq::context_t zmqContext(1);
-        GridGALib::GeneticAlgo geneticAlgo(variablesMap["genetic-algo"].as<std::string>(), zmqContext);
+        std::string filesLocation(variablesMap["genetic-algo"].as<std::string>());
+        // the log belongs to the process rather than the GA, so its settings are read once here
+        std::string configFileName = CommonLib::GetConfigFileNameIfExists(filesLocation);
+        if (configFileName != "")
+        {
+            boost::property_tree::ptree pt;
+            boost::property_tree::read_xml(configFileName, pt);
+            // error | warning | info | debug | spam. Statements above FILELOG_MAX_LEVEL are compiled out whatever this is.
+            Logger::SetLevel(CommonLib::GetOptionalParameter<std::string>("config.genetic-algo.log-level", pt, "spam"));
+            // write the log from a background thread so the GA never waits on the disk
+            if (CommonLib::GetOptionalBoolParameter("config.genetic-algo.async-log", pt, true))
+            {
+                Logger::StartAsync();
+            }
+        }
+
+        GridGALib::GeneticAlgo geneticAlgo(filesLocation, zmqContext);
         if (!geneticAlgo.ReadConfig())
         {
+            std::cerr << "Cannot start, see " << logFileName << std::endl;
             return 1;
         }        
         geneticAlgo.Evolve();
+        GridGALib::TraceRecorder::Instance().Close();
+        return 0;
+    }
+
+    if (variablesMap.count("experiments"))
+    {
+        zmq::context_t zmqContext(1);
+        GridGALib::ExperimentRunner experimentRunner(variablesMap["experiments"].as<std::string>(), zmqContext);
+        if (!experimentRunner.ReadConfig())
+        {
+            std::cerr << "Cannot start, see " << logFileName << std::endl;
+            return 1;
+        }
+        experimentRunner.Run();
+        GridGALib::TraceRecorder::Instance().Close();
         return 0;
     }
 
@@ -0,0 +1,232 @@
+#include "stdafx.hpp"
+#include "Metrics.hpp"
+
+namespace GridGALib
+{
+    namespace
+    {
+        struct MetricInfo
+        {
+            const char* mName;
+            const char* mHelp;
+        };
+
+        const MetricInfo COUNTERS[Metrics::NUM_COUNTERS] =
+        {
+            { "gridga_results_received_total", "Results received from the job wrappers" },
+            { "gridga_result_errors_total", "Results reporting an error" },
+            { "gridga_unknown_results_total", "Results for genomes that were not waiting for one" },
+            { "gridga_duplicate_genomes_total", "New genomes rejected because they were already in the population" },
+            { "gridga_mutations_total", "Children that were mutated" },
+            { "gridga_jobs_submitted_total", "Jobs submitted to HTCondor" },
+            { "gridga_jobs_resubmitted_total", "Jobs resubmitted after being held, evicted or killed" },
+            { "gridga_jobs_failed_total", "Jobs given up on" }
+        };
+
+        const MetricInfo GAUGES[Metrics::NUM_GAUGES] =
+        {
+            { "gridga_generation", "Current generation" },
+            { "gridga_jobs_in_flight", "Jobs waiting for a result" },
+            { "gridga_best_objective", "Best objective of the genomes evaluated without error" },
+            { "gridga_mean_objective", "Mean objective of the genomes evaluated without error" },
+            { "gridga_first_result_seconds", "Time from the start of the generation to its first result, 0 until it arrives" },
+            { "gridga_search_space_covered", "Fraction of the search space evaluated or in flight" }
+        };
+
+        const MetricInfo HISTOGRAMS[Metrics::NUM_HISTOGRAMS] =
+        {
+            { "gridga_submit_to_result_seconds", "Time from submitting a job to receiving its result" },
+            { "gridga_execute_seconds", "Time the objective function ran for, as reported by the wrapper" },
+            { "gridga_submit_seconds", "Time taken by each condor_submit" },
+            { "gridga_store_state_seconds", "Time taken to write genetic-algo-cache.xml" }
+        };
+
+        const double BUCKET_BOUNDS[] = { 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 30, 60, 120, 300, 600, 1800, 3600, 7200 };
+
+        // the thread doesn't own its metrics, so nothing is deleted when it exits
+        void KeepMetrics(Metrics*)
+        {
+        }
+
+        boost::thread_specific_ptr<Metrics> ThreadMetrics(&KeepMetrics);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    Metrics& Metrics::Instance(void)
+    {
+        Metrics* threadMetrics = ThreadMetrics.get();
+        if (threadMetrics)
+        {
+            return *threadMetrics;
+        }
+        static Metrics metrics;
+        return metrics;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    Metrics::Metrics(void)
+    :
+        mInterval(boost::posix_time::seconds(10))
+    {
+        std::fill(mCounters, mCounters + NUM_COUNTERS, 0);
+        std::fill(mGauges, mGauges + NUM_GAUGES, 0.0);
+        for (std::size_t i = 0; i < NUM_HISTOGRAMS; ++i)
+        {
+            mHistograms[i].mBounds.assign(BUCKET_BOUNDS, BUCKET_BOUNDS + (sizeof(BUCKET_BOUNDS) / sizeof(BUCKET_BOUNDS[0])));
+            mHistograms[i].mCounts.assign(mHistograms[i].mBounds.size(), 0);
+            mHistograms[i].mCount = 0;
+            mHistograms[i].mSum = 0.0;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void Metrics::SetFileName(const std::string& fileName, std::size_t intervalSeconds)
+    {
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        mFileName = fileName;
+        mInterval = boost::posix_time::seconds(static_cast<long>(intervalSeconds));
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void Metrics::Increment(Counter counter, boost::uint64_t count)
+    {
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        mCounters[counter] += count;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void Metrics::Set(Gauge gauge, double value)
+    {
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        mGauges[gauge] = value;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void Metrics::Observe(Histogram histogram, double value)
+    {
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        HistogramData& data = mHistograms[histogram];
+        std::size_t bucket = std::lower_bound(data.mBounds.begin(), data.mBounds.end(), value) - data.mBounds.begin();
+        if (bucket < data.mCounts.size())
+        {
+            ++data.mCounts[bucket];
+        }
+        ++data.mCount;
+        data.mSum += value;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void Metrics::Write(bool force)
+    {
+        std::ostringstream s;
+        std::string fileName;
+        {
+            boost::lock_guard<boost::mutex> lock(mMutex);
+            boost::posix_time::ptime now(boost::posix_time::microsec_clock::universal_time());
+            if (mFileName.empty() || (!force && !mLastWrite.is_not_a_date_time() && now - mLastWrite < mInterval))
+            {
+                return;
+            }
+            mLastWrite = now;
+            fileName = mFileName;
+
+            s.precision(10);
+            for (std::size_t i = 0; i < NUM_COUNTERS; ++i)
+            {
+                s << "# HELP " << COUNTERS[i].mName << " " << COUNTERS[i].mHelp << "\n" <<
+                    "# TYPE " << COUNTERS[i].mName << " counter\n" <<
+                    COUNTERS[i].mName << " " << mCounters[i] << "\n";
+            }
+            for (std::size_t i = 0; i < NUM_GAUGES; ++i)
+            {
+                s << "# HELP " << GAUGES[i].mName << " " << GAUGES[i].mHelp << "\n" <<
+                    "# TYPE " << GAUGES[i].mName << " gauge\n" <<
+                    GAUGES[i].mName << " " << mGauges[i] << "\n";
+            }
+            for (std::size_t i = 0; i < NUM_HISTOGRAMS; ++i)
+            {
+                const HistogramData& data = mHistograms[i];
+                s << "# HELP " << HISTOGRAMS[i].mName << " " << HISTOGRAMS[i].mHelp << "\n" <<
+                    "# TYPE " << HISTOGRAMS[i].mName << " histogram\n";
+                boost::uint64_t cumulative = 0;
+                for (std::size_t bucket = 0; bucket < data.mBounds.size(); ++bucket)
+                {
+                    cumulative += data.mCounts[bucket];
+                    s << HISTOGRAMS[i].mName << "_bucket{le=\"" << data.mBounds[bucket] << "\"} " << cumulative << "\n";
+                }
+                s << HISTOGRAMS[i].mName << "_bucket{le=\"+Inf\"} " << data.mCount << "\n" <<
+                    HISTOGRAMS[i].mName << "_sum " << data.mSum << "\n" <<
+                    HISTOGRAMS[i].mName << "_count " << data.mCount << "\n";
+            }
+        }
+
+        std::string tempFileName(fileName + ".tmp");
+        {
+            std::ofstream outFile(tempFileName.c_str(), std::ios::binary);
+            outFile << s.str();
+            if (!outFile)
+            {
+                FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "- Cannot write " << tempFileName;
+                return;
+            }
+        }
+
+        boost::system::error_code ec;
+        boost::filesystem::rename(tempFileName, fileName, ec);
+        if (ec)
+        {
+            // Windows won't rename over an existing file
+            boost::filesystem::remove(fileName, ec);
+            boost::filesystem::rename(tempFileName, fileName, ec);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ScopedMetricsInstance::ScopedMetricsInstance(Metrics* metrics)
+    :
+        mPrevious(ThreadMetrics.get()),
+        mSet(metrics != NULL)
+    {
+        if (mSet)
+        {
+            ThreadMetrics.reset(metrics);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ScopedMetricsInstance::~ScopedMetricsInstance(void)
+    {
+        if (mSet)
+        {
+            ThreadMetrics.reset(mPrevious);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ScopedMetricsTimer::ScopedMetricsTimer(Metrics::Histogram histogram)
+    :
+        mHistogram(histogram),
+        mStart(boost::posix_time::microsec_clock::universal_time())
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ScopedMetricsTimer::~ScopedMetricsTimer(void)
+    {
+        boost::posix_time::time_duration elapsed(boost::posix_time::microsec_clock::universal_time() - mStart);
+        Metrics::Instance().Observe(mHistogram, elapsed.total_microseconds() / 1000000.0);
+    }
+
+    //______________________________________________________________________________________________________________
+}
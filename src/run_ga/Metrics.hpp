@@ -0,0 +1,98 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+namespace GridGALib
+{
+    // Counters, gauges and histograms describing where each generation's time goes. They are written in the
+    // Prometheus text format to the file set by config.genetic-algo.metrics-file, which can be read by the node
+    // exporter's textfile collector or just looked at. The file is replaced, never rewritten in place, so a reader
+    // never sees half of it. There's one for the process, but run_ga --experiments gives every experiment its own,
+    // see ScopedMetricsInstance.
+	class Metrics : boost::noncopyable
+    {
+    public:
+        enum Counter
+        {
+            RESULTS_RECEIVED,
+            RESULT_ERRORS,
+            UNKNOWN_RESULTS,
+            DUPLICATE_GENOMES,
+            MUTATIONS,
+            JOBS_SUBMITTED,
+            JOBS_RESUBMITTED,
+            JOBS_FAILED,
+            NUM_COUNTERS
+        };
+
+        enum Gauge
+        {
+            GENERATION,
+            JOBS_IN_FLIGHT,
+            BEST_OBJECTIVE,
+            MEAN_OBJECTIVE,
+            FIRST_RESULT_SECONDS,
+            SEARCH_SPACE_COVERED,
+            NUM_GAUGES
+        };
+
+        enum Histogram
+        {
+            SUBMIT_TO_RESULT_SECONDS,
+            EXECUTE_SECONDS,
+            SUBMIT_SECONDS,
+            STORE_STATE_SECONDS,
+            NUM_HISTOGRAMS
+        };
+
+        Metrics(void);
+        // the process's, or the one set on this thread by ScopedMetricsInstance
+        static Metrics& Instance(void);
+
+        void SetFileName(const std::string& fileName, std::size_t intervalSeconds);
+        void Increment(Counter counter, boost::uint64_t count = 1);
+        void Set(Gauge gauge, double value);
+        void Observe(Histogram histogram, double value);
+        // writes the file if the interval has passed since it was last written, or if force is set
+        void Write(bool force);
+    private:
+        struct HistogramData
+        {
+            std::vector<double> mBounds;
+            std::vector<boost::uint64_t> mCounts;
+            boost::uint64_t mCount;
+            double mSum;
+        };
+
+        boost::mutex mMutex;
+        std::string mFileName;
+        boost::posix_time::time_duration mInterval;
+        boost::posix_time::ptime mLastWrite;
+        boost::uint64_t mCounters[NUM_COUNTERS];
+        double mGauges[NUM_GAUGES];
+        HistogramData mHistograms[NUM_HISTOGRAMS];
+    };
+
+    // Makes Metrics::Instance() return the given metrics on this thread for as long as it is in scope. A null
+    // pointer leaves it as it was.
+    class ScopedMetricsInstance : boost::noncopyable
+    {
+    public:
+        explicit ScopedMetricsInstance(Metrics* metrics);
+        ~ScopedMetricsInstance(void);
+    private:
+        Metrics* mPrevious;
+        bool mSet;
+    };
+
+    // Observes how long it is in scope
+    class ScopedMetricsTimer : boost::noncopyable
+    {
+    public:
+        ScopedMetricsTimer(Metrics::Histogram histogram);
+        ~ScopedMetricsTimer(void);
+    private:
+        Metrics::Histogram mHistogram;
+        boost::posix_time::ptime mStart;
+    };
+}
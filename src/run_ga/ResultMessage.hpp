@@ -0,0 +1,233 @@
+#pragma once
+
+// Shared between run_ga and htcondor_job_wrapper. Only header-only code should be added to this file as the wrapper
+// is built from its own Main.cpp.
+
+#include <boost/cstdint.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace GridGALib
+{
+    // Binary result message sent from htcondor_job_wrapper to run_ga. The layout is fixed and all integers are
+    // little endian, so the message can be written and parsed directly into/from a buffer without any allocation.
+    //
+    //  offset  size  field
+    //  0       4     magic "GGAR"
+    //  4       2     protocol version
+    //  6       2     message type
+    //  8       4     total length of the message in bytes, including the header
+    //  12      8     genome id
+    //  20      1     status
+    //  21      1     number of objectives (n)
+    //  22      2     host name length (h)
+    //  24      2     error text length (e)
+    //  26      2     experiment id, 0 unless run_ga is running several experiments (reserved in older wrappers)
+    //  28      8     start time of the evaluation (milliseconds since the unix epoch)
+    //  36      4     time spent executing the objective (milliseconds)
+    //  40      4     time spent extracting the objective value (milliseconds)
+    //  44      8*n   objective values (IEEE 754 doubles)
+    //  ..      h     host name (not null terminated)
+    //  ..      e     error text (not null terminated)
+    //
+    // Anything that doesn't start with the magic bytes is treated as the original XML message, e.g.
+    //   <results><id>1001</id><objective>49.9</objective></results>
+    // which is still sent by older wrappers.
+
+    const char RESULT_MESSAGE_MAGIC[4] = { 'G', 'G', 'A', 'R' };
+    const boost::uint16_t RESULT_MESSAGE_VERSION = 1;
+    const std::size_t RESULT_MESSAGE_HEADER_SIZE = 44;
+    const std::size_t RESULT_MESSAGE_MAX_OBJECTIVES = 8;
+    const std::size_t RESULT_MESSAGE_MAX_HOST_LENGTH = 64;
+    const std::size_t RESULT_MESSAGE_MAX_ERROR_LENGTH = 256;
+    const std::size_t RESULT_MESSAGE_MAX_SIZE = RESULT_MESSAGE_HEADER_SIZE +
+        (8 * RESULT_MESSAGE_MAX_OBJECTIVES) + RESULT_MESSAGE_MAX_HOST_LENGTH + RESULT_MESSAGE_MAX_ERROR_LENGTH;
+
+    enum ResultMessageType
+    {
+        RESULT_MESSAGE_TYPE_RESULT = 1
+    };
+
+    enum ResultStatus
+    {
+        RESULT_STATUS_OK = 0,
+        RESULT_STATUS_ERROR = 1
+    };
+
+    // Plain data only, so results can be copied around (and queued) without touching the heap.
+    struct ResultMessage
+    {
+        boost::uint16_t mVersion;
+        boost::uint16_t mType;
+        boost::uint64_t mGenomeID;
+        boost::uint16_t mExperimentID;
+        boost::uint8_t mStatus;
+        boost::uint8_t mNumObjectives;
+        double mObjectives[RESULT_MESSAGE_MAX_OBJECTIVES];
+        boost::uint64_t mStartTimeMs;
+        boost::uint32_t mExecuteMs;
+        boost::uint32_t mExtractMs;
+        char mHost[RESULT_MESSAGE_MAX_HOST_LENGTH + 1];
+        char mError[RESULT_MESSAGE_MAX_ERROR_LENGTH + 1];
+
+        void Clear(void)
+        {
+            std::memset(this, 0, sizeof(ResultMessage));
+            mVersion = RESULT_MESSAGE_VERSION;
+            mType = RESULT_MESSAGE_TYPE_RESULT;
+        }
+
+        void SetHost(const char* host, std::size_t length)
+        {
+            length = std::min(length, RESULT_MESSAGE_MAX_HOST_LENGTH);
+            std::memcpy(mHost, host, length);
+            mHost[length] = 0;
+        }
+
+        void SetError(const char* error, std::size_t length)
+        {
+            length = std::min(length, RESULT_MESSAGE_MAX_ERROR_LENGTH);
+            std::memcpy(mError, error, length);
+            mError[length] = 0;
+        }
+    };
+
+    namespace ResultMessageDetail
+    {
+        template <typename T>
+        inline void Write(char* p, T value)
+        {
+            for (std::size_t i = 0; i < sizeof(T); ++i)
+            {
+                p[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+            }
+        }
+
+        template <typename T>
+        inline T Read(const char* p)
+        {
+            T value = 0;
+            for (std::size_t i = 0; i < sizeof(T); ++i)
+            {
+                value |= static_cast<T>(static_cast<unsigned char>(p[i])) << (8 * i);
+            }
+            return value;
+        }
+
+        inline void WriteDouble(char* p, double value)
+        {
+            boost::uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            Write<boost::uint64_t>(p, bits);
+        }
+
+        inline double ReadDouble(const char* p)
+        {
+            boost::uint64_t bits = Read<boost::uint64_t>(p);
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    inline bool IsBinaryResultMessage(const void* data, std::size_t size)
+    {
+        return (size >= RESULT_MESSAGE_HEADER_SIZE) && (std::memcmp(data, RESULT_MESSAGE_MAGIC, 4) == 0);
+    }
+
+    //______________________________________________________________________________________________________________
+    // Returns the number of bytes written to buffer, or 0 if the buffer is too small.
+    inline std::size_t SerialiseResultMessage(const ResultMessage& msg, char* buffer, std::size_t bufferSize)
+    {
+        using namespace ResultMessageDetail;
+
+        std::size_t numObjectives = std::min(static_cast<std::size_t>(msg.mNumObjectives), RESULT_MESSAGE_MAX_OBJECTIVES);
+        std::size_t hostLength = strnlen(msg.mHost, RESULT_MESSAGE_MAX_HOST_LENGTH);
+        std::size_t errorLength = strnlen(msg.mError, RESULT_MESSAGE_MAX_ERROR_LENGTH);
+        std::size_t length = RESULT_MESSAGE_HEADER_SIZE + (8 * numObjectives) + hostLength + errorLength;
+        if (length > bufferSize)
+        {
+            return 0;
+        }
+
+        std::memcpy(buffer, RESULT_MESSAGE_MAGIC, 4);
+        Write<boost::uint16_t>(buffer + 4, RESULT_MESSAGE_VERSION);
+        Write<boost::uint16_t>(buffer + 6, msg.mType);
+        Write<boost::uint32_t>(buffer + 8, static_cast<boost::uint32_t>(length));
+        Write<boost::uint64_t>(buffer + 12, msg.mGenomeID);
+        Write<boost::uint8_t>(buffer + 20, msg.mStatus);
+        Write<boost::uint8_t>(buffer + 21, static_cast<boost::uint8_t>(numObjectives));
+        Write<boost::uint16_t>(buffer + 22, static_cast<boost::uint16_t>(hostLength));
+        Write<boost::uint16_t>(buffer + 24, static_cast<boost::uint16_t>(errorLength));
+        Write<boost::uint16_t>(buffer + 26, msg.mExperimentID);
+        Write<boost::uint64_t>(buffer + 28, msg.mStartTimeMs);
+        Write<boost::uint32_t>(buffer + 36, msg.mExecuteMs);
+        Write<boost::uint32_t>(buffer + 40, msg.mExtractMs);
+
+        char* p = buffer + RESULT_MESSAGE_HEADER_SIZE;
+        for (std::size_t i = 0; i < numObjectives; ++i)
+        {
+            WriteDouble(p, msg.mObjectives[i]);
+            p += 8;
+        }
+        std::memcpy(p, msg.mHost, hostLength);
+        p += hostLength;
+        std::memcpy(p, msg.mError, errorLength);
+        return length;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Parses a binary message in place. Returns false if the message is truncated, corrupt or from a newer protocol
+    // version that we don't understand.
+    inline bool ParseResultMessage(const void* data, std::size_t size, ResultMessage& msg)
+    {
+        using namespace ResultMessageDetail;
+
+        if (!IsBinaryResultMessage(data, size))
+        {
+            return false;
+        }
+
+        const char* buffer = static_cast<const char*>(data);
+        msg.mVersion = Read<boost::uint16_t>(buffer + 4);
+        if (msg.mVersion == 0 || msg.mVersion > RESULT_MESSAGE_VERSION)
+        {
+            return false;
+        }
+
+        std::size_t length = Read<boost::uint32_t>(buffer + 8);
+        std::size_t numObjectives = Read<boost::uint8_t>(buffer + 21);
+        std::size_t hostLength = Read<boost::uint16_t>(buffer + 22);
+        std::size_t errorLength = Read<boost::uint16_t>(buffer + 24);
+        if (length != size ||
+            numObjectives > RESULT_MESSAGE_MAX_OBJECTIVES ||
+            length != RESULT_MESSAGE_HEADER_SIZE + (8 * numObjectives) + hostLength + errorLength)
+        {
+            return false;
+        }
+
+        msg.mType = Read<boost::uint16_t>(buffer + 6);
+        msg.mGenomeID = Read<boost::uint64_t>(buffer + 12);
+        msg.mExperimentID = Read<boost::uint16_t>(buffer + 26);
+        msg.mStatus = Read<boost::uint8_t>(buffer + 20);
+        msg.mNumObjectives = static_cast<boost::uint8_t>(numObjectives);
+        msg.mStartTimeMs = Read<boost::uint64_t>(buffer + 28);
+        msg.mExecuteMs = Read<boost::uint32_t>(buffer + 36);
+        msg.mExtractMs = Read<boost::uint32_t>(buffer + 40);
+
+        const char* p = buffer + RESULT_MESSAGE_HEADER_SIZE;
+        for (std::size_t i = 0; i < numObjectives; ++i)
+        {
+            msg.mObjectives[i] = ReadDouble(p);
+            p += 8;
+        }
+        msg.SetHost(p, hostLength);
+        p += hostLength;
+        msg.SetError(p, errorLength);
+        return true;
+    }
+}
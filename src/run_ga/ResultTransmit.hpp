@@ -0,0 +1,115 @@
+#pragma once
+
+// Shared between htcondor_job_wrapper and gridga_loadgen, so the load generator sends exactly what the wrapper
+// sends. Only header-only code should be added to this file. zmq.hpp has to be included first, by stdafx.hpp.
+
+#include "ResultMessage.hpp"
+
+#include <boost/lexical_cast.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace GridGALib
+{
+    const std::size_t RESULT_TRANSMIT_MAX_ATTEMPTS = 10;
+    const long RESULT_TRANSMIT_TIMEOUT_MILLISECONDS = 10000;
+
+    struct TransmitOutcome
+    {
+        bool mSentOk;
+        std::size_t mNumAttempts;
+    };
+
+    // The original XML message, still used by masters built before the binary protocol existed
+    inline std::string FormatResultXML(const ResultMessage& result)
+    {
+        std::ostringstream sendXML;
+        sendXML <<
+            "<results>" << std::endl <<
+            "    <id>" << result.mGenomeID << "</id>" << std::endl <<
+            "    <objective>" << boost::lexical_cast<std::string>(result.mObjectives[0]) << "</objective>" << std::endl <<
+            "    <compute-host>" << result.mHost << "</compute-host>" << std::endl;
+        if (result.mExperimentID != 0)
+        {
+            sendXML <<
+                "    <experiment>" << result.mExperimentID << "</experiment>" << std::endl;
+        }
+        if (result.mStatus != RESULT_STATUS_OK)
+        {
+            sendXML <<
+                "    <error>" << result.mError << "</error>" << std::endl;
+        }
+        sendXML <<
+            "</results>";
+        return sendXML.str();
+    }
+
+    // Sends a message to run_ga on a new REQ socket and waits up to timeoutMilliseconds for "_ok_". A timed out
+    // attempt is abandoned and the message is sent again on a fresh socket, up to maxAttempts times in all.
+    inline TransmitOutcome TransmitToGAServer(zmq::context_t& zmqContext, const std::string& message, const std::string& serverName,
+        std::size_t maxAttempts, long timeoutMilliseconds, bool verbose)
+    {
+        TransmitOutcome outcome;
+        outcome.mSentOk = false;
+        outcome.mNumAttempts = 0;
+
+        while (!outcome.mSentOk && outcome.mNumAttempts < maxAttempts)
+        {
+            ++outcome.mNumAttempts;
+            if (verbose)
+            {
+                std::cout << "Sending Attempt " << outcome.mNumAttempts << " to " << serverName << std::endl;
+            }
+            try
+            {
+                zmq::socket_t sendSocket(zmqContext, ZMQ_REQ);
+                // this is required due to a bug in zeromq which causes the app to hang when the context is terminated
+                int linger = 0;
+                sendSocket.setsockopt (ZMQ_LINGER, &linger, sizeof (linger));
+
+                sendSocket.connect(serverName.c_str());
+                zmq::message_t sendMessage(message.length());
+                memcpy ((void *) sendMessage.data(), message.c_str(), message.length());
+
+                sendSocket.send(sendMessage);
+
+                // wait for a response
+                zmq::pollitem_t items[] =
+                {
+                    {sendSocket, 0, ZMQ_POLLIN, 0}
+                };
+
+                zmq::poll(items, 1, timeoutMilliseconds);
+
+                if (items[0].revents & ZMQ_POLLIN)
+                {
+                    zmq::message_t reply;
+                    sendSocket.recv(&reply);
+                    std::string receivedString(static_cast<const char*>(reply.data()), reply.size());
+                    if (verbose)
+                    {
+                        std::cout << "Received response " << receivedString;
+                    }
+                    if (receivedString.compare("_ok_") == 0)
+                    {
+                        outcome.mSentOk = true;
+                    }
+                }
+                else if (verbose)
+                {
+                    std::cerr << "Could not transmit results to GA server. Attempt " << outcome.mNumAttempts << std::endl;
+                }
+            }
+            catch (std::exception& e)
+            {
+                if (verbose)
+                {
+                    std::cerr << "Exception while sending : " << e.what() << std::endl;
+                }
+            }
+        }
+        return outcome;
+    }
+}
@@ -0,0 +1,525 @@
+#include "stdafx.hpp"
+#include "ResultsReceiver.hpp"
+
+namespace GridGALib
+{
+    ResultsReceiver::ResultsReceiver(zmq::context_t& zmqContext, boost::int32_t port, std::size_t numWorkers)
+    :
+        mZmqContext(zmqContext),
+        mPort(port),
+        mNumWorkers(std::max(numWorkers, static_cast<std::size_t>(1))),
+        mRunning(false),
+        mResults(1, boost::make_shared<ResultQueue>(1024)),
+        mNumExperiments(0)
+    {
+        std::ostringstream s;
+        s << "inproc://gridga-results-" << mPort;
+        mWorkEndpoint = s.str();
+        mReplyEndpoint = "inproc://gridga-replies-" + CommonLib::SomethingToString(mPort);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ResultsReceiver::~ResultsReceiver(void)
+    {
+        Stop();
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool ResultsReceiver::Start(void)
+    {
+        if (mRunning)
+        {
+            return true;
+        }
+
+        // the sockets are bound here rather than in the receive thread so that a port clash is reported to the caller
+        try
+        {
+            // this is required due to a bug in zeromq which causes the app to hang when the context is terminated
+            int linger = 0;
+            // allow a whole generation to finish at once without the wrappers being blocked
+            int highWaterMark = 100000;
+
+            mRouterSocket.reset(new zmq::socket_t(mZmqContext, ZMQ_ROUTER));
+            mRouterSocket->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+            mRouterSocket->setsockopt(ZMQ_RCVHWM, &highWaterMark, sizeof(highWaterMark));
+            mRouterSocket->setsockopt(ZMQ_SNDHWM, &highWaterMark, sizeof(highWaterMark));
+
+            std::ostringstream s;
+            s << "tcp://*:" << mPort;
+            mRouterSocket->bind(s.str().c_str());
+
+            mWorkSocket.reset(new zmq::socket_t(mZmqContext, ZMQ_PUSH));
+            mWorkSocket->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+            mWorkSocket->setsockopt(ZMQ_SNDHWM, &highWaterMark, sizeof(highWaterMark));
+            mWorkSocket->bind(mWorkEndpoint.c_str());
+
+            mReplySocket.reset(new zmq::socket_t(mZmqContext, ZMQ_PULL));
+            mReplySocket->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+            mReplySocket->setsockopt(ZMQ_RCVHWM, &highWaterMark, sizeof(highWaterMark));
+            mReplySocket->bind(mReplyEndpoint.c_str());
+        }
+        catch (std::exception& e)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- Cannot bind the results socket on port " << mPort << " : " << e.what();
+            mReplySocket.reset();
+            mWorkSocket.reset();
+            mRouterSocket.reset();
+            return false;
+        }
+
+        mRunning = true;
+        for (std::size_t i = 0; i < mNumWorkers; ++i)
+        {
+            mThreads.create_thread(boost::bind(&ResultsReceiver::WorkerLoop, this));
+        }
+        mThreads.create_thread(boost::bind(&ResultsReceiver::ReceiveLoop, this));
+
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Listening for results on port " << mPort << " with " << mNumWorkers << " worker threads.";
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ResultsReceiver::Stop(void)
+    {
+        if (!mRunning)
+        {
+            return;
+        }
+
+        mRunning = false;
+        mThreads.join_all();
+        mReplySocket.reset();
+        mWorkSocket.reset();
+        mRouterSocket.reset();
+    }
+
+    //______________________________________________________________________________________________________________
+
+    // Experiment 0's queue is made by the constructor, so a run with a single experiment needn't add one
+    std::size_t ResultsReceiver::AddExperiment(void)
+    {
+        std::size_t experimentID = mNumExperiments++;
+        if (experimentID >= mResults.size())
+        {
+            mResults.push_back(boost::make_shared<ResultQueue>(1024));
+        }
+        return experimentID;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool ResultsReceiver::Pop(ResultMessage& result, std::size_t experimentID)
+    {
+        return mResults[experimentID]->pop(result);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ResultsReceiver::WaitForResults(long timeoutMilliseconds, std::size_t experimentID)
+    {
+        boost::unique_lock<boost::mutex> lock(mWaitMutex);
+        if (!mResults[experimentID]->empty() || timeoutMilliseconds <= 0)
+        {
+            return;
+        }
+        mResultsAvailable.timed_wait(lock, boost::posix_time::milliseconds(timeoutMilliseconds));
+    }
+
+    //______________________________________________________________________________________________________________
+    // Must be called before Start(), the workers read the files without taking a lock
+    void ResultsReceiver::AddStagedFile(const StagedFile& stagedFile)
+    {
+        mStagedFiles[stagedFile.mHash] = stagedFile;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Owns the ROUTER socket. A REQ client sends [identity][empty][payload] and we reply straight away, so a wrapper
+    // never waits on the parsing or on the GA. A staging request is passed to the workers as [identity][payload], and
+    // the file data they reply with comes back on the reply socket to be sent on.
+    void ResultsReceiver::ReceiveLoop(void)
+    {
+        zmq::pollitem_t items [] =
+        {
+            { *mRouterSocket, 0, ZMQ_POLLIN, 0 },
+            { *mReplySocket, 0, ZMQ_POLLIN, 0 }
+        };
+
+        while (mRunning)
+        {
+            try
+            {
+                zmq::poll(items, 2, 100);
+
+                // the replies are already built, so sending them only hands the messages to zmq
+                while (mRunning && (items[1].revents & ZMQ_POLLIN))
+                {
+                    zmq::message_t identity;
+                    if (!mReplySocket->recv(&identity, ZMQ_DONTWAIT))
+                    {
+                        break;
+                    }
+                    zmq::message_t reply;
+                    mReplySocket->recv(&reply);
+                    zmq::message_t emptyFrame(0);
+                    mRouterSocket->send(identity, ZMQ_SNDMORE);
+                    mRouterSocket->send(emptyFrame, ZMQ_SNDMORE);
+                    mRouterSocket->send(reply);
+                }
+
+                if (!(items[0].revents & ZMQ_POLLIN))
+                {
+                    continue;
+                }
+
+                while (mRunning)
+                {
+                    zmq::message_t identity;
+                    if (!mRouterSocket->recv(&identity, ZMQ_DONTWAIT))
+                    {
+                        break;
+                    }
+
+                    zmq::message_t delimiter;
+                    zmq::message_t payload;
+                    if (identity.more())
+                    {
+                        mRouterSocket->recv(&delimiter);
+                    }
+                    if (delimiter.more())
+                    {
+                        mRouterSocket->recv(&payload);
+                    }
+                    while (payload.more())
+                    {
+                        zmq::message_t unexpected;
+                        mRouterSocket->recv(&unexpected);
+                    }
+
+                    if (IsStagingRequest(payload.data(), payload.size()))
+                    {
+                        mWorkSocket->send(identity, ZMQ_SNDMORE);
+                        mWorkSocket->send(payload);
+                        continue;
+                    }
+
+                    zmq::message_t emptyFrame(0);
+                    zmq::message_t reply(4);
+                    memcpy(reply.data(), "_ok_", 4);
+                    mRouterSocket->send(identity, ZMQ_SNDMORE);
+                    mRouterSocket->send(emptyFrame, ZMQ_SNDMORE);
+                    mRouterSocket->send(reply);
+
+                    if (payload.size() > 0)
+                    {
+                        mWorkSocket->send(payload);
+                    }
+                }
+            }
+            catch (zmq::error_t& e)
+            {
+                if (e.num() == ETERM)
+                {
+                    break;
+                }
+                FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- " << e.what();
+            }
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // Called by the workers. The data is copied straight from the in-memory file into the reply, at most one chunk
+    // at a time so a large file doesn't hold up other wrappers' requests.
+    void ResultsReceiver::BuildStagingReply(const zmq::message_t& payload, zmq::message_t& reply) const
+    {
+        StagingRequest request;
+        boost::unordered_map<std::string, StagedFile>::const_iterator itr = mStagedFiles.end();
+        if (ParseStagingRequest(payload.data(), payload.size(), request))
+        {
+            itr = mStagedFiles.find(request.mHash);
+        }
+
+        std::size_t length = 0;
+        if (itr != mStagedFiles.end() && request.mOffset < itr->second.mSize)
+        {
+            length = static_cast<std::size_t>(std::min<boost::uint64_t>(itr->second.mSize - request.mOffset,
+                std::min(request.mLength, STAGING_CHUNK_SIZE)));
+        }
+
+        reply.rebuild(STAGING_REPLY_HEADER_SIZE + length);
+        char* data = static_cast<char*>(reply.data());
+        if (itr == mStagedFiles.end())
+        {
+            FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "- Request for an unknown staged file.";
+            SerialiseStagingReplyHeader(STAGING_STATUS_NOT_FOUND, 0, data);
+        }
+        else
+        {
+            SerialiseStagingReplyHeader(STAGING_STATUS_OK, itr->second.mSize, data);
+            if (length > 0)
+            {
+                memcpy(data + STAGING_REPLY_HEADER_SIZE, itr->second.mData.get() + request.mOffset, length);
+            }
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void ResultsReceiver::WorkerLoop(void)
+    {
+        zmq::socket_t workSocket(mZmqContext, ZMQ_PULL);
+        int linger = 0;
+        workSocket.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+        workSocket.connect(mWorkEndpoint.c_str());
+
+        zmq::socket_t replySocket(mZmqContext, ZMQ_PUSH);
+        replySocket.setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+        replySocket.connect(mReplyEndpoint.c_str());
+
+        zmq::pollitem_t items [] =
+        {
+            { workSocket, 0, ZMQ_POLLIN, 0 }
+        };
+
+        while (mRunning)
+        {
+            try
+            {
+                zmq::poll(items, 1, 100);
+                if (!(items[0].revents & ZMQ_POLLIN))
+                {
+                    continue;
+                }
+
+                while (mRunning)
+                {
+                    ResultMessage result;
+                    {
+                        // the message is released as soon as it has been parsed
+                        zmq::message_t message;
+                        if (!workSocket.recv(&message, ZMQ_DONTWAIT))
+                        {
+                            break;
+                        }
+
+                        // a staging request comes with the wrapper's identity in front
+                        if (message.more())
+                        {
+                            zmq::message_t payload;
+                            workSocket.recv(&payload);
+                            zmq::message_t reply;
+                            BuildStagingReply(payload, reply);
+                            replySocket.send(message, ZMQ_SNDMORE);
+                            replySocket.send(reply);
+                            continue;
+                        }
+
+                        if (!ParseResult(message, result))
+                        {
+                            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- Discarding invalid result message of " << message.size() << " bytes.";
+                            continue;
+                        }
+                    }
+
+                    if (result.mExperimentID >= mResults.size())
+                    {
+                        FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- Discarding the result of genome " << result.mGenomeID << " for unknown experiment " << result.mExperimentID;
+                        continue;
+                    }
+
+                    while (!mResults[result.mExperimentID]->push(result))
+                    {
+                        boost::this_thread::yield();
+                    }
+
+                    // take the lock so the notification can't slip in between the GA thread checking the queue and
+                    // starting to wait. Every waiting experiment is woken as they share the condition.
+                    {
+                        boost::lock_guard<boost::mutex> lock(mWaitMutex);
+                    }
+                    mResultsAvailable.notify_all();
+                }
+            }
+            catch (zmq::error_t& e)
+            {
+                if (e.num() == ETERM)
+                {
+                    break;
+                }
+                FILE_LOG(logERROR) << __FUNCTION_NAME__ << "- " << e.what();
+            }
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool ResultsReceiver::ParseResult(const zmq::message_t& message, ResultMessage& result)
+    {
+        const char* data = static_cast<const char*>(message.data());
+        if (IsBinaryResultMessage(data, message.size()))
+        {
+            return ParseResultMessage(data, message.size(), result);
+        }
+
+        // fall back to the XML message sent by older wrappers
+        return ParseResultXML(data, message.size(), result);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    namespace
+    {
+        bool ElementNameIs(const char* name, std::size_t length, const char* expected)
+        {
+            return (length == strlen(expected)) && (strncmp(name, expected, length) == 0);
+        }
+
+        // Copies the element text into a fixed buffer, trimming whitespace and replacing the predefined XML entities.
+        // The copy is always null terminated and is truncated to fit.
+        std::size_t CopyElementText(const char* begin, const char* end, char* buffer, std::size_t bufferSize)
+        {
+            while (begin < end && isspace(static_cast<unsigned char>(*begin)))
+            {
+                ++begin;
+            }
+            while (end > begin && isspace(static_cast<unsigned char>(end[-1])))
+            {
+                --end;
+            }
+
+            static const char* const entities[] = { "&lt;", "&gt;", "&amp;", "&apos;", "&quot;" };
+            static const char replacements[] = { '<', '>', '&', '\'', '"' };
+
+            std::size_t length = 0;
+            while (begin < end && length + 1 < bufferSize)
+            {
+                char c = *begin++;
+                if (c == '&')
+                {
+                    for (std::size_t i = 0; i < sizeof(replacements); ++i)
+                    {
+                        std::size_t entityLength = strlen(entities[i]) - 1;
+                        if (static_cast<std::size_t>(end - begin) >= entityLength && strncmp(begin, entities[i] + 1, entityLength) == 0)
+                        {
+                            c = replacements[i];
+                            begin += entityLength;
+                            break;
+                        }
+                    }
+                }
+                buffer[length++] = c;
+            }
+            buffer[length] = 0;
+            return length;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // Streaming parser for the fixed schema sent by the wrapper:
+    //   <results><id>..</id><objective>..</objective><compute-host>..</compute-host><experiment>..</experiment>
+    //   <error>..</error></results>
+    // The fields are read straight out of the message buffer, so nothing is allocated and the message can be released
+    // as soon as this returns. Unknown elements are skipped.
+    bool ResultsReceiver::ParseResultXML(const char* data, std::size_t size, ResultMessage& result)
+    {
+        result.Clear();
+
+        const char* p = data;
+        const char* end = data + size;
+        bool inResults = false;
+        bool haveID = false;
+
+        while (p < end)
+        {
+            const char* tagStart = static_cast<const char*>(memchr(p, '<', end - p));
+            if (!tagStart)
+            {
+                break;
+            }
+            const char* tagEnd = static_cast<const char*>(memchr(tagStart, '>', end - tagStart));
+            if (!tagEnd)
+            {
+                return false;
+            }
+            p = tagEnd + 1;
+
+            // skip the declaration, comments, closing tags and empty elements
+            const char* name = tagStart + 1;
+            if (name == tagEnd || *name == '?' || *name == '!' || *name == '/' || tagEnd[-1] == '/')
+            {
+                continue;
+            }
+
+            const char* nameEnd = name;
+            while (nameEnd < tagEnd && !isspace(static_cast<unsigned char>(*nameEnd)))
+            {
+                ++nameEnd;
+            }
+            std::size_t nameLength = nameEnd - name;
+
+            if (ElementNameIs(name, nameLength, "results"))
+            {
+                inResults = true;
+                continue;
+            }
+            if (!inResults)
+            {
+                continue;
+            }
+
+            const char* textEnd = static_cast<const char*>(memchr(p, '<', end - p));
+            if (!textEnd)
+            {
+                return false;
+            }
+
+            if (ElementNameIs(name, nameLength, "id"))
+            {
+                char buffer[32];
+                CopyElementText(p, textEnd, buffer, sizeof(buffer));
+                result.mGenomeID = 0;
+                for (const char* digit = buffer; *digit >= '0' && *digit <= '9'; ++digit)
+                {
+                    result.mGenomeID = (result.mGenomeID * 10) + (*digit - '0');
+                }
+                haveID = true;
+            }
+            else if (ElementNameIs(name, nameLength, "experiment"))
+            {
+                char buffer[16];
+                CopyElementText(p, textEnd, buffer, sizeof(buffer));
+                result.mExperimentID = 0;
+                for (const char* digit = buffer; *digit >= '0' && *digit <= '9'; ++digit)
+                {
+                    result.mExperimentID = static_cast<boost::uint16_t>((result.mExperimentID * 10) + (*digit - '0'));
+                }
+            }
+            else if (ElementNameIs(name, nameLength, "objective"))
+            {
+                if (result.mNumObjectives < RESULT_MESSAGE_MAX_OBJECTIVES)
+                {
+                    char buffer[64];
+                    CopyElementText(p, textEnd, buffer, sizeof(buffer));
+                    result.mObjectives[result.mNumObjectives++] = CommonLib::StringToDouble(buffer);
+                }
+            }
+            else if (ElementNameIs(name, nameLength, "compute-host"))
+            {
+                CopyElementText(p, textEnd, result.mHost, sizeof(result.mHost));
+            }
+            else if (ElementNameIs(name, nameLength, "error"))
+            {
+                CopyElementText(p, textEnd, result.mError, sizeof(result.mError));
+                result.mStatus = RESULT_STATUS_ERROR;
+            }
+            p = textEnd;
+        }
+
+        return inResults && haveID;
+    }
+
+    //______________________________________________________________________________________________________________
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include "ResultMessage.hpp"
+#include "StagingMessage.hpp"
+
+namespace GridGALib
+{
+    // A required file held in memory so wrappers can fetch it by the SHA-1 of its contents
+    struct StagedFile
+    {
+        std::string mName;
+        std::string mHash;
+        boost::shared_array<char> mData;
+        boost::uint64_t mSize;
+        // permissions of the file on the submit machine, so an executable is still executable on the node
+        boost::uint32_t mMode;
+    };
+
+    // Receives results from the htcondor_job_wrapper processes. A ROUTER socket is bound once for the whole run and
+    // serviced by its own thread, which acknowledges every message as soon as it arrives and hands the payload on to
+    // a pool of worker threads. The workers parse the messages and push the results onto a lock-free queue which the
+    // GA thread drains with Pop(). Requests for staged files also go to the workers, which copy the chunk into a reply
+    // and pass it back to the receive thread to send, so a burst of jobs starting doesn't hold up the results. The
+    // files are added before Start() and never changed afterwards.
+    //
+    // When run_ga runs several experiments they all share one receiver. Each one calls AddExperiment() before Start()
+    // and gets its own queue, and the results are routed by the experiment id the wrapper sends. Results from older
+    // wrappers have no id and go to experiment 0.
+	class ResultsReceiver : boost::noncopyable
+    {
+    public:
+        ResultsReceiver(zmq::context_t& zmqContext, boost::int32_t port, std::size_t numWorkers);
+        ~ResultsReceiver(void);
+        bool Start(void);
+        void Stop(void);
+        // must be called before Start(), returns the new experiment's id
+        std::size_t AddExperiment(void);
+        bool Pop(ResultMessage& result, std::size_t experimentID = 0);
+        void WaitForResults(long timeoutMilliseconds, std::size_t experimentID = 0);
+        void AddStagedFile(const StagedFile& stagedFile);
+
+        static bool ParseResult(const zmq::message_t& message, ResultMessage& result);
+        static bool ParseResultXML(const char* data, std::size_t size, ResultMessage& result);
+    private:
+        zmq::context_t& mZmqContext;
+        boost::int32_t mPort;
+        std::size_t mNumWorkers;
+        std::string mWorkEndpoint;
+        std::string mReplyEndpoint;
+        boost::scoped_ptr<zmq::socket_t> mRouterSocket;
+        boost::scoped_ptr<zmq::socket_t> mWorkSocket;
+        boost::scoped_ptr<zmq::socket_t> mReplySocket;
+        boost::thread_group mThreads;
+        boost::atomic<bool> mRunning;
+        typedef boost::lockfree::queue<ResultMessage> ResultQueue;
+        std::vector<boost::shared_ptr<ResultQueue> > mResults;
+        std::size_t mNumExperiments;
+        boost::mutex mWaitMutex;
+        boost::condition_variable mResultsAvailable;
+        boost::unordered_map<std::string, StagedFile> mStagedFiles;
+
+        void ReceiveLoop(void);
+        void WorkerLoop(void);
+        void BuildStagingReply(const zmq::message_t& payload, zmq::message_t& reply) const;
+    };
+}
@@ -0,0 +1,201 @@
+#include "stdafx.hpp"
+#include "SearchSpace.hpp"
+
+#include <boost/random/uniform_int_distribution.hpp>
+
+namespace GridGALib
+{
+    namespace
+    {
+        const boost::uint64_t ALL_COVERED = std::numeric_limits<boost::uint64_t>::max();
+    }
+
+    //______________________________________________________________________________________________________________
+
+    SearchSpace::SearchSpace(void)
+    :
+        mSize(0),
+        mTracked(false),
+        mNumCovered(0)
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void SearchSpace::SetParameters(const GAParameterMap& parameters)
+    {
+        mParameterIDs.clear();
+        mNumLevels.clear();
+        mSize = parameters.empty() ? 0 : 1;
+        BOOST_FOREACH(const GAParameterMap::value_type& parameter, parameters)
+        {
+            boost::uint64_t numLevels = parameter.second->GetNumLevels();
+            mParameterIDs.push_back(parameter.first);
+            mNumLevels.push_back(numLevels);
+            mSize = (mSize > std::numeric_limits<boost::uint64_t>::max() / numLevels) ?
+                std::numeric_limits<boost::uint64_t>::max() : mSize * numLevels;
+        }
+
+        mTracked = (mSize > 0) && (mSize <= MAX_TRACKED_POINTS);
+        mCovered.clear();
+        if (mTracked)
+        {
+            mCovered.resize(static_cast<std::size_t>((mSize + 63) / 64), 0);
+        }
+        mNumCovered = 0;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    boost::uint64_t SearchSpace::GetSize(void) const
+    {
+        return mSize;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool SearchSpace::IsTracked(void) const
+    {
+        return mTracked;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    boost::uint64_t SearchSpace::GetNumCovered(void) const
+    {
+        return mNumCovered;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool SearchSpace::IsFullyCovered(void) const
+    {
+        return mTracked && mNumCovered == mSize;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    double SearchSpace::GetCoveredFraction(void) const
+    {
+        if (!mTracked)
+        {
+            return 0.0;
+        }
+        return static_cast<double>(mNumCovered) / mSize;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void SearchSpace::ClearCoverage(void)
+    {
+        std::fill(mCovered.begin(), mCovered.end(), 0);
+        mNumCovered = 0;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool SearchSpace::GetIndex(const GenomePtr genome, boost::uint64_t& index) const
+    {
+        if (!mTracked)
+        {
+            return false;
+        }
+
+        const GAParameterMap& parameters(*(genome->GetParameters()));
+        if (parameters.size() != mParameterIDs.size())
+        {
+            return false;
+        }
+
+        index = 0;
+        std::size_t i = 0;
+        BOOST_FOREACH(const GAParameterMap::value_type& parameter, parameters)
+        {
+            if (!parameter.second->GetHasValue() || !parameter.second->IsOnLevel())
+            {
+                return false;
+            }
+            index = (index * mNumLevels[i++]) + parameter.second->GetLevel();
+        }
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool SearchSpace::IsCovered(boost::uint64_t index) const
+    {
+        return (mCovered[static_cast<std::size_t>(index / 64)] & (1ull << (index % 64))) != 0;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool SearchSpace::Cover(boost::uint64_t index)
+    {
+        boost::uint64_t& word(mCovered[static_cast<std::size_t>(index / 64)]);
+        boost::uint64_t bit = 1ull << (index % 64);
+        if ((word & bit) != 0)
+        {
+            return false;
+        }
+        word |= bit;
+        ++mNumCovered;
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void SearchSpace::SetGenome(boost::uint64_t index, GenomePtr genome) const
+    {
+        for (std::size_t i = mParameterIDs.size(); i > 0; --i)
+        {
+            (*(genome->GetParameters()))[mParameterIDs[i - 1]]->SetLevel(static_cast<std::size_t>(index % mNumLevels[i - 1]));
+            index /= mNumLevels[i - 1];
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // Reservoir sampling over the clear bits. Whole covered words are skipped, so a nearly covered space is cheap to
+    // search.
+
+    std::vector<boost::uint64_t> SearchSpace::GetUncovered(std::size_t maxPoints, boost::random::mt19937& random) const
+    {
+        std::vector<boost::uint64_t> points;
+        if (!mTracked || maxPoints == 0)
+        {
+            return points;
+        }
+        points.reserve(static_cast<std::size_t>(std::min<boost::uint64_t>(maxPoints, mSize - mNumCovered)));
+
+        boost::uint64_t numSeen = 0;
+        for (std::size_t word = 0; word < mCovered.size(); ++word)
+        {
+            if (mCovered[word] == ALL_COVERED)
+            {
+                continue;
+            }
+            boost::uint64_t end = std::min<boost::uint64_t>(64, mSize - (static_cast<boost::uint64_t>(word) * 64));
+            for (boost::uint64_t bit = 0; bit < end; ++bit)
+            {
+                if ((mCovered[word] & (1ull << bit)) != 0)
+                {
+                    continue;
+                }
+                boost::uint64_t index = (static_cast<boost::uint64_t>(word) * 64) + bit;
+                if (points.size() < maxPoints)
+                {
+                    points.push_back(index);
+                }
+                else
+                {
+                    boost::uint64_t replace = boost::random::uniform_int_distribution<boost::uint64_t>(0, numSeen)(random);
+                    if (replace < maxPoints)
+                    {
+                        points[static_cast<std::size_t>(replace)] = index;
+                    }
+                }
+                ++numSeen;
+            }
+        }
+        return points;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include "Genome.hpp"
+
+#include <boost/random/mersenne_twister.hpp>
+
+namespace GridGALib
+{
+    // Every combination of the parameters' levels, numbered with the first parameter's level changing slowest. A
+    // bitmap records which points are covered, i.e. evaluated, in flight or about to be submitted. Coverage is only
+    // tracked when the space has at most MAX_TRACKED_POINTS points; bigger spaces are sized and nothing more.
+    //
+    // A genome whose values aren't all on their parameter's levels, e.g. an integer mutated up to a high that isn't
+    // low plus a whole number of steps, has no point in the space and is never covered.
+	class SearchSpace : boost::noncopyable
+    {
+    public:
+        // a bitmap of 16MB
+        static const boost::uint64_t MAX_TRACKED_POINTS = 1ull << 27;
+
+        SearchSpace(void);
+        void SetParameters(const GAParameterMap& parameters);
+
+        // saturates at the largest uint64, which no run will get near
+        boost::uint64_t GetSize(void) const;
+        bool IsTracked(void) const;
+        boost::uint64_t GetNumCovered(void) const;
+        bool IsFullyCovered(void) const;
+        double GetCoveredFraction(void) const;
+
+        void ClearCoverage(void);
+        bool GetIndex(const GenomePtr genome, boost::uint64_t& index) const;
+        bool IsCovered(boost::uint64_t index) const;
+        // false if the point was already covered
+        bool Cover(boost::uint64_t index);
+        // sets the genome's parameters to the point's levels
+        void SetGenome(boost::uint64_t index, GenomePtr genome) const;
+        // up to maxPoints of the points that aren't covered, picked uniformly at random
+        std::vector<boost::uint64_t> GetUncovered(std::size_t maxPoints, boost::random::mt19937& random) const;
+    private:
+        std::vector<std::string> mParameterIDs;
+        std::vector<boost::uint64_t> mNumLevels;
+        boost::uint64_t mSize;
+        bool mTracked;
+        std::vector<boost::uint64_t> mCovered;
+        boost::uint64_t mNumCovered;
+    };
+}
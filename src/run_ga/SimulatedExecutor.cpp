@@ -0,0 +1,507 @@
+#include "stdafx.hpp"
+#include "SimulatedExecutor.hpp"
+#include "Metrics.hpp"
+
+#include <boost/random/exponential_distribution.hpp>
+#include <boost/random/lognormal_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+namespace GridGALib
+{
+    SimulatedExecutor::SimulatedExecutor(const std::string& filesLocation)
+    :
+        mFilesLocation(filesLocation),
+        mGenerationNumber(0),
+        mNumSlots(100),
+        mQueueLatencySeconds(0.0),
+        mSubmitSecondsPerChunk(0.0),
+        mGenerationOverheadSeconds(0.0),
+        mRuntimeDistribution(RUNTIME_FIXED),
+        mRuntimeMeanSeconds(600.0),
+        mRuntimeSpread(0.0),
+        mRuntimeParameterScale(0.0),
+        mEvictPercent(0.0),
+        mKillPercent(0.0),
+        mFunction(SYNTHETIC_RASTRIGIN),
+        mTrapSize(4),
+        mTimeoutMinutes(120),
+        mMaxResubmits(2),
+        mSubmitChunkSize(1000),
+        mCarryOverIncomplete(false),
+        mCarryOverMaxGenerations(1),
+        mSpeculateAfterPercent(0.0),
+        mClock(0.0),
+        mNumFreeSlots(0),
+        mBusySlotSeconds(0.0),
+        mNumReceived(0),
+        mNumFailed(0),
+        mNumEvictions(0),
+        mNumResubmissions(0),
+        mNumSpeculativeCopies(0),
+        mBestObjective(-1.0 * std::numeric_limits<double>::max())
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+
+    RuntimeDistribution SimulatedExecutor::RuntimeDistributionFromString(const std::string& name)
+    {
+        if (boost::iequals(name, "fixed"))
+        {
+            return RUNTIME_FIXED;
+        }
+        else if (boost::iequals(name, "uniform"))
+        {
+            return RUNTIME_UNIFORM;
+        }
+        else if (boost::iequals(name, "exponential"))
+        {
+            return RUNTIME_EXPONENTIAL;
+        }
+        else if (boost::iequals(name, "lognormal"))
+        {
+            return RUNTIME_LOGNORMAL;
+        }
+        return RUNTIME_UNKNOWN;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool SimulatedExecutor::ReadConfig(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap)
+    {
+        mNumSlots = std::max<std::size_t>(CommonLib::GetOptionalParameter<std::size_t>("config.simulation.slots", pt, 100), 1);
+        mNumFreeSlots = mNumSlots;
+        // between a job being queued and it being able to start
+        mQueueLatencySeconds = CommonLib::GetOptionalParameter<double>("config.simulation.queue-latency-seconds", pt, 0.0);
+        // time taken by each condor_submit, the chunks of a generation are submitted one after the other
+        mSubmitSecondsPerChunk = CommonLib::GetOptionalParameter<double>("config.simulation.submit-seconds-per-chunk", pt, 0.0);
+        // breeding, writing the cache and anything else the GA does between generations
+        mGenerationOverheadSeconds = CommonLib::GetOptionalParameter<double>("config.simulation.generation-overhead-seconds", pt, 0.0);
+
+        // fixed | uniform | exponential | lognormal. spread is the half width of uniform as a fraction of the mean, and
+        // sigma of the underlying normal for lognormal.
+        std::string distribution = CommonLib::GetOptionalParameter<std::string>("config.simulation.runtime-distribution", pt, "fixed");
+        mRuntimeDistribution = RuntimeDistributionFromString(distribution);
+        if (mRuntimeDistribution == RUNTIME_UNKNOWN)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Unknown runtime distribution: " << distribution;
+            return false;
+        }
+        mRuntimeMeanSeconds = CommonLib::GetOptionalParameter<double>("config.simulation.runtime-mean-seconds", pt, 600.0);
+        mRuntimeSpread = CommonLib::GetOptionalParameter<double>("config.simulation.runtime-spread", pt, 0.0);
+        // the runtime is multiplied by 1 + scale * the parameter's position in its range, e.g. for a number of epochs
+        mRuntimeParameter = CommonLib::GetOptionalParameter<std::string>("config.simulation.runtime-parameter", pt, "");
+        mRuntimeParameterScale = CommonLib::GetOptionalParameter<double>("config.simulation.runtime-parameter-scale", pt, 1.0);
+        if (!mRuntimeParameter.empty() && parameterMap->find(mRuntimeParameter) == parameterMap->end())
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Unknown runtime parameter: " << mRuntimeParameter;
+            return false;
+        }
+
+        mEvictPercent = CommonLib::GetOptionalParameter<double>("config.simulation.evict-percent", pt, 0.0);
+        mKillPercent = CommonLib::GetOptionalParameter<double>("config.simulation.kill-percent", pt, 0.0);
+
+        std::string function = CommonLib::GetOptionalParameter<std::string>("config.simulation.function", pt, "rastrigin");
+        mFunction = SyntheticObjective::FromString(function);
+        if (mFunction == SYNTHETIC_UNKNOWN)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Unknown synthetic function: " << function;
+            return false;
+        }
+        mTrapSize = CommonLib::GetOptionalParameter<std::size_t>("config.simulation.trap-size", pt, 4);
+
+        // the same settings as the HTCondor executor, so a config can be simulated by changing its execution-type
+        mTimeoutMinutes = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.timeout-minutes", pt, 120);
+        mMaxResubmits = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.max-resubmits", pt, 2);
+        mSubmitChunkSize = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.submit-chunk-size", pt, 1000);
+        mCarryOverIncomplete = CommonLib::GetOptionalBoolParameter("config.htcondor.carry-over-incomplete", pt, false);
+        mCarryOverMaxGenerations = CommonLib::GetOptionalParameter<std::size_t>("config.htcondor.carry-over-max-generations", pt, 1);
+        // once this percentage of a generation's results are in, idle slots run a second copy of each job still
+        // running and the first copy to finish is used. 0 turns it off.
+        mSpeculateAfterPercent = CommonLib::GetOptionalParameter<double>("config.simulation.speculate-after-percent", pt, 0.0);
+
+        mRandom.seed(CommonLib::GetOptionalParameter<boost::uint32_t>("config.simulation.random-seed", pt, 1));
+
+        std::string simulationFile = CommonLib::GetOptionalParameter<std::string>("config.simulation.simulation-file", pt, "simulation.csv");
+        if (!simulationFile.empty())
+        {
+            std::string fileName(mFilesLocation + "/" + simulationFile);
+            mSimulationFile.open(fileName.c_str());
+            if (!mSimulationFile)
+            {
+                FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Cannot write " << fileName;
+                return false;
+            }
+            mSimulationFile << "generation,start_seconds,end_seconds,submitted,received,failed,timed_out,carried_over,evictions,"
+                "resubmissions,speculative_copies,utilisation,best_objective\n";
+        }
+
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Simulating " << mNumSlots << " slots, " << distribution << " runtimes with a mean of " <<
+            mRuntimeMeanSeconds << " seconds, using the synthetic objective " << SyntheticObjective::ToString(mFunction) << ".";
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool SimulatedExecutor::ExecuteGeneration(GenomeList genomesToTest, GenomeList genomeCache, std::size_t generationNumber)
+    {
+        mGenomeCache = genomeCache;
+        mGenerationNumber = generationNumber;
+        mNumReceived = 0;
+        mNumFailed = 0;
+        mNumEvictions = 0;
+        mNumResubmissions = 0;
+        mNumSpeculativeCopies = 0;
+
+        AdvanceClock(mClock + mGenerationOverheadSeconds);
+        double startTime = mClock;
+        double startBusySlotSeconds = mBusySlotSeconds;
+
+        std::vector<GenomePtr> genomesToSubmit;
+        BOOST_FOREACH(GenomePtr genome, *genomesToTest)
+        {
+            if (!genome->IsComplete())
+            {
+                mGenomesAwaitingResults[genome->GetGenomeID()] = genome;
+                mGenomeSubmitGenerations[genome->GetGenomeID()] = mGenerationNumber;
+                genomesToSubmit.push_back(genome);
+            }
+        }
+
+        // each chunk's jobs are queued once its condor_submit has returned
+        std::size_t chunkSize = (mSubmitChunkSize > 0) ? mSubmitChunkSize : std::max<std::size_t>(genomesToSubmit.size(), 1);
+        for (std::size_t i = 0; i < genomesToSubmit.size(); ++i)
+        {
+            QueueJob(genomesToSubmit[i], startTime + ((i / chunkSize) + 1) * mSubmitSecondsPerChunk + mQueueLatencySeconds, false);
+        }
+
+        // includes any genomes carried over from the previous generation
+        std::size_t numWanted = mGenomesAwaitingResults.size();
+        double deadline = startTime + (mTimeoutMinutes * 60.0);
+        bool timedOut = false;
+        while (mNumReceived < numWanted)
+        {
+            StartReadyJobs();
+            SpeculateOnStragglers(numWanted);
+
+            double nextEvent = std::numeric_limits<double>::max();
+            if (!mRunningJobs.empty())
+            {
+                nextEvent = mRunningJobs.begin()->first;
+            }
+            if (mNumFreeSlots > 0 && !mIdleJobs.empty())
+            {
+                nextEvent = std::min(nextEvent, mIdleJobs.begin()->first);
+            }
+            if (nextEvent == std::numeric_limits<double>::max())
+            {
+                FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "Nothing left to run with " << (numWanted - mNumReceived) << " results outstanding.";
+                break;
+            }
+            if (nextEvent > deadline)
+            {
+                AdvanceClock(deadline);
+                timedOut = true;
+                break;
+            }
+
+            AdvanceClock(nextEvent);
+            while (!mRunningJobs.empty() && mRunningJobs.begin()->first <= mClock)
+            {
+                SimulatedJobPtr job(mRunningJobs.begin()->second);
+                mRunningJobs.erase(mRunningJobs.begin());
+                ++mNumFreeSlots;
+                FinishJob(job);
+            }
+        }
+
+        std::size_t numCarriedOver = CancelUnwantedJobs();
+        std::sort(mGenomeCache->begin(), mGenomeCache->end(), CompareGenomeByObjective);
+
+        double duration = mClock - startTime;
+        double utilisation = (duration > 0.0) ? (mBusySlotSeconds - startBusySlotSeconds) / (duration * mNumSlots) : 0.0;
+        if (mSimulationFile.is_open())
+        {
+            mSimulationFile << mGenerationNumber << "," << startTime << "," << mClock << "," << genomesToSubmit.size() << "," <<
+                mNumReceived << "," << mNumFailed << "," << (timedOut ? 1 : 0) << "," << numCarriedOver << "," << mNumEvictions << "," <<
+                mNumResubmissions << "," << mNumSpeculativeCopies << "," << utilisation << "," << mBestObjective << "\n";
+            mSimulationFile.flush();
+        }
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Generation " << mGenerationNumber << " took " << duration << " simulated seconds, " <<
+            mNumReceived << "/" << numWanted << " results, utilisation " << utilisation << ", best objective " << mBestObjective;
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    std::vector<GenomePtr> SimulatedExecutor::GetGenomesInFlight(void) const
+    {
+        std::vector<GenomePtr> genomes;
+        for (boost::unordered_map<std::size_t, GenomePtr>::const_iterator itr = mGenomesAwaitingResults.begin(); itr != mGenomesAwaitingResults.end(); ++itr)
+        {
+            genomes.push_back(itr->second);
+        }
+        return genomes;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    double SimulatedExecutor::GetRuntimeSeconds(const GenomePtr genome)
+    {
+        double runtime = mRuntimeMeanSeconds;
+        switch (mRuntimeDistribution)
+        {
+        case RUNTIME_UNIFORM:
+            runtime = mRuntimeMeanSeconds * (1.0 + mRuntimeSpread * ((2.0 * RandomUniform()) - 1.0));
+            break;
+        case RUNTIME_EXPONENTIAL:
+            runtime = boost::random::exponential_distribution<double>(1.0 / std::max(mRuntimeMeanSeconds, 1e-9))(mRandom);
+            break;
+        case RUNTIME_LOGNORMAL:
+            // mu is chosen so the mean of the distribution is the mean runtime
+            runtime = boost::random::lognormal_distribution<double>(std::log(std::max(mRuntimeMeanSeconds, 1e-9)) -
+                (mRuntimeSpread * mRuntimeSpread / 2.0), mRuntimeSpread)(mRandom);
+            break;
+        default:
+            break;
+        }
+
+        if (!mRuntimeParameter.empty())
+        {
+            GAParameterMap::const_iterator parameter = genome->GetParameters()->find(mRuntimeParameter);
+            if (parameter != genome->GetParameters()->end() && parameter->second->GetHasValue())
+            {
+                runtime *= 1.0 + (mRuntimeParameterScale * parameter->second->GetNormalisedValue());
+            }
+        }
+        return std::max(runtime, 0.0);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void SimulatedExecutor::Evaluate(const GenomePtr genome, ResultMessage& result)
+    {
+        result.mNumObjectives = 1;
+        result.mObjectives[0] = SyntheticObjective::Evaluate(mFunction, genome->GetParameters(), mTrapSize);
+        result.SetHost("simulated", 9);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    double SimulatedExecutor::RandomUniform(void)
+    {
+        return boost::random::uniform_real_distribution<double>(0.0, 1.0)(mRandom);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void SimulatedExecutor::AdvanceClock(double time)
+    {
+        if (time > mClock)
+        {
+            mBusySlotSeconds += (time - mClock) * (mNumSlots - mNumFreeSlots);
+            mClock = time;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void SimulatedExecutor::QueueJob(GenomePtr genome, double readyTime, bool speculative)
+    {
+        SimulatedJobPtr job(boost::make_shared<SimulatedJob>());
+        job->mGenome = genome;
+        job->mStartTime = 0.0;
+        job->mOutcome = OUTCOME_FINISHED;
+        job->mSpeculative = speculative;
+        mIdleJobs.insert(std::make_pair(readyTime, job));
+    }
+
+    //______________________________________________________________________________________________________________
+    // Whether the job is evicted or killed is decided when it starts, along with how long it runs before it is
+
+    void SimulatedExecutor::StartReadyJobs(void)
+    {
+        while (mNumFreeSlots > 0 && !mIdleJobs.empty() && mIdleJobs.begin()->first <= mClock)
+        {
+            SimulatedJobPtr job(mIdleJobs.begin()->second);
+            mIdleJobs.erase(mIdleJobs.begin());
+            --mNumFreeSlots;
+
+            job->mStartTime = mClock;
+            double runtime = GetRuntimeSeconds(job->mGenome);
+            double chance = RandomUniform() * 100.0;
+            if (chance < mEvictPercent)
+            {
+                job->mOutcome = OUTCOME_EVICTED;
+                runtime *= RandomUniform();
+            }
+            else if (chance < mEvictPercent + mKillPercent)
+            {
+                job->mOutcome = OUTCOME_KILLED;
+                runtime *= RandomUniform();
+            }
+            else
+            {
+                job->mOutcome = OUTCOME_FINISHED;
+            }
+            mRunningJobs.insert(std::make_pair(mClock + runtime, job));
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // Only once nothing else is waiting for a slot, so the copies never hold up the generation's own jobs
+
+    void SimulatedExecutor::SpeculateOnStragglers(std::size_t numWanted)
+    {
+        if (mSpeculateAfterPercent <= 0.0 || mNumFreeSlots == 0 || !mIdleJobs.empty() ||
+            (mNumReceived * 100.0) < (mSpeculateAfterPercent * numWanted))
+        {
+            return;
+        }
+
+        std::vector<GenomePtr> stragglers;
+        for (JobQueue::const_iterator itr = mRunningJobs.begin(); itr != mRunningJobs.end(); ++itr)
+        {
+            if (stragglers.size() < mNumFreeSlots && !itr->second->mSpeculative && mSpeculatedGenomes.insert(itr->second->mGenome->GetGenomeID()).second)
+            {
+                stragglers.push_back(itr->second->mGenome);
+            }
+        }
+        BOOST_FOREACH(GenomePtr genome, stragglers)
+        {
+            QueueJob(genome, mClock + mQueueLatencySeconds, true);
+            ++mNumSpeculativeCopies;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // Called once the job has left its slot. Evicted jobs go back in the queue as HTCondor does with them, killed
+    // ones are resubmitted as the HTCondor executor does after a hold or an abnormal exit.
+
+    void SimulatedExecutor::FinishJob(SimulatedJobPtr job)
+    {
+        std::size_t genomeID = job->mGenome->GetGenomeID();
+        if (mGenomesAwaitingResults.find(genomeID) == mGenomesAwaitingResults.end())
+        {
+            return;
+        }
+
+        if (job->mOutcome == OUTCOME_EVICTED)
+        {
+            ++mNumEvictions;
+            QueueJob(job->mGenome, mClock + mQueueLatencySeconds, job->mSpeculative);
+        }
+        else if (job->mOutcome == OUTCOME_KILLED)
+        {
+            if (mResubmitCounts[genomeID]++ < mMaxResubmits)
+            {
+                Metrics::Instance().Increment(Metrics::JOBS_RESUBMITTED);
+                ++mNumResubmissions;
+                QueueJob(job->mGenome, mClock + mSubmitSecondsPerChunk + mQueueLatencySeconds, job->mSpeculative);
+            }
+            else
+            {
+                Metrics::Instance().Increment(Metrics::JOBS_FAILED);
+                ++mNumFailed;
+                ResultMessage result;
+                result.Clear();
+                result.mGenomeID = genomeID;
+                result.mStatus = RESULT_STATUS_ERROR;
+                result.SetError("killed", 6);
+                result.SetHost("simulated", 9);
+                CompleteGenome(job->mGenome, result);
+            }
+        }
+        else
+        {
+            ResultMessage result;
+            result.Clear();
+            result.mGenomeID = genomeID;
+            result.mExecuteMs = static_cast<boost::uint32_t>((mClock - job->mStartTime) * 1000.0);
+            Evaluate(job->mGenome, result);
+            if (result.mStatus != RESULT_STATUS_OK)
+            {
+                ++mNumFailed;
+            }
+            CompleteGenome(job->mGenome, result);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void SimulatedExecutor::CompleteGenome(GenomePtr genome, const ResultMessage& result)
+    {
+        std::size_t genomeID = genome->GetGenomeID();
+        mGenomesAwaitingResults.erase(genomeID);
+        mGenomeSubmitGenerations.erase(genomeID);
+        mResubmitCounts.erase(genomeID);
+        mSpeculatedGenomes.erase(genomeID);
+        // any other copy is no longer wanted
+        RemoveJobs(genomeID);
+
+        genome->Update(result);
+        mGenomeCache->push_back(genome);
+        Metrics::Instance().Increment(Metrics::RESULTS_RECEIVED);
+        ++mNumReceived;
+        if (result.mStatus == RESULT_STATUS_OK)
+        {
+            mBestObjective = std::max(mBestObjective, genome->GetObjective());
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void SimulatedExecutor::RemoveJobs(std::size_t genomeID)
+    {
+        for (JobQueue::iterator itr = mRunningJobs.begin(); itr != mRunningJobs.end(); )
+        {
+            if (itr->second->mGenome->GetGenomeID() == genomeID)
+            {
+                mRunningJobs.erase(itr++);
+                ++mNumFreeSlots;
+            }
+            else
+            {
+                ++itr;
+            }
+        }
+        for (JobQueue::iterator itr = mIdleJobs.begin(); itr != mIdleJobs.end(); )
+        {
+            if (itr->second->mGenome->GetGenomeID() == genomeID)
+            {
+                mIdleJobs.erase(itr++);
+            }
+            else
+            {
+                ++itr;
+            }
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+    // As HTCondor::CancelUnwantedJobs, returns the number of genomes carried over to the next generation
+
+    std::size_t SimulatedExecutor::CancelUnwantedJobs(void)
+    {
+        std::vector<std::size_t> genomesToCancel;
+        for (boost::unordered_map<std::size_t, GenomePtr>::const_iterator itr = mGenomesAwaitingResults.begin(); itr != mGenomesAwaitingResults.end(); ++itr)
+        {
+            if (!mCarryOverIncomplete || (mGenerationNumber - mGenomeSubmitGenerations[itr->first]) >= mCarryOverMaxGenerations)
+            {
+                genomesToCancel.push_back(itr->first);
+            }
+        }
+
+        BOOST_FOREACH(std::size_t genomeID, genomesToCancel)
+        {
+            RemoveJobs(genomeID);
+            mGenomesAwaitingResults.erase(genomeID);
+            mGenomeSubmitGenerations.erase(genomeID);
+            mResubmitCounts.erase(genomeID);
+            mSpeculatedGenomes.erase(genomeID);
+        }
+        return mGenomesAwaitingResults.size();
+    }
+
+    //______________________________________________________________________________________________________________
+}
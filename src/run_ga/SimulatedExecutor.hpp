@@ -0,0 +1,123 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include "Executor.hpp"
+#include "SyntheticObjective.hpp"
+
+#include <boost/random/mersenne_twister.hpp>
+
+namespace GridGALib
+{
+    enum RuntimeDistribution
+    {
+        RUNTIME_FIXED,
+        RUNTIME_UNIFORM,
+        RUNTIME_EXPONENTIAL,
+        RUNTIME_LOGNORMAL,
+        RUNTIME_UNKNOWN
+    };
+
+    // execution-type simulated. Runs each generation against a model of an HTCondor pool in virtual time, so
+    // scheduling settings can be compared on makespan and slot utilisation in seconds rather than by running them on
+    // the pool. The pool has a fixed number of slots, a queue latency, a runtime for each job drawn from
+    // config.simulation's distribution (optionally scaled by one of the genome's parameters) and a chance of each job
+    // being evicted, which puts it back in the queue, or killed, which resubmits it. The genome's objective comes
+    // from a synthetic function.
+    //
+    // The scheduling settings are read from config.htcondor as they are for a real run: timeout-minutes,
+    // max-resubmits, submit-chunk-size, carry-over-incomplete and carry-over-max-generations. Speculative copies of
+    // the jobs still running near the end of a generation can also be tried, which the HTCondor executor doesn't do.
+    // A row for every generation is written to config.simulation.simulation-file.
+	class SimulatedExecutor : public Executor
+    {
+    public:
+        SimulatedExecutor(const std::string& filesLocation);
+        bool ReadConfig(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap) override;
+        bool ExecuteGeneration(GenomeList genomesToTest, GenomeList genomeCache, std::size_t generationNumber) override;
+        std::vector<GenomePtr> GetGenomesInFlight(void) const override;
+
+        static RuntimeDistribution RuntimeDistributionFromString(const std::string& name);
+    protected:
+        // called when each attempt at running the genome starts
+        virtual double GetRuntimeSeconds(const GenomePtr genome);
+        // called when it finishes, fills in the objective and the host
+        virtual void Evaluate(const GenomePtr genome, ResultMessage& result);
+    private:
+        enum JobOutcome
+        {
+            OUTCOME_FINISHED,
+            OUTCOME_EVICTED,
+            OUTCOME_KILLED
+        };
+
+        struct SimulatedJob
+        {
+            GenomePtr mGenome;
+            double mStartTime;
+            JobOutcome mOutcome;
+            bool mSpeculative;
+        };
+        typedef boost::shared_ptr<SimulatedJob> SimulatedJobPtr;
+        // both keyed on virtual time, equal times keep the order they were added in
+        typedef std::multimap<double, SimulatedJobPtr> JobQueue;
+
+        std::string mFilesLocation;
+        std::size_t mGenerationNumber;
+        GenomeList mGenomeCache;
+
+        // the pool
+        std::size_t mNumSlots;
+        double mQueueLatencySeconds;
+        double mSubmitSecondsPerChunk;
+        double mGenerationOverheadSeconds;
+        RuntimeDistribution mRuntimeDistribution;
+        double mRuntimeMeanSeconds;
+        double mRuntimeSpread;
+        std::string mRuntimeParameter;
+        double mRuntimeParameterScale;
+        double mEvictPercent;
+        double mKillPercent;
+        SyntheticFunction mFunction;
+        std::size_t mTrapSize;
+
+        // scheduling
+        std::size_t mTimeoutMinutes;
+        std::size_t mMaxResubmits;
+        std::size_t mSubmitChunkSize;
+        bool mCarryOverIncomplete;
+        std::size_t mCarryOverMaxGenerations;
+        double mSpeculateAfterPercent;
+
+        // state of the pool, carried from one generation to the next
+        double mClock;
+        std::size_t mNumFreeSlots;
+        double mBusySlotSeconds;
+        JobQueue mIdleJobs;
+        JobQueue mRunningJobs;
+        boost::unordered_map<std::size_t, GenomePtr> mGenomesAwaitingResults;
+        boost::unordered_map<std::size_t, std::size_t> mGenomeSubmitGenerations;
+        boost::unordered_map<std::size_t, std::size_t> mResubmitCounts;
+        std::set<std::size_t> mSpeculatedGenomes;
+        boost::random::mt19937 mRandom;
+
+        // totals for the generation being run
+        std::size_t mNumReceived;
+        std::size_t mNumFailed;
+        std::size_t mNumEvictions;
+        std::size_t mNumResubmissions;
+        std::size_t mNumSpeculativeCopies;
+        double mBestObjective;
+        std::ofstream mSimulationFile;
+
+        double RandomUniform(void);
+        void AdvanceClock(double time);
+        void QueueJob(GenomePtr genome, double readyTime, bool speculative);
+        void StartReadyJobs(void);
+        void SpeculateOnStragglers(std::size_t numWanted);
+        void FinishJob(SimulatedJobPtr job);
+        void CompleteGenome(GenomePtr genome, const ResultMessage& result);
+        void RemoveJobs(std::size_t genomeID);
+        std::size_t CancelUnwantedJobs(void);
+    };
+}
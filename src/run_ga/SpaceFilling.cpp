@@ -0,0 +1,350 @@
+#include "stdafx.hpp"
+#include "SpaceFilling.hpp"
+
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+namespace GridGALib
+{
+    namespace
+    {
+        // Joe and Kuo's direction numbers (new-joe-kuo-6.21201) for dimensions 2 to 21: the degree s of the primitive
+        // polynomial, its coefficients a, and the initial direction numbers m_1..m_s. The first dimension is the van
+        // der Corput sequence.
+        struct SobolDirections
+        {
+            boost::uint32_t mDegree;
+            boost::uint32_t mCoefficients;
+            boost::uint32_t mInitial[7];
+        };
+
+        const SobolDirections SOBOL_DIRECTIONS[] =
+        {
+            { 1, 0, { 1 } },
+            { 2, 1, { 1, 3 } },
+            { 3, 1, { 1, 3, 1 } },
+            { 3, 2, { 1, 1, 1 } },
+            { 4, 1, { 1, 1, 3, 3 } },
+            { 4, 4, { 1, 3, 5, 13 } },
+            { 5, 2, { 1, 1, 5, 5, 17 } },
+            { 5, 4, { 1, 1, 5, 5, 5 } },
+            { 5, 7, { 1, 1, 7, 11, 19 } },
+            { 5, 11, { 1, 1, 5, 1, 1 } },
+            { 5, 13, { 1, 1, 1, 3, 11 } },
+            { 5, 14, { 1, 3, 5, 5, 31 } },
+            { 6, 1, { 1, 3, 3, 9, 7, 49 } },
+            { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+            { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+            { 6, 19, { 1, 1, 1, 15, 7, 5 } },
+            { 6, 22, { 1, 3, 1, 15, 13, 25 } },
+            { 6, 25, { 1, 1, 5, 5, 19, 61 } },
+            { 7, 1, { 1, 3, 7, 11, 23, 15, 103 } },
+            { 7, 4, { 1, 3, 7, 13, 13, 15, 69 } }
+        };
+        const std::size_t SOBOL_MAX_DIMENSIONS = 1 + (sizeof(SOBOL_DIRECTIONS) / sizeof(SOBOL_DIRECTIONS[0]));
+        const std::size_t SOBOL_BITS = 32;
+
+        //______________________________________________________________________________________________________________
+
+        boost::uint32_t Parity(boost::uint32_t bits)
+        {
+            bits ^= bits >> 16;
+            bits ^= bits >> 8;
+            bits ^= bits >> 4;
+            bits ^= bits >> 2;
+            bits ^= bits >> 1;
+            return bits & 1;
+        }
+
+        //______________________________________________________________________________________________________________
+        // The bits of the direction numbers are digits after the binary point, most significant first
+
+        std::vector<boost::uint32_t> GetDirectionNumbers(std::size_t dimension)
+        {
+            std::vector<boost::uint32_t> directions(SOBOL_BITS);
+            if (dimension == 0)
+            {
+                for (std::size_t k = 0; k < SOBOL_BITS; ++k)
+                {
+                    directions[k] = 1u << (SOBOL_BITS - 1 - k);
+                }
+                return directions;
+            }
+
+            const SobolDirections& table = SOBOL_DIRECTIONS[dimension - 1];
+            std::size_t degree = table.mDegree;
+            for (std::size_t k = 0; k < SOBOL_BITS; ++k)
+            {
+                if (k < degree)
+                {
+                    directions[k] = table.mInitial[k] << (SOBOL_BITS - 1 - k);
+                }
+                else
+                {
+                    directions[k] = directions[k - degree] ^ (directions[k - degree] >> degree);
+                    for (std::size_t l = 1; l < degree; ++l)
+                    {
+                        if ((table.mCoefficients >> (degree - 1 - l)) & 1)
+                        {
+                            directions[k] ^= directions[k - l];
+                        }
+                    }
+                }
+            }
+            return directions;
+        }
+
+        //______________________________________________________________________________________________________________
+
+        void Shuffle(std::vector<std::size_t>& values, boost::random::mt19937& random)
+        {
+            for (std::size_t i = values.size(); i > 1; --i)
+            {
+                std::size_t j = boost::random::uniform_int_distribution<std::size_t>(0, i - 1)(random);
+                std::swap(values[i - 1], values[j]);
+            }
+        }
+
+        //______________________________________________________________________________________________________________
+
+        void FillLatinHypercubeColumn(DesignPoints& points, std::size_t dimension, boost::random::mt19937& random)
+        {
+            std::vector<std::size_t> slices(points.size());
+            for (std::size_t i = 0; i < slices.size(); ++i)
+            {
+                slices[i] = i;
+            }
+            Shuffle(slices, random);
+            boost::random::uniform_real_distribution<double> uniform(0.0, 1.0);
+            for (std::size_t i = 0; i < points.size(); ++i)
+            {
+                points[i][dimension] = std::min((slices[i] + uniform(random)) / points.size(), 1.0 - 1e-12);
+            }
+        }
+
+        //______________________________________________________________________________________________________________
+
+        double SquaredDistance(const std::vector<double>& a, const std::vector<double>& b)
+        {
+            double distance = 0.0;
+            for (std::size_t i = 0; i < a.size(); ++i)
+            {
+                distance += (a[i] - b[i]) * (a[i] - b[i]);
+            }
+            return distance;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    SpaceFillingDesign SpaceFilling::FromString(const std::string& name)
+    {
+        for (boost::int32_t design = DESIGN_RANDOM; design < DESIGN_UNKNOWN; ++design)
+        {
+            if (boost::iequals(name, ToString(static_cast<SpaceFillingDesign>(design))))
+            {
+                return static_cast<SpaceFillingDesign>(design);
+            }
+        }
+        return DESIGN_UNKNOWN;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    std::string SpaceFilling::ToString(SpaceFillingDesign design)
+    {
+        switch (design)
+        {
+        case DESIGN_RANDOM:
+            return "random";
+        case DESIGN_LATIN_HYPERCUBE:
+            return "lhs";
+        case DESIGN_SOBOL:
+            return "sobol";
+        case DESIGN_MAXIMIN_LATIN_HYPERCUBE:
+            return "maximin-lhs";
+        default:
+            return "unknown";
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    DesignPoints SpaceFilling::Generate(SpaceFillingDesign design, std::size_t numPoints, std::size_t numDimensions,
+        boost::random::mt19937& random, std::size_t maximinIterations)
+    {
+        switch (design)
+        {
+        case DESIGN_LATIN_HYPERCUBE:
+            return LatinHypercube(numPoints, numDimensions, random);
+        case DESIGN_SOBOL:
+            return ScrambledSobol(numPoints, numDimensions, random);
+        case DESIGN_MAXIMIN_LATIN_HYPERCUBE:
+            return MaximinLatinHypercube(numPoints, numDimensions, random, maximinIterations);
+        default:
+            return DesignPoints();
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    DesignPoints SpaceFilling::LatinHypercube(std::size_t numPoints, std::size_t numDimensions, boost::random::mt19937& random)
+    {
+        DesignPoints points(numPoints, std::vector<double>(numDimensions, 0.0));
+        for (std::size_t dimension = 0; dimension < numDimensions; ++dimension)
+        {
+            FillLatinHypercubeColumn(points, dimension, random);
+        }
+        return points;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Matousek's linear matrix scramble: each direction number is multiplied by a random lower triangular matrix with
+    // a unit diagonal, which keeps the net properties of the sequence, then every point is XORed with a random shift.
+    // The points are generated in Gray code order, so the first 2^m of them are a (t, m, s)-net.
+
+    DesignPoints SpaceFilling::ScrambledSobol(std::size_t numPoints, std::size_t numDimensions, boost::random::mt19937& random)
+    {
+        DesignPoints points(numPoints, std::vector<double>(numDimensions, 0.0));
+        std::size_t numSobolDimensions = std::min(numDimensions, SOBOL_MAX_DIMENSIONS);
+        boost::random::uniform_int_distribution<boost::uint32_t> randomBits;
+        for (std::size_t dimension = 0; dimension < numSobolDimensions; ++dimension)
+        {
+            std::vector<boost::uint32_t> directions(GetDirectionNumbers(dimension));
+
+            std::vector<boost::uint32_t> scramble(SOBOL_BITS);
+            for (std::size_t row = 0; row < SOBOL_BITS; ++row)
+            {
+                boost::uint32_t below = (row == 0) ? 0 : (0xFFFFFFFFu << (SOBOL_BITS - row));
+                scramble[row] = (1u << (SOBOL_BITS - 1 - row)) | (randomBits(random) & below);
+            }
+            for (std::size_t k = 0; k < SOBOL_BITS; ++k)
+            {
+                boost::uint32_t scrambled = 0;
+                for (std::size_t row = 0; row < SOBOL_BITS; ++row)
+                {
+                    scrambled |= Parity(scramble[row] & directions[k]) << (SOBOL_BITS - 1 - row);
+                }
+                directions[k] = scrambled;
+            }
+
+            boost::uint32_t x = randomBits(random);
+            for (std::size_t i = 0; i < numPoints; ++i)
+            {
+                points[i][dimension] = x / 4294967296.0;
+                // the direction number of the lowest zero bit of i
+                std::size_t bit = 0;
+                while (((i >> bit) & 1) != 0)
+                {
+                    ++bit;
+                }
+                x ^= directions[std::min(bit, SOBOL_BITS - 1)];
+            }
+        }
+
+        for (std::size_t dimension = numSobolDimensions; dimension < numDimensions; ++dimension)
+        {
+            FillLatinHypercubeColumn(points, dimension, random);
+        }
+        return points;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Each iteration moves one of the two closest points by swapping one of its coordinates with another point's,
+    // which keeps the design a Latin hypercube. Keeping the distance matrix makes this O(n^2) an iteration, so large
+    // populations are left as a plain Latin hypercube.
+
+    DesignPoints SpaceFilling::MaximinLatinHypercube(std::size_t numPoints, std::size_t numDimensions, boost::random::mt19937& random,
+        std::size_t numIterations)
+    {
+        DesignPoints points(LatinHypercube(numPoints, numDimensions, random));
+        if (numPoints < 3 || numDimensions == 0 || numPoints > 2000)
+        {
+            return points;
+        }
+
+        std::vector<double> distances(numPoints * numPoints, 0.0);
+        for (std::size_t i = 0; i < numPoints; ++i)
+        {
+            for (std::size_t j = i + 1; j < numPoints; ++j)
+            {
+                distances[(i * numPoints) + j] = distances[(j * numPoints) + i] = SquaredDistance(points[i], points[j]);
+            }
+        }
+
+        boost::random::uniform_int_distribution<std::size_t> randomPoint(0, numPoints - 1);
+        boost::random::uniform_int_distribution<std::size_t> randomDimension(0, numDimensions - 1);
+        std::vector<double> oldRow1(numPoints);
+        std::vector<double> oldRow2(numPoints);
+        for (std::size_t iteration = 0; iteration < numIterations; ++iteration)
+        {
+            // the closest pair
+            double minimum = std::numeric_limits<double>::max();
+            std::size_t closest1 = 0;
+            std::size_t closest2 = 1;
+            for (std::size_t i = 0; i < numPoints; ++i)
+            {
+                for (std::size_t j = i + 1; j < numPoints; ++j)
+                {
+                    if (distances[(i * numPoints) + j] < minimum)
+                    {
+                        minimum = distances[(i * numPoints) + j];
+                        closest1 = i;
+                        closest2 = j;
+                    }
+                }
+            }
+
+            std::size_t point1 = (randomPoint(random) % 2 == 0) ? closest1 : closest2;
+            std::size_t point2 = randomPoint(random);
+            if (point2 == point1)
+            {
+                continue;
+            }
+            std::size_t dimension = randomDimension(random);
+
+            std::swap(points[point1][dimension], points[point2][dimension]);
+            for (std::size_t i = 0; i < numPoints; ++i)
+            {
+                oldRow1[i] = distances[(point1 * numPoints) + i];
+                oldRow2[i] = distances[(point2 * numPoints) + i];
+            }
+            double newMinimum = std::numeric_limits<double>::max();
+            for (std::size_t i = 0; i < numPoints; ++i)
+            {
+                if (i != point1)
+                {
+                    distances[(point1 * numPoints) + i] = distances[(i * numPoints) + point1] = SquaredDistance(points[point1], points[i]);
+                }
+                if (i != point2)
+                {
+                    distances[(point2 * numPoints) + i] = distances[(i * numPoints) + point2] = SquaredDistance(points[point2], points[i]);
+                }
+            }
+            for (std::size_t i = 0; i < numPoints; ++i)
+            {
+                for (std::size_t j = i + 1; j < numPoints; ++j)
+                {
+                    newMinimum = std::min(newMinimum, distances[(i * numPoints) + j]);
+                }
+            }
+
+            if (newMinimum < minimum)
+            {
+                // undo
+                std::swap(points[point1][dimension], points[point2][dimension]);
+                for (std::size_t i = 0; i < numPoints; ++i)
+                {
+                    distances[(point1 * numPoints) + i] = distances[(i * numPoints) + point1] = oldRow1[i];
+                }
+                for (std::size_t i = 0; i < numPoints; ++i)
+                {
+                    distances[(point2 * numPoints) + i] = distances[(i * numPoints) + point2] = oldRow2[i];
+                }
+            }
+        }
+        return points;
+    }
+
+    //______________________________________________________________________________________________________________
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include <boost/random/mersenne_twister.hpp>
+
+namespace GridGALib
+{
+    enum SpaceFillingDesign
+    {
+        DESIGN_RANDOM,
+        DESIGN_LATIN_HYPERCUBE,
+        DESIGN_SOBOL,
+        DESIGN_MAXIMIN_LATIN_HYPERCUBE,
+        DESIGN_UNKNOWN
+    };
+
+    typedef std::vector<std::vector<double> > DesignPoints;
+
+    // Designs for the initial population, which spread a given number of points more evenly over the unit hypercube
+    // than drawing each coordinate at random. Every point has one coordinate in [0, 1) per dimension, and the caller
+    // maps each coordinate onto one of its parameter's levels.
+    class SpaceFilling
+    {
+    public:
+        static SpaceFillingDesign FromString(const std::string& name);
+        static std::string ToString(SpaceFillingDesign design);
+        static DesignPoints Generate(SpaceFillingDesign design, std::size_t numPoints, std::size_t numDimensions,
+            boost::random::mt19937& random, std::size_t maximinIterations);
+
+        // one point in each of numPoints equal slices of every dimension, the slices paired up at random
+        static DesignPoints LatinHypercube(std::size_t numPoints, std::size_t numDimensions, boost::random::mt19937& random);
+        // Sobol' sequence with a random linear matrix scramble and digital shift for each dimension. Dimensions past
+        // the end of the direction number table are filled as a Latin hypercube.
+        static DesignPoints ScrambledSobol(std::size_t numPoints, std::size_t numDimensions, boost::random::mt19937& random);
+        // a Latin hypercube improved by swapping coordinates between points, keeping the swaps that don't reduce the
+        // smallest distance between any two points
+        static DesignPoints MaximinLatinHypercube(std::size_t numPoints, std::size_t numDimensions, boost::random::mt19937& random,
+            std::size_t numIterations);
+    };
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+// Shared between run_ga and htcondor_job_wrapper. Only header-only code should be added to this file as the wrapper
+// is built from its own Main.cpp.
+
+#include "ResultMessage.hpp"
+
+#include <boost/uuid/detail/sha1.hpp>
+#include <boost/version.hpp>
+
+#include <cstdio>
+#include <string>
+
+namespace GridGALib
+{
+    // Staged files are fetched by the wrapper from run_ga over the results socket, a chunk at a time, and kept in a
+    // cache directory on the execute node named by the SHA-1 of their contents. Integers are little endian.
+    //
+    // Request                                  Reply
+    //  offset  size  field                      offset  size  field
+    //  0       4     magic "GGAF"               0       4     magic "GGAD"
+    //  4       2     protocol version           4       2     status
+    //  6       2     reserved                   6       2     reserved
+    //  8       8     offset into the file       8       8     total size of the file
+    //  16      4     maximum bytes to return    16      ..    file data from the requested offset
+    //  20      40    SHA-1 of the file (hex)
+
+    const char STAGING_REQUEST_MAGIC[4] = { 'G', 'G', 'A', 'F' };
+    const char STAGING_REPLY_MAGIC[4] = { 'G', 'G', 'A', 'D' };
+    const boost::uint16_t STAGING_MESSAGE_VERSION = 1;
+    const std::size_t STAGING_REQUEST_SIZE = 60;
+    const std::size_t STAGING_REPLY_HEADER_SIZE = 16;
+    const std::size_t STAGING_HASH_LENGTH = 40;
+    const boost::uint32_t STAGING_CHUNK_SIZE = 4 * 1024 * 1024;
+
+    enum StagingStatus
+    {
+        STAGING_STATUS_OK = 0,
+        STAGING_STATUS_NOT_FOUND = 1
+    };
+
+    struct StagingRequest
+    {
+        boost::uint64_t mOffset;
+        boost::uint32_t mLength;
+        char mHash[STAGING_HASH_LENGTH + 1];
+    };
+
+    //______________________________________________________________________________________________________________
+
+    inline bool IsStagingRequest(const void* data, std::size_t size)
+    {
+        return (size == STAGING_REQUEST_SIZE) && (std::memcmp(data, STAGING_REQUEST_MAGIC, 4) == 0);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    inline void SerialiseStagingRequest(const StagingRequest& request, char* buffer)
+    {
+        using namespace ResultMessageDetail;
+
+        std::memcpy(buffer, STAGING_REQUEST_MAGIC, 4);
+        Write<boost::uint16_t>(buffer + 4, STAGING_MESSAGE_VERSION);
+        Write<boost::uint16_t>(buffer + 6, 0);
+        Write<boost::uint64_t>(buffer + 8, request.mOffset);
+        Write<boost::uint32_t>(buffer + 16, request.mLength);
+        std::memcpy(buffer + 20, request.mHash, STAGING_HASH_LENGTH);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    inline bool ParseStagingRequest(const void* data, std::size_t size, StagingRequest& request)
+    {
+        using namespace ResultMessageDetail;
+
+        if (!IsStagingRequest(data, size))
+        {
+            return false;
+        }
+
+        const char* buffer = static_cast<const char*>(data);
+        boost::uint16_t version = Read<boost::uint16_t>(buffer + 4);
+        if (version == 0 || version > STAGING_MESSAGE_VERSION)
+        {
+            return false;
+        }
+
+        request.mOffset = Read<boost::uint64_t>(buffer + 8);
+        request.mLength = Read<boost::uint32_t>(buffer + 16);
+        std::memcpy(request.mHash, buffer + 20, STAGING_HASH_LENGTH);
+        request.mHash[STAGING_HASH_LENGTH] = 0;
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    inline void SerialiseStagingReplyHeader(boost::uint16_t status, boost::uint64_t totalSize, char* buffer)
+    {
+        using namespace ResultMessageDetail;
+
+        std::memcpy(buffer, STAGING_REPLY_MAGIC, 4);
+        Write<boost::uint16_t>(buffer + 4, status);
+        Write<boost::uint16_t>(buffer + 6, 0);
+        Write<boost::uint64_t>(buffer + 8, totalSize);
+    }
+
+    //______________________________________________________________________________________________________________
+    // Returns the digest as 40 hex characters
+    inline std::string GetHashString(boost::uuids::detail::sha1& sha1)
+    {
+        char hex[STAGING_HASH_LENGTH + 1];
+#if BOOST_VERSION >= 108600
+        // the digest became a byte array in 1.86
+        boost::uuids::detail::sha1::digest_type digest;
+        sha1.get_digest(digest);
+        for (std::size_t i = 0; i < 20; ++i)
+        {
+            sprintf(hex + (2 * i), "%02x", static_cast<unsigned int>(digest[i]));
+        }
+#else
+        unsigned int digest[5];
+        sha1.get_digest(digest);
+        for (std::size_t i = 0; i < 5; ++i)
+        {
+            sprintf(hex + (8 * i), "%08x", digest[i]);
+        }
+#endif
+        return std::string(hex, STAGING_HASH_LENGTH);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    inline std::string HashData(const char* data, std::size_t size)
+    {
+        boost::uuids::detail::sha1 sha1;
+        sha1.process_bytes(data, size);
+        return GetHashString(sha1);
+    }
+}
@@ -0,0 +1,242 @@
+#include "stdafx.hpp"
+#include "SyntheticObjective.hpp"
+#include "Metrics.hpp"
+
+namespace GridGALib
+{
+    namespace
+    {
+        const double PI = 3.14159265358979323846;
+
+        // maps every parameter's normalised value onto [low, high]
+        std::vector<double> GetDomainValues(const GAParameterMapPtr parameters, double low, double high)
+        {
+            std::vector<double> x;
+            x.reserve(parameters->size());
+            BOOST_FOREACH(const GAParameterMap::value_type& parameter, *parameters)
+            {
+                if (parameter.second->GetHasValue())
+                {
+                    x.push_back(low + (high - low) * parameter.second->GetNormalisedValue());
+                }
+            }
+            return x;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    SyntheticFunction SyntheticObjective::FromString(const std::string& name)
+    {
+        for (boost::int32_t function = SYNTHETIC_RASTRIGIN; function < SYNTHETIC_UNKNOWN; ++function)
+        {
+            if (boost::iequals(name, ToString(static_cast<SyntheticFunction>(function))))
+            {
+                return static_cast<SyntheticFunction>(function);
+            }
+        }
+        return SYNTHETIC_UNKNOWN;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    std::string SyntheticObjective::ToString(SyntheticFunction function)
+    {
+        switch (function)
+        {
+        case SYNTHETIC_RASTRIGIN:
+            return "rastrigin";
+        case SYNTHETIC_ROSENBROCK:
+            return "rosenbrock";
+        case SYNTHETIC_ACKLEY:
+            return "ackley";
+        case SYNTHETIC_TRAP:
+            return "trap";
+        default:
+            return "unknown";
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    double SyntheticObjective::Evaluate(SyntheticFunction function, const GAParameterMapPtr parameters, std::size_t trapSize)
+    {
+        switch (function)
+        {
+        case SYNTHETIC_RASTRIGIN:
+            return -Rastrigin(GetDomainValues(parameters, -5.12, 5.12));
+        case SYNTHETIC_ROSENBROCK:
+        {
+            // shifted by 1, so its minimum at (1, ..., 1) is at the middle of the ranges like the others'
+            std::vector<double> x(GetDomainValues(parameters, -2.048, 2.048));
+            BOOST_FOREACH(double& xi, x)
+            {
+                xi += 1.0;
+            }
+            return -Rosenbrock(x);
+        }
+        case SYNTHETIC_ACKLEY:
+            return -Ackley(GetDomainValues(parameters, -32.768, 32.768));
+        case SYNTHETIC_TRAP:
+            return Trap(GetDomainValues(parameters, 0.0, 1.0), trapSize);
+        default:
+            return 0.0;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    double SyntheticObjective::Rastrigin(const std::vector<double>& x)
+    {
+        double sum = 10.0 * x.size();
+        BOOST_FOREACH(double xi, x)
+        {
+            sum += (xi * xi) - (10.0 * std::cos(2.0 * PI * xi));
+        }
+        return sum;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    double SyntheticObjective::Rosenbrock(const std::vector<double>& x)
+    {
+        double sum = 0.0;
+        for (std::size_t i = 0; i + 1 < x.size(); ++i)
+        {
+            sum += (100.0 * std::pow(x[i + 1] - (x[i] * x[i]), 2)) + std::pow(1.0 - x[i], 2);
+        }
+        return sum;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    double SyntheticObjective::Ackley(const std::vector<double>& x)
+    {
+        if (x.empty())
+        {
+            return 0.0;
+        }
+        double sumSquares = 0.0;
+        double sumCos = 0.0;
+        BOOST_FOREACH(double xi, x)
+        {
+            sumSquares += xi * xi;
+            sumCos += std::cos(2.0 * PI * xi);
+        }
+        return -20.0 * std::exp(-0.2 * std::sqrt(sumSquares / x.size())) - std::exp(sumCos / x.size()) + 20.0 + std::exp(1.0);
+    }
+
+    //______________________________________________________________________________________________________________
+    // Deceptive trap over consecutive blocks of trapSize parameters. u is how far each parameter is towards the top of
+    // its range. A block scores its size when every parameter is at the top, otherwise the score rises as they move
+    // towards the bottom, which leads the search away from the optimum.
+    double SyntheticObjective::Trap(const std::vector<double>& u, std::size_t trapSize)
+    {
+        trapSize = std::max<std::size_t>(trapSize, 1);
+        double sum = 0.0;
+        for (std::size_t first = 0; first < u.size(); first += trapSize)
+        {
+            std::size_t last = std::min(first + trapSize, u.size());
+            double k = static_cast<double>(last - first);
+            double ones = 0.0;
+            for (std::size_t i = first; i < last; ++i)
+            {
+                ones += u[i];
+            }
+            sum += (ones >= k - 1e-9) ? k : std::max(0.0, (k - 1.0) - ones);
+        }
+        return sum;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    SyntheticExecutor::SyntheticExecutor(const std::string& filesLocation)
+    :
+        mFilesLocation(filesLocation),
+        mFunction(SYNTHETIC_RASTRIGIN),
+        mTrapSize(4),
+        mNumEvaluations(0),
+        mBestObjective(-1.0 * std::numeric_limits<double>::max())
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool SyntheticExecutor::ReadConfig(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap)
+    {
+        // rastrigin | rosenbrock | ackley | trap
+        std::string function = CommonLib::GetOptionalParameter<std::string>("config.synthetic.function", pt, "rastrigin");
+        mFunction = SyntheticObjective::FromString(function);
+        if (mFunction == SYNTHETIC_UNKNOWN)
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Unknown synthetic function: " << function;
+            return false;
+        }
+        mTrapSize = CommonLib::GetOptionalParameter<std::size_t>("config.synthetic.trap-size", pt, 4);
+
+        std::string convergenceFile = CommonLib::GetOptionalParameter<std::string>("config.synthetic.convergence-file", pt, "convergence.csv");
+        if (!convergenceFile.empty())
+        {
+            std::string fileName(mFilesLocation + "/" + convergenceFile);
+            mConvergenceFile.open(fileName.c_str());
+            if (!mConvergenceFile)
+            {
+                FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Cannot write " << fileName;
+                return false;
+            }
+            mConvergenceFile << "evaluation,generation,genome_id,objective,best_objective,elapsed_seconds\n";
+        }
+
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Using the synthetic objective " << SyntheticObjective::ToString(mFunction) <<
+            " of " << parameterMap->size() << " parameters.";
+        mStartTime = boost::posix_time::microsec_clock::universal_time();
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool SyntheticExecutor::ExecuteGeneration(GenomeList genomesToTest, GenomeList genomeCache, std::size_t generationNumber)
+    {
+        BOOST_FOREACH(GenomePtr genome, *genomesToTest)
+        {
+            if (genome->IsComplete())
+            {
+                continue;
+            }
+
+            ResultMessage result;
+            result.Clear();
+            result.mGenomeID = genome->GetGenomeID();
+            result.mNumObjectives = 1;
+            result.mObjectives[0] = SyntheticObjective::Evaluate(mFunction, genome->GetParameters(), mTrapSize);
+            result.SetHost("synthetic", 9);
+            genome->Update(result);
+            genomeCache->push_back(genome);
+            Metrics::Instance().Increment(Metrics::RESULTS_RECEIVED);
+
+            ++mNumEvaluations;
+            mBestObjective = std::max(mBestObjective, genome->GetObjective());
+            if (mConvergenceFile.is_open())
+            {
+                boost::posix_time::time_duration elapsed(boost::posix_time::microsec_clock::universal_time() - mStartTime);
+                mConvergenceFile << mNumEvaluations << "," << generationNumber << "," << genome->GetGenomeID() << "," <<
+                    genome->GetObjective() << "," << mBestObjective << "," << (elapsed.total_microseconds() / 1000000.0) << "\n";
+            }
+        }
+        mConvergenceFile.flush();
+
+        std::sort(genomeCache->begin(), genomeCache->end(), CompareGenomeByObjective);
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Generation " << generationNumber << " evaluated. " << mNumEvaluations <<
+            " evaluations, best objective " << mBestObjective;
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    std::vector<GenomePtr> SyntheticExecutor::GetGenomesInFlight(void) const
+    {
+        return std::vector<GenomePtr>();
+    }
+
+    //______________________________________________________________________________________________________________
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include "Executor.hpp"
+
+namespace GridGALib
+{
+    enum SyntheticFunction
+    {
+        SYNTHETIC_RASTRIGIN,
+        SYNTHETIC_ROSENBROCK,
+        SYNTHETIC_ACKLEY,
+        SYNTHETIC_TRAP,
+        SYNTHETIC_UNKNOWN
+    };
+
+    // Standard test functions evaluated directly on a genome, for checking changes to the GA itself. Each parameter
+    // is mapped from its own range onto the function's usual domain, so integer, exp-2 and categorical parameters can
+    // be mixed. The functions are minimisation problems and are negated, as the GA maximises the objective; the best
+    // possible objective is 0 for all but trap, whose best is the number of parameters. The others' best is at
+    // the middle of every parameter's range, which a genome can only reach if each range has an odd number of values.
+    class SyntheticObjective
+    {
+    public:
+        static SyntheticFunction FromString(const std::string& name);
+        static std::string ToString(SyntheticFunction function);
+        static double Evaluate(SyntheticFunction function, const GAParameterMapPtr parameters, std::size_t trapSize);
+    private:
+        static double Rastrigin(const std::vector<double>& x);
+        static double Rosenbrock(const std::vector<double>& x);
+        static double Ackley(const std::vector<double>& x);
+        static double Trap(const std::vector<double>& u, std::size_t trapSize);
+    };
+
+    // execution-type synthetic. Genomes are evaluated in process as soon as they are handed over, and every
+    // evaluation is written to config.synthetic.convergence-file, with the best objective so far and the time since
+    // the run started, so runs can be compared on evaluations and on wall time.
+	class SyntheticExecutor : public Executor
+    {
+    public:
+        SyntheticExecutor(const std::string& filesLocation);
+        bool ReadConfig(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap) override;
+        bool ExecuteGeneration(GenomeList genomesToTest, GenomeList genomeCache, std::size_t generationNumber) override;
+        std::vector<GenomePtr> GetGenomesInFlight(void) const override;
+    private:
+        std::string mFilesLocation;
+        SyntheticFunction mFunction;
+        std::size_t mTrapSize;
+        std::size_t mNumEvaluations;
+        double mBestObjective;
+        boost::posix_time::ptime mStartTime;
+        std::ofstream mConvergenceFile;
+    };
+}
@@ -0,0 +1,233 @@
+#include "stdafx.hpp"
+#include "TraceRecorder.hpp"
+
+namespace GridGALib
+{
+    namespace
+    {
+        // the thread doesn't own its recorder, so nothing is deleted when it exits
+        void KeepTraceRecorder(TraceRecorder*)
+        {
+        }
+
+        boost::thread_specific_ptr<TraceRecorder> ThreadTraceRecorder(&KeepTraceRecorder);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    TraceRecorder& TraceRecorder::Instance(void)
+    {
+        TraceRecorder* threadTraceRecorder = ThreadTraceRecorder.get();
+        if (threadTraceRecorder)
+        {
+            return *threadTraceRecorder;
+        }
+        static TraceRecorder traceRecorder;
+        return traceRecorder;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    TraceRecorder::TraceRecorder(void)
+    :
+        mEnabled(false),
+        mSamplePercent(100),
+        mStartTime(boost::posix_time::microsec_clock::universal_time())
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+
+    TraceRecorder::~TraceRecorder(void)
+    {
+        Close();
+    }
+
+    //______________________________________________________________________________________________________________
+    // samplePercent is the share of genomes that get a track. The master's spans are always recorded.
+    void TraceRecorder::SetFileName(const std::string& fileName, std::size_t samplePercent)
+    {
+        boost::lock_guard<boost::mutex> fileLock(mFileMutex);
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        mFileName = fileName;
+        mSamplePercent = std::min(samplePercent, static_cast<std::size_t>(100));
+        mEvents.reserve(4096);
+
+        if (mFile.is_open())
+        {
+            mFile << "\n]\n";
+            mFile.close();
+        }
+        mFile.open(mFileName.c_str(), std::ios::binary | std::ios::trunc);
+        if (!mFile)
+        {
+            FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "- Cannot write " << mFileName;
+            mEnabled = false;
+            return;
+        }
+
+        mFile << "[\n" <<
+            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << TRACK_GA << ",\"args\":{\"name\":\"run_ga\"}},\n" <<
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << TRACK_GA << ",\"args\":{\"name\":\"GA\"}},\n" <<
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << TRACK_SUBMIT << ",\"args\":{\"name\":\"Submit\"}}";
+        mFile.flush();
+        mEnabled = true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool TraceRecorder::IsEnabled(void) const
+    {
+        return mEnabled;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    boost::int64_t TraceRecorder::ToMicroseconds(const boost::posix_time::ptime& time) const
+    {
+        return (time - mStartTime).total_microseconds();
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void TraceRecorder::AddSpan(const char* name, boost::uint64_t track, const boost::posix_time::ptime& start,
+        const boost::posix_time::ptime& end)
+    {
+        if (!mEnabled)
+        {
+            return;
+        }
+
+        TraceEvent event = { name, track, ToMicroseconds(start), (end - start).total_microseconds(), "", true };
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        mEvents.push_back(event);
+    }
+
+    //______________________________________________________________________________________________________________
+    // Sampled by genome id, so the choice costs nothing and a genome is either traced or not
+    void TraceRecorder::AddGenomeSpan(std::size_t genomeID, const boost::posix_time::ptime& submitTime, const std::string& host,
+        bool succeeded)
+    {
+        if (!mEnabled || submitTime.is_not_a_date_time() || (genomeID % 100) >= mSamplePercent)
+        {
+            return;
+        }
+
+        boost::posix_time::ptime now(boost::posix_time::microsec_clock::universal_time());
+        TraceEvent event = { "", TRACK_GENOMES + genomeID, ToMicroseconds(submitTime), (now - submitTime).total_microseconds(),
+            host, succeeded };
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        mEvents.push_back(event);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void TraceRecorder::Write(void)
+    {
+        if (!mEnabled)
+        {
+            return;
+        }
+
+        boost::lock_guard<boost::mutex> fileLock(mFileMutex);
+        std::vector<TraceEvent> events;
+        {
+            boost::lock_guard<boost::mutex> lock(mMutex);
+            events.swap(mEvents);
+            mEvents.reserve(events.size());
+        }
+        if (!mFile.is_open())
+        {
+            return;
+        }
+
+        std::ostringstream s;
+        BOOST_FOREACH(const TraceEvent& event, events)
+        {
+            s << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << event.mTrack << ",\"ts\":" << event.mStart << ",\"dur\":" << event.mDuration;
+            if (event.mTrack < TRACK_GENOMES)
+            {
+                s << ",\"name\":\"" << event.mName << "\"}";
+                continue;
+            }
+
+            std::size_t genomeID = static_cast<std::size_t>(event.mTrack - TRACK_GENOMES);
+            std::string host(event.mHost);
+            boost::replace_all(host, "\\", "\\\\");
+            boost::replace_all(host, "\"", "\\\"");
+            s << ",\"name\":\"genome " << genomeID << "\",\"args\":{\"host\":\"" << host << "\",\"status\":\"" <<
+                (event.mSucceeded ? "ok" : "error") << "\"}},\n" <<
+                "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << event.mTrack << ",\"args\":{\"name\":\"genome " << genomeID << "\"}}";
+        }
+
+        mFile << s.str();
+        mFile.flush();
+        if (!mFile)
+        {
+            FILE_LOG(logWARNING) << __FUNCTION_NAME__ << "- Cannot write " << mFileName;
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void TraceRecorder::Close(void)
+    {
+        Write();
+
+        boost::lock_guard<boost::mutex> fileLock(mFileMutex);
+        mEnabled = false;
+        if (mFile.is_open())
+        {
+            mFile << "\n]\n";
+            mFile.close();
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ScopedTraceInstance::ScopedTraceInstance(TraceRecorder* traceRecorder)
+    :
+        mPrevious(ThreadTraceRecorder.get()),
+        mSet(traceRecorder != NULL)
+    {
+        if (mSet)
+        {
+            ThreadTraceRecorder.reset(traceRecorder);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ScopedTraceInstance::~ScopedTraceInstance(void)
+    {
+        if (mSet)
+        {
+            ThreadTraceRecorder.reset(mPrevious);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ScopedTraceSpan::ScopedTraceSpan(const char* name, boost::uint64_t track)
+    :
+        mName(name),
+        mTrack(track)
+    {
+        if (TraceRecorder::Instance().IsEnabled())
+        {
+            mStart = boost::posix_time::microsec_clock::universal_time();
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    ScopedTraceSpan::~ScopedTraceSpan(void)
+    {
+        if (!mStart.is_not_a_date_time())
+        {
+            TraceRecorder::Instance().AddSpan(mName, mTrack, mStart, boost::posix_time::microsec_clock::universal_time());
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+namespace GridGALib
+{
+    // Records a timeline of the run in the Chrome trace_event JSON format, which can be opened in Perfetto or
+    // chrome://tracing. The master's phases are spans on the GA and submit threads' tracks, and every sampled genome
+    // gets a track of its own spanning submit to result. Events are kept in memory until the end of the generation
+    // and then appended to the file set by config.genetic-algo.trace-file. The file is in the JSON array format, whose
+    // closing bracket is optional, so it can be opened while the run is still going. Nothing is recorded if the file
+    // isn't set. There's one for the process, but run_ga --experiments gives every experiment its own, see
+    // ScopedTraceInstance.
+	class TraceRecorder : boost::noncopyable
+    {
+    public:
+        enum Track
+        {
+            TRACK_GA = 1,
+            TRACK_SUBMIT = 2,
+            // genome tracks are numbered from here by genome id
+            TRACK_GENOMES = 1000
+        };
+
+        TraceRecorder(void);
+        ~TraceRecorder(void);
+        // the process's, or the one set on this thread by ScopedTraceInstance
+        static TraceRecorder& Instance(void);
+
+        void SetFileName(const std::string& fileName, std::size_t samplePercent);
+        bool IsEnabled(void) const;
+        void AddSpan(const char* name, boost::uint64_t track, const boost::posix_time::ptime& start,
+            const boost::posix_time::ptime& end);
+        void AddGenomeSpan(std::size_t genomeID, const boost::posix_time::ptime& submitTime, const std::string& host,
+            bool succeeded);
+        // appends the events recorded since the last call to the file
+        void Write(void);
+        // writes what's left and closes the JSON array
+        void Close(void);
+    private:
+        struct TraceEvent
+        {
+            // a literal, or empty for a genome span
+            const char* mName;
+            boost::uint64_t mTrack;
+            boost::int64_t mStart;
+            boost::int64_t mDuration;
+            std::string mHost;
+            bool mSucceeded;
+        };
+
+        boost::int64_t ToMicroseconds(const boost::posix_time::ptime& time) const;
+
+        // guards mEvents, taken for no longer than it takes to add an event or swap the vector
+        boost::mutex mMutex;
+        // guards the file, so generations finishing together append their events in turn
+        boost::mutex mFileMutex;
+        boost::atomic<bool> mEnabled;
+        std::string mFileName;
+        std::ofstream mFile;
+        std::size_t mSamplePercent;
+        boost::posix_time::ptime mStartTime;
+        std::vector<TraceEvent> mEvents;
+    };
+
+    // Makes TraceRecorder::Instance() return the given recorder on this thread for as long as it is in scope. A null
+    // pointer leaves it as it was.
+    class ScopedTraceInstance : boost::noncopyable
+    {
+    public:
+        explicit ScopedTraceInstance(TraceRecorder* traceRecorder);
+        ~ScopedTraceInstance(void);
+    private:
+        TraceRecorder* mPrevious;
+        bool mSet;
+    };
+
+    // Records a span on the given track for as long as it is in scope
+    class ScopedTraceSpan : boost::noncopyable
+    {
+    public:
+        ScopedTraceSpan(const char* name, boost::uint64_t track);
+        ~ScopedTraceSpan(void);
+    private:
+        const char* mName;
+        boost::uint64_t mTrack;
+        boost::posix_time::ptime mStart;
+    };
+}
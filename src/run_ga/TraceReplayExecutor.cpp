@@ -0,0 +1,284 @@
+#include "stdafx.hpp"
+#include "TraceReplayExecutor.hpp"
+
+namespace GridGALib
+{
+    namespace
+    {
+        GenomeParameterPtr CopyParameter(GenomeParameterPtr parameter)
+        {
+            if (parameter->GetParameterType() == PARAMETER_TYPE_EXP_2)
+            {
+                return GetGenomeParameterCopy<GenomeParameterExp2>(parameter);
+            }
+            else if (parameter->GetParameterType() == PARAMETER_TYPE_CATEGORICAL)
+            {
+                return GetGenomeParameterCopy<GenomeParameterCategorical>(parameter);
+            }
+            return GetGenomeParameterCopy<GenomeParameterContinuous>(parameter);
+        }
+    }
+
+    //______________________________________________________________________________________________________________
+
+    TraceReplayExecutor::TraceReplayExecutor(const std::string& filesLocation)
+    :
+        SimulatedExecutor(filesLocation),
+        mFilesLocation(filesLocation),
+        mUseNearest(true),
+        mNumNeighbours(1),
+        mNumExact(0),
+        mNumNearest(0),
+        mNumRejected(0)
+    {
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool TraceReplayExecutor::ReadConfig(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap)
+    {
+        if (!SimulatedExecutor::ReadConfig(pt, parameterMap))
+        {
+            return false;
+        }
+        mParameterMap = parameterMap;
+
+        // nearest | reject
+        std::string fallback = CommonLib::GetOptionalParameter<std::string>("config.trace-replay.fallback", pt, "nearest");
+        if (!boost::iequals(fallback, "nearest") && !boost::iequals(fallback, "reject"))
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Unknown trace-replay fallback: " << fallback;
+            return false;
+        }
+        mUseNearest = boost::iequals(fallback, "nearest");
+        mNumNeighbours = std::max<std::size_t>(CommonLib::GetOptionalParameter<std::size_t>("config.trace-replay.neighbours", pt, 1), 1);
+
+        if (pt.get_child_optional("config.trace-replay"))
+        {
+            BOOST_FOREACH(const boost::property_tree::ptree::value_type& item, pt.get_child("config.trace-replay"))
+            {
+                if (boost::iequals(item.first, "trace-file"))
+                {
+                    std::string fileName(item.second.data());
+                    if (!boost::filesystem::path(fileName).is_absolute())
+                    {
+                        fileName = mFilesLocation + "/" + fileName;
+                    }
+                    if (!LoadTrace(fileName))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        if (mEntries.empty())
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "No evaluations to replay. Please check the entries config.trace-replay.trace-file in the config.";
+            return false;
+        }
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Replaying " << mEntries.size() << " evaluations, falling back to " << fallback << ".";
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+    // Genomes that never completed, or were recorded without one of this run's parameters, are skipped. Where the same
+    // genome appears more than once the first is used.
+
+    bool TraceReplayExecutor::LoadTrace(const std::string& fileName)
+    {
+        if (!boost::filesystem::exists(fileName))
+        {
+            FILE_LOG(logERROR) << __FUNCTION_NAME__ << "Cannot find the trace " << fileName;
+            return false;
+        }
+
+        boost::property_tree::ptree cachePt;
+        boost::property_tree::xml_parser::read_xml(fileName, cachePt);
+
+        // used to map each recorded value onto its parameter's range
+        std::vector<GenomeParameterPtr> parameters;
+        BOOST_FOREACH(const GAParameterMap::value_type& parameter, *mParameterMap)
+        {
+            parameters.push_back(CopyParameter(parameter.second));
+        }
+
+        std::size_t numLoaded = 0;
+        std::size_t numSkipped = 0;
+        BOOST_FOREACH(const boost::property_tree::ptree::value_type& item, cachePt.get_child("state", boost::property_tree::ptree()))
+        {
+            if (item.first.compare("genome") != 0)
+            {
+                continue;
+            }
+            if (!CommonLib::GetOptionalBoolParameter("complete", item.second, false))
+            {
+                ++numSkipped;
+                continue;
+            }
+
+            TraceEntry entry;
+            std::vector<boost::int32_t> internalValues;
+            BOOST_FOREACH(GenomeParameterPtr parameter, parameters)
+            {
+                boost::optional<boost::int32_t> value = item.second.get_optional<boost::int32_t>(parameter->GetIdentifier());
+                if (!value)
+                {
+                    break;
+                }
+                parameter->SetInternalValue(*value);
+                internalValues.push_back(parameter->InternalValue());
+                entry.mNormalisedValues.push_back(parameter->GetNormalisedValue());
+            }
+            if (internalValues.size() != parameters.size())
+            {
+                ++numSkipped;
+                continue;
+            }
+
+            entry.mObjective = item.second.get("objective", 0.0);
+            // older caches don't have the runtime, which is then drawn from the simulation's distribution
+            double executeMs = item.second.get("execute-ms", 0.0);
+            entry.mRuntimeSeconds = (executeMs > 0.0) ? executeMs / 1000.0 : -1.0;
+            entry.mHost = item.second.get("compute-host", "trace");
+            if (mExactMatches.insert(std::make_pair(internalValues, mEntries.size())).second)
+            {
+                mEntries.push_back(entry);
+                ++numLoaded;
+            }
+        }
+
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Loaded " << numLoaded << " evaluations from " << fileName << ", skipped " << numSkipped << ".";
+        return true;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    bool TraceReplayExecutor::ExecuteGeneration(GenomeList genomesToTest, GenomeList genomeCache, std::size_t generationNumber)
+    {
+        bool ok = SimulatedExecutor::ExecuteGeneration(genomesToTest, genomeCache, generationNumber);
+        FILE_LOG(logINFO) << __FUNCTION_NAME__ << "Trace matches so far: " << mNumExact << " exact, " << mNumNearest << " nearest, " <<
+            mNumRejected << " rejected.";
+        return ok;
+    }
+
+    //______________________________________________________________________________________________________________
+
+    double TraceReplayExecutor::GetRuntimeSeconds(const GenomePtr genome)
+    {
+        const TraceMatch& match = GetMatch(genome);
+        if (!match.mFound)
+        {
+            // fails as soon as it starts
+            return 0.0;
+        }
+        return (match.mRuntimeSeconds >= 0.0) ? match.mRuntimeSeconds : SimulatedExecutor::GetRuntimeSeconds(genome);
+    }
+
+    //______________________________________________________________________________________________________________
+
+    void TraceReplayExecutor::Evaluate(const GenomePtr genome, ResultMessage& result)
+    {
+        const TraceMatch& match = GetMatch(genome);
+        if (!match.mFound)
+        {
+            std::string error("not in the trace");
+            result.mStatus = RESULT_STATUS_ERROR;
+            result.SetError(error.c_str(), error.size());
+            result.SetHost("trace-replay", 12);
+            return;
+        }
+        result.mNumObjectives = 1;
+        result.mObjectives[0] = match.mObjective;
+        result.SetHost(match.mHost.c_str(), match.mHost.size());
+    }
+
+    //______________________________________________________________________________________________________________
+
+    const TraceReplayExecutor::TraceMatch& TraceReplayExecutor::GetMatch(const GenomePtr genome)
+    {
+        boost::unordered_map<std::size_t, TraceMatch>::const_iterator itr = mMatches.find(genome->GetGenomeID());
+        if (itr != mMatches.end())
+        {
+            return itr->second;
+        }
+
+        TraceMatch& match = mMatches[genome->GetGenomeID()];
+        match.mFound = false;
+        match.mObjective = 0.0;
+        match.mRuntimeSeconds = -1.0;
+
+        std::vector<boost::int32_t> internalValues;
+        std::vector<double> normalisedValues;
+        BOOST_FOREACH(const GAParameterMap::value_type& parameter, *mParameterMap)
+        {
+            internalValues.push_back(genome->GetInternalParameterValue(parameter.first));
+            GAParameterMap::const_iterator genomeParameter = genome->GetParameters()->find(parameter.first);
+            normalisedValues.push_back(genomeParameter != genome->GetParameters()->end() ? genomeParameter->second->GetNormalisedValue() : 0.0);
+        }
+
+        std::map<std::vector<boost::int32_t>, std::size_t>::const_iterator exact = mExactMatches.find(internalValues);
+        if (exact != mExactMatches.end())
+        {
+            const TraceEntry& entry = mEntries[exact->second];
+            match.mFound = true;
+            match.mObjective = entry.mObjective;
+            match.mRuntimeSeconds = entry.mRuntimeSeconds;
+            match.mHost = entry.mHost;
+            ++mNumExact;
+            return match;
+        }
+
+        if (!mUseNearest)
+        {
+            FILE_LOG(logDEBUG) << __FUNCTION_NAME__ << "Genome[" << genome->GetGenomeID() << "] is not in the trace.";
+            ++mNumRejected;
+            return match;
+        }
+
+        // squared distance -> entry, only the closest mNumNeighbours are kept
+        std::multimap<double, std::size_t> nearest;
+        for (std::size_t i = 0; i < mEntries.size(); ++i)
+        {
+            double distance = 0.0;
+            for (std::size_t j = 0; j < normalisedValues.size(); ++j)
+            {
+                double difference = normalisedValues[j] - mEntries[i].mNormalisedValues[j];
+                distance += difference * difference;
+            }
+            if (nearest.size() < mNumNeighbours || distance < nearest.rbegin()->first)
+            {
+                nearest.insert(std::make_pair(distance, i));
+                if (nearest.size() > mNumNeighbours)
+                {
+                    nearest.erase(--nearest.end());
+                }
+            }
+        }
+
+        double sumWeights = 0.0;
+        double sumObjective = 0.0;
+        double sumRuntimeWeights = 0.0;
+        double sumRuntime = 0.0;
+        for (std::multimap<double, std::size_t>::const_iterator neighbour = nearest.begin(); neighbour != nearest.end(); ++neighbour)
+        {
+            const TraceEntry& entry = mEntries[neighbour->second];
+            double weight = 1.0 / std::max(std::sqrt(neighbour->first), 1e-9);
+            sumWeights += weight;
+            sumObjective += weight * entry.mObjective;
+            if (entry.mRuntimeSeconds >= 0.0)
+            {
+                sumRuntimeWeights += weight;
+                sumRuntime += weight * entry.mRuntimeSeconds;
+            }
+        }
+        match.mFound = true;
+        match.mObjective = sumObjective / sumWeights;
+        match.mRuntimeSeconds = (sumRuntimeWeights > 0.0) ? sumRuntime / sumRuntimeWeights : -1.0;
+        match.mHost = mEntries[nearest.begin()->second].mHost;
+        ++mNumNearest;
+        return match;
+    }
+
+    //______________________________________________________________________________________________________________
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "stdafx.hpp"
+
+#include "SimulatedExecutor.hpp"
+
+namespace GridGALib
+{
+    // execution-type trace-replay. The simulated pool of SimulatedExecutor, with each genome's objective, runtime and
+    // host taken from the evaluations recorded by earlier runs, i.e. their genetic-algo-cache.xml files, instead of
+    // from a synthetic function. GA settings can then be tuned by replaying a real run many times in simulated time.
+    //
+    // A genome that isn't in the trace is either given the objective and runtime of its nearest neighbours in the
+    // trace, weighted by inverse distance over the parameters' normalised values, or fails as a job would that never
+    // returned a result. config.trace-replay:
+    //   <trace-file>    one or more caches, relative to the run's directory unless absolute
+    //   <fallback>      nearest | reject
+    //   <neighbours>    number of neighbours averaged by nearest
+	class TraceReplayExecutor : public SimulatedExecutor
+    {
+    public:
+        TraceReplayExecutor(const std::string& filesLocation);
+        bool ReadConfig(boost::property_tree::ptree& pt, const GAParameterMapPtr parameterMap) override;
+        bool ExecuteGeneration(GenomeList genomesToTest, GenomeList genomeCache, std::size_t generationNumber) override;
+    protected:
+        double GetRuntimeSeconds(const GenomePtr genome) override;
+        void Evaluate(const GenomePtr genome, ResultMessage& result) override;
+    private:
+        struct TraceEntry
+        {
+            std::vector<double> mNormalisedValues;
+            double mObjective;
+            double mRuntimeSeconds;
+            std::string mHost;
+        };
+
+        // what a genome was given, worked out once as it's needed at the start and end of every job
+        struct TraceMatch
+        {
+            bool mFound;
+            double mObjective;
+            double mRuntimeSeconds;
+            std::string mHost;
+        };
+
+        std::string mFilesLocation;
+        GAParameterMapPtr mParameterMap;
+        bool mUseNearest;
+        std::size_t mNumNeighbours;
+        std::vector<TraceEntry> mEntries;
+        // internal values in parameter order -> index into mEntries
+        std::map<std::vector<boost::int32_t>, std::size_t> mExactMatches;
+        boost::unordered_map<std::size_t, TraceMatch> mMatches;
+        std::size_t mNumExact;
+        std::size_t mNumNearest;
+        std::size_t mNumRejected;
+
+        bool LoadTrace(const std::string& fileName);
+        const TraceMatch& GetMatch(const GenomePtr genome);
+    };
+}
@@ -30,9 +30,8 @@
 
 namespace CommonLib
 {
-    inline double StringToDouble(std::string& inStr) 
+    inline double StringToDouble(const char* p) 
     {
-        const char *p = inStr.c_str();
         double r = 0.0;
         bool neg = false;
         if (*p == '-') {
@@ -54,6 +53,20 @@ namespace CommonLib
             }
             r += f / std::pow(10.0, n);
         }
+        if (*p == 'e' || *p == 'E') {
+            int e = 0;
+            bool negExp = false;
+            ++p;
+            if (*p == '-' || *p == '+') {
+                negExp = (*p == '-');
+                ++p;
+            }
+            while (*p >= '0' && *p <= '9') {
+                e = (e*10) + (*p - '0');
+                ++p;
+            }
+            r *= std::pow(10.0, negExp ? -e : e);
+        }
         if (neg) {
             r = -r;
         }
@@ -61,6 +74,12 @@ namespace CommonLib
     }
 
 
+    inline double StringToDouble(std::string& inStr) 
+    {
+        return StringToDouble(inStr.c_str());
+    }
+
+
     // from http://tinodidriksen.com/uploads/code/cpp/speed-string-to-int.cpp
     inline boost::int32_t StringToInt(std::string& inStr)
     {
@@ -111,6 +130,25 @@ namespace CommonLib
         return p.parent_path().string();
     }
 
+    inline std::string EscapeXML(const std::string& text)
+    {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (std::size_t i = 0; i < text.size(); ++i)
+        {
+            switch (text[i])
+            {
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '&': escaped += "&amp;"; break;
+            case '\'': escaped += "&apos;"; break;
+            case '"': escaped += "&quot;"; break;
+            default: escaped += text[i]; break;
+            }
+        }
+        return escaped;
+    }
+
     inline std::string GetConfigFileNameIfExists(std::string filesLocation)
     {
         std::string configFileName = filesLocation + "/_config.xml";